@@ -0,0 +1,92 @@
+#include "src/core/AudioKernels.h"
+#include "src/core/Logger.h"
+#include <chrono>
+#include <random>
+#include <vector>
+
+// Micro-benchmark for the device callback's interleave/deinterleave kernels against the
+// scalar reference, at typical callback sizes. Also checks both produce identical output.
+
+struct ChannelBuffers {
+    ChannelBuffers(int numChannels, int numFrames)
+        : storage(static_cast<size_t>(numChannels), std::vector<float>(static_cast<size_t>(numFrames))) {
+        for (auto& channel : storage) pointers.push_back(channel.data());
+    }
+
+    std::vector<std::vector<float>> storage;
+    std::vector<float*> pointers;
+};
+
+template <typename Function>
+static double nanosecondsPerCall(int iterations, Function&& function) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        function();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+int main() {
+    Logger::initialize();
+    Logger::info("=== Interleave Kernel Benchmark ===");
+#if defined(AUDIO_KERNELS_AVX2)
+    Logger::info("Kernels: AVX2");
+#elif defined(AUDIO_KERNELS_SSE)
+    Logger::info("Kernels: SSE (configure with -DAUDIO_KERNELS_AVX2=ON for the AVX2 variant)");
+#elif defined(AUDIO_KERNELS_NEON)
+    Logger::info("Kernels: NEON");
+#else
+    Logger::info("Kernels: scalar");
+#endif
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    bool allMatch = true;
+
+    for (int numFrames : { 32, 64, 256 }) {
+        for (int numChannels : { 1, 2, 4, 8, 16, 6, 3 }) {
+            ChannelBuffers separate(numChannels, numFrames);
+            ChannelBuffers separateReference(numChannels, numFrames);
+            std::vector<float> interleaved(static_cast<size_t>(numChannels) * numFrames);
+            std::vector<float> interleavedReference(interleaved.size());
+
+            for (auto& channel : separate.storage) {
+                for (auto& sample : channel) sample = distribution(random);
+            }
+
+            // Correctness: both directions must match the scalar reference exactly
+            AudioKernels::interleave(separate.pointers.data(), interleaved.data(), numChannels, numFrames);
+            AudioKernels::interleaveScalar(separate.pointers.data(), interleavedReference.data(), numChannels, numFrames);
+            AudioKernels::deinterleave(interleaved.data(), separateReference.pointers.data(), numChannels, numFrames);
+            bool match = interleaved == interleavedReference && separate.storage == separateReference.storage;
+            allMatch = allMatch && match;
+
+            // Enough iterations for roughly 20M samples per measurement
+            int iterations = std::max(1000, 20'000'000 / (numChannels * numFrames));
+            const float* const* source = separate.pointers.data();
+
+            double scalarInterleave = nanosecondsPerCall(iterations, [&] {
+                AudioKernels::interleaveScalar(source, interleaved.data(), numChannels, numFrames);
+            });
+            double simdInterleave = nanosecondsPerCall(iterations, [&] {
+                AudioKernels::interleave(source, interleaved.data(), numChannels, numFrames);
+            });
+            double scalarDeinterleave = nanosecondsPerCall(iterations, [&] {
+                AudioKernels::deinterleaveScalar(interleaved.data(), separate.pointers.data(), numChannels, numFrames);
+            });
+            double simdDeinterleave = nanosecondsPerCall(iterations, [&] {
+                AudioKernels::deinterleave(interleaved.data(), separate.pointers.data(), numChannels, numFrames);
+            });
+
+            Logger::info("{:3} frames x {:2} ch | interleave {:7.1f} ns -> {:7.1f} ns ({:4.1f}x) | deinterleave {:7.1f} ns -> {:7.1f} ns ({:4.1f}x){}",
+                         numFrames, numChannels,
+                         scalarInterleave, simdInterleave, scalarInterleave / simdInterleave,
+                         scalarDeinterleave, simdDeinterleave, scalarDeinterleave / simdDeinterleave,
+                         match ? "" : "  MISMATCH");
+        }
+    }
+
+    Logger::info("=== Interleave Kernel Benchmark Complete ===");
+    return allMatch ? 0 : 1;
+}
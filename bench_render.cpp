@@ -0,0 +1,237 @@
+#include "src/core/AudioGraph.h"
+#include "src/core/OscillatorNode.h"
+#include "src/core/GainNode.h"
+#include "src/core/AnalyzerNode.h"
+#include "src/core/PolyphonicSampler.h"
+#include "src/core/Logger.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+
+// Render throughput benchmark: builds synthetic graphs, runs them through AudioGraphProcessor
+// as fast as possible (no audio device) and writes the results as JSON for comparing commits.
+//
+//   bench_render [--workers N] [--block FRAMES] [--seconds S] [--output FILE] [--label TEXT]
+
+// Every heap allocation in the process is counted, so the timed loop's share can be reported
+static std::atomic<uint64_t> allocationCount{0};
+static std::atomic<uint64_t> allocatedBytes{0};
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+
+struct BenchmarkOptions {
+    int workers = 0;
+    int blockSize = 256;
+    double seconds = 20.0;  // Audio rendered per scenario
+    double sampleRate = 48000.0;
+    std::string outputPath = "bench_render.json";
+    std::string label;
+};
+
+struct BenchmarkResult {
+    std::string name;
+    int nodes = 0;
+    uint64_t samples = 0;
+    double wallSeconds = 0.0;
+    double realtimeFactor = 0.0;
+    double nsPerSamplePerNode = 0.0;
+    uint64_t allocations = 0;
+    uint64_t allocatedBytes = 0;
+};
+
+static BenchmarkResult runScenario(const std::string& name, const BenchmarkOptions& options,
+                                   const std::function<void(AudioGraph&)>& buildGraph) {
+    AudioGraph graph;
+    graph.setParallelProcessing(options.workers > 0);
+    buildGraph(graph);
+    graph.prepare({ options.sampleRate, options.blockSize, 2 });
+
+    AudioGraphProcessor processor;
+    processor.setNumWorkerThreads(options.workers);
+    auto compiled = graph.getCompiledGraph();
+    processor.setCompiledGraph(compiled);
+
+    choc::buffer::ChannelArrayBuffer<float> input(0, static_cast<choc::buffer::FrameCount>(options.blockSize));
+    choc::buffer::ChannelArrayBuffer<float> output(2, static_cast<choc::buffer::FrameCount>(options.blockSize));
+
+    auto renderBlock = [&] {
+        processor.processGraph(input.getView(), output.getView(), options.sampleRate, options.blockSize);
+    };
+
+    // Warm up so first-use allocations and cold caches stay out of the measurement
+    for (int block = 0; block < 32; ++block) {
+        renderBlock();
+    }
+
+    auto numBlocks = static_cast<uint64_t>(options.seconds * options.sampleRate / options.blockSize);
+    uint64_t allocationsBefore = allocationCount.load();
+    uint64_t bytesBefore = allocatedBytes.load();
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint64_t block = 0; block < numBlocks; ++block) {
+        renderBlock();
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    BenchmarkResult result;
+    result.name = name;
+    result.nodes = static_cast<int>(compiled->instructions.size());
+    result.samples = numBlocks * static_cast<uint64_t>(options.blockSize);
+    result.wallSeconds = elapsed.count();
+    result.realtimeFactor = (static_cast<double>(result.samples) / options.sampleRate) / result.wallSeconds;
+    result.nsPerSamplePerNode = elapsed.count() * 1e9 / (static_cast<double>(result.samples) * std::max(result.nodes, 1));
+    result.allocations = allocationCount.load() - allocationsBefore;
+    result.allocatedBytes = allocatedBytes.load() - bytesBefore;
+    return result;
+}
+
+// N oscillators, each through its own gain, summed on one bus
+static void buildOscillatorBus(AudioGraph& graph, int numOscillators) {
+    auto transaction = graph.beginTransaction();
+    auto bus = std::make_shared<GainNode>(1.0f / numOscillators, "Bus");
+    for (int i = 0; i < numOscillators; ++i) {
+        auto oscillator = std::make_shared<OscillatorNode>(110.0f + 10.0f * i, OscillatorNode::WaveType::Sawtooth);
+        auto gain = std::make_shared<GainNode>(0.5f);
+        transaction.connectNodes(oscillator, gain);
+        transaction.connectNodes(gain, bus);
+    }
+    transaction.addOutputNode(bus);
+    graph.commitTransaction(transaction);
+}
+
+// One sampler with every voice held on a looping synthetic sample
+static void buildSampler(AudioGraph& graph, int numVoices) {
+    constexpr int sampleFrames = 48000;
+    choc::buffer::ChannelArrayBuffer<float> sample(2, sampleFrames);
+    for (int frame = 0; frame < sampleFrames; ++frame) {
+        float value = std::sin(2.0f * 3.14159265f * 220.0f * frame / 48000.0f);
+        sample.getSample(0, static_cast<choc::buffer::FrameCount>(frame)) = value;
+        sample.getSample(1, static_cast<choc::buffer::FrameCount>(frame)) = value;
+    }
+
+    auto sampler = std::make_shared<PolyphonicSampler>("Sampler", numVoices);
+    sampler->loadSample(sample, 48000.0);
+    sampler->setLoop(true);
+    for (int voice = 0; voice < numVoices; ++voice) {
+        sampler->noteOn(36 + voice, 100);
+    }
+
+    auto gain = std::make_shared<GainNode>(0.1f);
+    graph.connectNodes(sampler, gain);
+    graph.addOutputNode(gain);
+}
+
+// Oscillators each feeding a chain of gain -> analyzer stages
+static void buildAnalyzerChains(AudioGraph& graph, int numChains, int chainLength) {
+    auto transaction = graph.beginTransaction();
+    auto bus = std::make_shared<GainNode>(1.0f / numChains, "Bus");
+    for (int chain = 0; chain < numChains; ++chain) {
+        std::shared_ptr<AudioNode> previous = std::make_shared<OscillatorNode>(220.0f + chain);
+        for (int stage = 0; stage < chainLength; ++stage) {
+            auto gain = std::make_shared<GainNode>(0.9f);
+            auto analyzer = std::make_shared<AnalyzerNode>("Analyzer", 1024);
+            transaction.connectNodes(previous, gain);
+            transaction.connectNodes(gain, analyzer);
+            previous = analyzer;
+        }
+        transaction.connectNodes(previous, bus);
+    }
+    transaction.addOutputNode(bus);
+    graph.commitTransaction(transaction);
+}
+
+static std::string escapeJson(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+static bool writeJson(const BenchmarkOptions& options, const std::vector<BenchmarkResult>& results) {
+    std::ofstream file(options.outputPath);
+    if (!file) {
+        Logger::error("Cannot write benchmark results to {}", options.outputPath);
+        return false;
+    }
+
+    file << "{\n";
+    file << fmt::format("  \"label\": \"{}\",\n", escapeJson(options.label));
+    file << fmt::format("  \"sampleRate\": {},\n  \"blockSize\": {},\n  \"workers\": {},\n",
+                        options.sampleRate, options.blockSize, options.workers);
+    file << "  \"scenarios\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& result = results[i];
+        file << fmt::format("    {{ \"name\": \"{}\", \"nodes\": {}, \"samples\": {}, \"wallSeconds\": {:.6f}, "
+                            "\"realtimeFactor\": {:.3f}, \"nsPerSamplePerNode\": {:.4f}, "
+                            "\"allocations\": {}, \"allocatedBytes\": {} }}{}\n",
+                            escapeJson(result.name), result.nodes, result.samples, result.wallSeconds,
+                            result.realtimeFactor, result.nsPerSamplePerNode,
+                            result.allocations, result.allocatedBytes, i + 1 < results.size() ? "," : "");
+    }
+    file << "  ]\n}\n";
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Logger::initialize();
+
+    BenchmarkOptions options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        std::string value = argv[i + 1];
+        if (option == "--workers") options.workers = std::stoi(value);
+        else if (option == "--block") options.blockSize = std::stoi(value);
+        else if (option == "--seconds") options.seconds = std::stod(value);
+        else if (option == "--output") options.outputPath = value;
+        else if (option == "--label") options.label = value;
+        else Logger::warn("Unknown option {}", option);
+    }
+
+    Logger::info("=== Render Benchmark ({} workers, {} frame blocks) ===", options.workers, options.blockSize);
+
+    // Node construction logs a lot; keep the report readable
+    Logger::setLevel(spdlog::level::warn);
+
+    std::vector<BenchmarkResult> results;
+    for (int numOscillators : { 16, 64, 256 }) {
+        results.push_back(runScenario("oscillator_bus_" + std::to_string(numOscillators), options,
+                                      [=](AudioGraph& graph) { buildOscillatorBus(graph, numOscillators); }));
+    }
+    for (int numVoices : { 8, 32 }) {
+        results.push_back(runScenario("sampler_voices_" + std::to_string(numVoices), options,
+                                      [=](AudioGraph& graph) { buildSampler(graph, numVoices); }));
+    }
+    results.push_back(runScenario("analyzer_chains_8x4", options,
+                                  [](AudioGraph& graph) { buildAnalyzerChains(graph, 8, 4); }));
+
+    Logger::setLevel(spdlog::level::info);
+    for (const auto& result : results) {
+        Logger::info("{:22} {:4} nodes | {:8.1f}x realtime | {:7.2f} ns/sample/node | {} allocations",
+                     result.name, result.nodes, result.realtimeFactor, result.nsPerSamplePerNode, result.allocations);
+    }
+
+    if (!writeJson(options, results)) {
+        return 1;
+    }
+    Logger::info("Results written to {}", options.outputPath);
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include "src/core/SamplePlayerNode.h"
+#include "src/core/Logger.h"
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+// Offline benchmark for SamplePlayerNode's interpolation modes: render cost per output frame
+// relative to CUBIC at a range of playback rates, and how much of an out-of-band tone
+// aliases back into the output, to help choose a mode per instrument.
+
+using InterpolationMode = SamplePlayerNode::InterpolationMode;
+
+constexpr double sampleRate = 48000.0;
+constexpr int blockSize = 256;
+constexpr int numVoices = 16;
+constexpr int numSourceFrames = 1 << 18;
+
+static const char* getModeName(InterpolationMode mode) {
+    switch (mode) {
+        case InterpolationMode::NONE: return "NONE";
+        case InterpolationMode::LINEAR: return "LINEAR";
+        case InterpolationMode::CUBIC: return "CUBIC";
+        case InterpolationMode::SINC: return "SINC";
+    }
+    return "?";
+}
+
+// A stereo sine at about `cyclesPerFrame` of the source rate, rounded to whole cycles so
+// the loop point doesn't click
+static choc::buffer::ChannelArrayBuffer<float> makeSine(double cyclesPerFrame) {
+    choc::buffer::ChannelArrayBuffer<float> buffer(2, numSourceFrames);
+    const double pi = 3.14159265358979323846;
+    cyclesPerFrame = std::round(cyclesPerFrame * numSourceFrames) / numSourceFrames;
+    for (int frame = 0; frame < numSourceFrames; ++frame) {
+        auto sample = static_cast<float>(0.5 * std::sin(2.0 * pi * cyclesPerFrame * frame));
+        buffer.getSample(0, static_cast<choc::buffer::FrameCount>(frame)) = sample;
+        buffer.getSample(1, static_cast<choc::buffer::FrameCount>(frame)) = sample;
+    }
+    return buffer;
+}
+
+static std::unique_ptr<SamplePlayerNode> makePlayer(const choc::buffer::ChannelArrayBuffer<float>& buffer,
+                                                    InterpolationMode mode, double rate) {
+    auto player = std::make_unique<SamplePlayerNode>("bench");
+    player->loadSample(buffer, sampleRate);
+    player->prepare({ sampleRate, blockSize, 2 });
+    player->setInterpolationMode(mode);
+    player->setPlaybackRate(rate);
+    player->setLoop(true);
+    player->play();
+    return player;
+}
+
+// Nanoseconds per output frame, per voice
+static double measureCost(const choc::buffer::ChannelArrayBuffer<float>& buffer, InterpolationMode mode, double rate) {
+    std::vector<std::unique_ptr<SamplePlayerNode>> voices;
+    for (int i = 0; i < numVoices; ++i) {
+        voices.push_back(makePlayer(buffer, mode, rate));
+        voices.back()->setPlayPositionSamples(i * 997);
+    }
+
+    choc::buffer::ChannelArrayBuffer<float> input(2, blockSize), output(2, blockSize);
+    const int numBlocks = 2000;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int block = 0; block < numBlocks; ++block) {
+        for (auto& voice : voices) {
+            voice->processCallback(input.getView(), output.getView(), sampleRate, blockSize);
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / (static_cast<double>(numBlocks) * blockSize * numVoices);
+}
+
+// Level (dB relative to the source tone) of whatever comes out when a tone that the pitch
+// shift pushes above Nyquist is played: everything audible is aliasing
+static double measureAliasing(InterpolationMode mode, double rate) {
+    auto buffer = makeSine(0.6 / rate);
+    auto player = makePlayer(buffer, mode, rate);
+
+    choc::buffer::ChannelArrayBuffer<float> input(2, blockSize), output(2, blockSize);
+    double energy = 0.0;
+    int numFrames = 0;
+    // Skips the start of the sample, where the taps are clamped, and stops before an 8x
+    // voice reaches the loop point
+    for (int block = 0; block < 100; ++block) {
+        player->processCallback(input.getView(), output.getView(), sampleRate, blockSize);
+        if (block < 10) continue;
+        for (choc::buffer::FrameCount frame = 0; frame < blockSize; ++frame) {
+            double sample = output.getSample(0, frame);
+            energy += sample * sample;
+            ++numFrames;
+        }
+    }
+
+    const double sourceEnergy = 0.5 * 0.5 / 2.0;
+    return 10.0 * std::log10(std::max(energy / numFrames / sourceEnergy, 1e-20));
+}
+
+struct ModeResult {
+    double rate;
+    InterpolationMode mode;
+    double nsPerFrame;
+    double relativeToCubic;
+    double aliasingDb;   // Only measured when pitching up
+};
+
+int main() {
+    Logger::initialize();
+    Logger::info("=== Resampling Benchmark ({} voices, {} frame blocks) ===", numVoices, blockSize);
+
+    // Node construction logs a lot; keep the report readable
+    Logger::setLevel(spdlog::level::warn);
+
+    const auto buffer = makeSine(0.01);
+    const InterpolationMode modes[] = { InterpolationMode::NONE, InterpolationMode::LINEAR,
+                                        InterpolationMode::CUBIC, InterpolationMode::SINC };
+
+    std::vector<ModeResult> results;
+    for (double rate : { 0.5, 1.0, 1.5, 2.0, 4.0, 8.0 }) {
+        double cubicCost = measureCost(buffer, InterpolationMode::CUBIC, rate);
+        for (InterpolationMode mode : modes) {
+            double cost = mode == InterpolationMode::CUBIC ? cubicCost : measureCost(buffer, mode, rate);
+            results.push_back({ rate, mode, cost, cost / cubicCost, rate > 1.0 ? measureAliasing(mode, rate) : 0.0 });
+        }
+    }
+
+    Logger::setLevel(spdlog::level::info);
+    for (const auto& result : results) {
+        Logger::info("rate {:4.2f} | {:6} | {:7.2f} ns/frame | {:5.1f}x cubic{}",
+                     result.rate, getModeName(result.mode), result.nsPerFrame, result.relativeToCubic,
+                     result.rate > 1.0 ? fmt::format(" | aliasing {:6.1f} dB", result.aliasingDb) : std::string());
+    }
+
+    Logger::info("=== Resampling Benchmark Complete ===");
+    return 0;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <portaudio.h>
+#include <string>
+#include <vector>
+
+struct AudioDeviceInfo {
+    int index;  // Backend's own device id
+    std::string name;
+    int maxInputChannels;
+    int maxOutputChannels;
+    double defaultSampleRate;
+};
+
+// Where AudioEngine's callbacks come from. Backends deliver them in PortAudio's callback
+// format (PortAudio is the default backend), so the engine's callback is the same for all.
+class AudioDeviceBackend {
+public:
+    struct StreamConfig {
+        int inputDevice = -1;     // AudioDeviceInfo::index, -1 = no input
+        int outputDevice = -1;    // AudioDeviceInfo::index, -1 = no output
+        int inputChannels = 0;
+        int outputChannels = 0;
+        double sampleRate = 44100.0;
+        int bufferSize = 256;
+        bool nonInterleaved = false;  // Ask for one buffer per channel (may fall back, see isStreamNonInterleaved)
+    };
+
+    virtual ~AudioDeviceBackend() = default;
+
+    virtual std::string getName() const = 0;
+
+    // Called once before anything else; false if the backend can't be used
+    virtual bool initialize() = 0;
+
+    virtual std::vector<AudioDeviceInfo> getDevices() = 0;
+    virtual int getDefaultInputDevice() const = 0;   // AudioDeviceInfo::index, or -1
+    virtual int getDefaultOutputDevice() const = 0;
+
+    virtual bool openStream(const StreamConfig& config, PaStreamCallback* callback, void* userData) = 0;
+    virtual bool startStream() = 0;
+    virtual void closeStream() = 0;  // Stops the stream first if it is running
+    virtual bool isStreamOpen() const = 0;
+    virtual bool isStreamActive() const = 0;
+
+    // Format of the open stream
+    virtual bool isStreamNonInterleaved() const = 0;
+};
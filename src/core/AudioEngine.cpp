@@ -1,26 +1,55 @@
 #include "AudioEngine.h"
 #include "Logger.h"
+#include "AudioKernels.h"
+#include "AudioParameter.h"
+#include "OfflineWavWriter.h"
+#include "PortAudioBackend.h"
 #include <stdexcept>
 #include <cstring>
 #include <chrono>
 #include <iostream>
 #include <algorithm>
+#include <unordered_map>
 
-AudioEngine::AudioEngine() {
-    PaError err = Pa_Initialize();
-    if (err != paNoError) {
-        throw std::runtime_error("Failed to initialize PortAudio");
+namespace {
+    // Stores the time a callback spent over the duration of its buffer, however it returns
+    struct CallbackLoadMeter {
+        std::atomic<double>& graphLoad;
+        std::atomic<double>& peakGraphLoad;
+        double bufferSeconds;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        
+        ~CallbackLoadMeter() {
+            if (bufferSeconds <= 0.0) return;
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            double load = elapsed.count() / bufferSeconds;
+            graphLoad.store(load, std::memory_order_relaxed);
+            if (load > peakGraphLoad.load(std::memory_order_relaxed)) {
+                peakGraphLoad.store(load, std::memory_order_relaxed);
+            }
+        }
+    };
+}
+
+AudioEngine::AudioEngine(std::unique_ptr<AudioDeviceBackend> deviceBackend)
+    : backend(deviceBackend ? std::move(deviceBackend) : std::make_unique<PortAudioBackend>())
+{
+    if (!backend->initialize()) {
+        throw std::runtime_error("Failed to initialize " + backend->getName() + " audio backend");
     }
     enumerateDevices();
     
     // Initialize audio graph system
     audioGraph = std::make_unique<AudioGraph>();
     processor = std::make_unique<AudioGraphProcessor>();
+    
+    eventQueue.reset(maxScheduledEvents);
+    pendingEvents.reserve(maxScheduledEvents);
 }
 
 AudioEngine::~AudioEngine() {
     stopStream();
-    Pa_Terminate();
+    unlockMemory();
 }
 
 void AudioEngine::ensureCallbackBuffersSize(int inputChannels, int outputChannels, int bufferSize) {
@@ -40,23 +69,10 @@ void AudioEngine::ensureCallbackBuffersSize(int inputChannels, int outputChannel
 }
 
 void AudioEngine::enumerateDevices() {
-    int numDevices = Pa_GetDeviceCount();
-    if (numDevices < 0) {
-        throw std::runtime_error("Pa_GetDeviceCount failed");
-    }
-
     inputDevices.clear();
     outputDevices.clear();
 
-    for (int i = 0; i < numDevices; ++i) {
-        const PaDeviceInfo* info = Pa_GetDeviceInfo(i);
-        DeviceInfo dev;
-        dev.index = i;
-        dev.name = info->name ? info->name : "";
-        dev.maxInputChannels = info->maxInputChannels;
-        dev.maxOutputChannels = info->maxOutputChannels;
-        dev.defaultSampleRate = info->defaultSampleRate;
-
+    for (const auto& dev : backend->getDevices()) {
         if (dev.maxInputChannels > 0) {
             inputDevices.push_back(dev);
         }
@@ -72,69 +88,72 @@ void AudioEngine::startStream(int inputDeviceIndex, int outputDeviceIndex, int b
     bufferSize = bufferSize_;
     sampleRate = sampleRate_;
 
-    PaStreamParameters inputParams = {};
-    PaStreamParameters outputParams = {};
+    AudioDeviceBackend::StreamConfig config;
+    config.sampleRate = sampleRate;
+    config.bufferSize = bufferSize;
+    config.nonInterleaved = nonInterleavedRequested;
 
     if (inputDeviceIndex >= 0 && inputDeviceIndex < (int)inputDevices.size()) {
         const DeviceInfo& dev = inputDevices[inputDeviceIndex];
-        inputParams.device = dev.index;
+        config.inputDevice = dev.index;
         // Use configured input channels, but clamp to device max
         // If no input channels configured, default to device max or 2, whichever is smaller
         int desiredInputChannels = (inputChannels > 0) ? inputChannels : std::min(2, dev.maxInputChannels);
-        inputParams.channelCount = std::min(desiredInputChannels, dev.maxInputChannels);
-        inputParams.sampleFormat = paFloat32;
-        inputParams.suggestedLatency = Pa_GetDeviceInfo(dev.index)->defaultLowInputLatency;
-        inputParams.hostApiSpecificStreamInfo = nullptr;
+        config.inputChannels = std::min(desiredInputChannels, dev.maxInputChannels);
         
         // Update actual input channels being used
-        inputChannels = inputParams.channelCount;
+        inputChannels = config.inputChannels;
     } else {
-        inputParams.device = paNoDevice;
         inputChannels = 0;  // No input
     }
 
     if (outputDeviceIndex >= 0 && outputDeviceIndex < (int)outputDevices.size()) {
         const DeviceInfo& dev = outputDevices[outputDeviceIndex];
-        outputParams.device = dev.index;
+        config.outputDevice = dev.index;
         // Use configured output channels, but clamp to device max
         // If no output channels configured, default to 2 (stereo) or device max, whichever is smaller
         int desiredOutputChannels = (outputChannels > 0) ? outputChannels : std::min(2, dev.maxOutputChannels);
-        outputParams.channelCount = std::min(desiredOutputChannels, dev.maxOutputChannels);
-        outputParams.sampleFormat = paFloat32;
-        outputParams.suggestedLatency = Pa_GetDeviceInfo(dev.index)->defaultLowOutputLatency;
-        outputParams.hostApiSpecificStreamInfo = nullptr;
+        config.outputChannels = std::min(desiredOutputChannels, dev.maxOutputChannels);
         
         // Update actual output channels being used
-        outputChannels = outputParams.channelCount;
+        outputChannels = config.outputChannels;
     } else {
-        outputParams.device = paNoDevice;
         outputChannels = 0;  // No output
     }
 
-    PaError err = Pa_OpenStream(
-        &stream,
-        inputParams.device != paNoDevice ? &inputParams : nullptr,
-        outputParams.device != paNoDevice ? &outputParams : nullptr,
-        sampleRate,
-        bufferSize,
-        paNoFlag,
-        &AudioEngine::paCallback,
-        this
-    );
-    if (err != paNoError) {
-        throw std::runtime_error("Failed to open PortAudio stream");
+    if (!backend->openStream(config, &AudioEngine::paCallback, this)) {
+        throw std::runtime_error("Failed to open " + backend->getName() + " audio stream");
     }
+    nonInterleavedActive = backend->isStreamNonInterleaved();
 
-    err = Pa_StartStream(stream);
-    if (err != paNoError) {
-        throw std::runtime_error("Failed to start PortAudio stream");
-    }
+    // Size the callback buffers for the largest block up front; the callback never resizes them
+    ensureCallbackBuffersSize(inputChannels, outputChannels, getMaxBlockSize());
+    quantumInputBuffer.resize(choc::buffer::Size::create(static_cast<choc::buffer::ChannelCount>(inputChannels),
+                                                         static_cast<choc::buffer::FrameCount>(internalBlockSize)));
+    quantumOutputBuffer.resize(choc::buffer::Size::create(static_cast<choc::buffer::ChannelCount>(outputChannels),
+                                                          static_cast<choc::buffer::FrameCount>(internalBlockSize)));
+    quantumInputFill = 0;
+    quantumOutputPending = 0;
+    resetStreamStats();
+    
+    // Events scheduled against the previous stream's timeline are dropped
+    ScheduledEvent staleEvent;
+    while (eventQueue.pop(staleEvent)) {}
+    pendingEvents.clear();
+    graphSamplePosition.store(0);
     
-    // Ensure callback buffers are properly sized
-    ensureCallbackBuffersSize(inputChannels, outputChannels, bufferSize);
+    audioThreadSchedulingOutcome.store(ThreadScheduling::Outcome::NotRequested);
+    audioThreadAffinityOutcome.store(ThreadScheduling::Outcome::NotRequested);
+    audioThreadSchedulingPending.store(ThreadScheduling::isRequested(audioThreadScheduling));
     
-    // Prepare the audio graph system
+    // Prepare the audio graph system and hand the first compiled graph over before audio starts
     prepareAudioGraph();
+    publishCompiledGraph();
+    startGraphCompiler();
+    
+    if (!backend->startStream()) {
+        throw std::runtime_error("Failed to start " + backend->getName() + " audio stream");
+    }
 }
 
 void AudioEngine::startStream(int bufferSize_, double sampleRate_) {
@@ -146,23 +165,65 @@ void AudioEngine::startStream(int bufferSize_, double sampleRate_) {
 }
 
 void AudioEngine::stopStream() {
-    if (stream) {
-        Pa_StopStream(stream);
-        Pa_CloseStream(stream);
-        stream = nullptr;
+    if (backend) {
+        backend->closeStream();
+    }
+    
+    stopGraphCompiler();
+}
+
+void AudioEngine::startGraphCompiler() {
+    stopGraphCompiler();
+    shouldStopGraphCompiler.store(false);
+    graphCompilerThread = std::thread(&AudioEngine::graphCompilerThreadFunction, this);
+}
+
+void AudioEngine::stopGraphCompiler() {
+    shouldStopGraphCompiler.store(true);
+    if (graphCompilerThread.joinable()) {
+        graphCompilerThread.join();
+    }
+    
+    if (processor) {
+        processor->releaseRetiredGraphs();
+    }
+}
+
+void AudioEngine::graphCompilerThreadFunction() {
+    while (!shouldStopGraphCompiler.load()) {
+        if (audioGraph->waitForChanges(std::chrono::milliseconds(graphCompilerPollMs))) {
+            publishCompiledGraph();
+        }
+        
+        // Old graphs are freed here once the audio thread has moved past them
+        processor->releaseRetiredGraphs();
+    }
+}
+
+void AudioEngine::publishCompiledGraph() {
+    if (!audioGraph || !processor) {
+        return;
+    }
+    
+    auto compiledGraph = audioGraph->getCompiledGraph();
+    if (compiledGraph) {
+        processor->setCompiledGraph(compiledGraph);
     }
 }
 
 bool AudioEngine::isStreamActive() const {
-    return stream && Pa_IsStreamActive(stream) == 1;
+    return backend->isStreamActive();
 }
 
+// Buffer size and channel changes take effect on the next startStream: resizing the
+// callback buffers under a running stream would race the audio thread
 void AudioEngine::setBufferSize(int bufferSize_) {
     bufferSize = bufferSize_;
-    // Update callback buffers if stream is active
-    if (isStreamActive()) {
-        ensureCallbackBuffersSize(inputChannels, outputChannels, bufferSize);
-    }
+}
+
+int AudioEngine::getMaxBlockSize() const {
+    if (maxBlockSize > 0) return maxBlockSize;
+    return bufferSize > 0 ? bufferSize : defaultMaxBlockSize;
 }
 
 void AudioEngine::setSampleRate(double sampleRate_) {
@@ -171,27 +232,72 @@ void AudioEngine::setSampleRate(double sampleRate_) {
 
 void AudioEngine::setInputChannels(int channels) {
     inputChannels = channels;
-    // Update callback buffers if stream is active
-    if (isStreamActive() && bufferSize > 0) {
-        ensureCallbackBuffersSize(inputChannels, outputChannels, bufferSize);
-    }
 }
 
 void AudioEngine::setOutputChannels(int channels) {
     outputChannels = channels;
-    // Update callback buffers if stream is active
-    if (isStreamActive() && bufferSize > 0) {
-        ensureCallbackBuffersSize(inputChannels, outputChannels, bufferSize);
-    }
 }
 
 void AudioEngine::setChannels(int input, int output) {
     inputChannels = input;
     outputChannels = output;
-    // Update callback buffers if stream is active
-    if (isStreamActive() && bufferSize > 0) {
-        ensureCallbackBuffersSize(inputChannels, outputChannels, bufferSize);
+}
+
+void AudioEngine::setAudioThreadScheduling(const ThreadScheduling::Settings& settings) {
+    if (isStreamActive()) {
+        Logger::warn("Cannot change audio thread scheduling while the stream is running");
+        return;
+    }
+    audioThreadScheduling = settings;
+}
+
+void AudioEngine::setGraphWorkerScheduling(const ThreadScheduling::Settings& settings) {
+    if (isStreamActive()) {
+        Logger::warn("Cannot change graph worker scheduling while the stream is running");
+        return;
+    }
+    
+    processor->setWorkerThreadScheduling(settings);
+    if (graphWorkerThreads > 0) {
+        processor->setNumWorkerThreads(graphWorkerThreads);
+    }
+}
+
+bool AudioEngine::lockMemory() {
+    if (!memoryLocked) {
+        memoryLocked = ThreadScheduling::lockProcessMemory();
+        if (!memoryLocked) {
+            Logger::warn("mlockall failed; check the memlock limit (ulimit -l)");
+        }
     }
+    return memoryLocked;
+}
+
+void AudioEngine::unlockMemory() {
+    if (memoryLocked) {
+        ThreadScheduling::unlockProcessMemory();
+        memoryLocked = false;
+    }
+}
+
+AudioEngine::SchedulingReport AudioEngine::getSchedulingReport() const {
+    SchedulingReport report;
+    report.audioThread.scheduling = audioThreadSchedulingOutcome.load();
+    report.audioThread.affinity = audioThreadAffinityOutcome.load();
+    report.graphWorkers = processor->getWorkerSchedulingResults();
+    report.memoryLocked = memoryLocked;
+    return report;
+}
+
+void AudioEngine::setGraphWorkerThreads(int numWorkers) {
+    if (isStreamActive()) {
+        Logger::warn("Cannot change graph worker threads while the stream is running");
+        return;
+    }
+    
+    graphWorkerThreads = std::max(0, numWorkers);
+    audioGraph->setParallelProcessing(graphWorkerThreads > 0);
+    processor->setNumWorkerThreads(graphWorkerThreads);
 }
 
 // TODO:Fix Implement audio graph preparation
@@ -199,7 +305,7 @@ void AudioEngine::prepareAudioGraph() {
     if (audioGraph && sampleRate > 0 && bufferSize > 0) {
         AudioNode::PrepareInfo info;
         info.sampleRate = sampleRate;
-        info.maxBufferSize = bufferSize;
+        info.maxBufferSize = internalBlockSize > 0 ? internalBlockSize : getMaxBlockSize();
         info.numChannels = outputChannels; // Use actual output channel count
         
         audioGraph->prepare(info);
@@ -207,8 +313,8 @@ void AudioEngine::prepareAudioGraph() {
 }
 
 int AudioEngine::getDefaultOutputDeviceIndex() const {
-    PaDeviceIndex defaultDevice = Pa_GetDefaultOutputDevice();
-    if (defaultDevice == paNoDevice) {
+    int defaultDevice = backend->getDefaultOutputDevice();
+    if (defaultDevice < 0) {
         // Fallback to first available output device
         return outputDevices.empty() ? -1 : 0;
     }
@@ -225,8 +331,8 @@ int AudioEngine::getDefaultOutputDeviceIndex() const {
 }
 
 int AudioEngine::getDefaultInputDeviceIndex() const {
-    PaDeviceIndex defaultDevice = Pa_GetDefaultInputDevice();
-    if (defaultDevice == paNoDevice) {
+    int defaultDevice = backend->getDefaultInputDevice();
+    if (defaultDevice < 0) {
         // Return -1 to indicate no input device (output-only)
         return -1;
     }
@@ -242,6 +348,113 @@ int AudioEngine::getDefaultInputDeviceIndex() const {
     return -1;
 }
 
+void AudioEngine::recordCallbackStatus(const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags,
+                                       unsigned long framesPerBuffer) {
+    constexpr auto relaxed = std::memory_order_relaxed;
+    auto& counters = streamCounters;
+    
+    // Single writer: plain load + store instead of read-modify-write
+    auto increment = [](std::atomic<uint64_t>& counter, uint64_t amount = 1) {
+        counter.store(counter.load(relaxed) + amount, relaxed);
+    };
+    
+    uint64_t samplePosition = counters.samplesProcessed.load(relaxed);
+    increment(counters.callbacks);
+    increment(counters.samplesProcessed, framesPerBuffer);
+    
+    constexpr PaStreamCallbackFlags xrunFlags = paInputUnderflow | paInputOverflow | paOutputUnderflow | paOutputOverflow;
+    if (statusFlags & xrunFlags) {
+        if (statusFlags & paInputUnderflow) increment(counters.inputUnderflows);
+        if (statusFlags & paInputOverflow) increment(counters.inputOverflows);
+        if (statusFlags & paOutputUnderflow) increment(counters.outputUnderflows);
+        if (statusFlags & paOutputOverflow) increment(counters.outputOverflows);
+        
+        uint64_t eventIndex = counters.xrunCount.load(relaxed);
+        auto& slot = counters.events[eventIndex % maxRecentXruns];
+        std::atomic_thread_fence(std::memory_order_release);  // Pairs with getStreamStats' fence
+        slot.flags.store(statusFlags & xrunFlags, relaxed);
+        slot.callbackTime.store(timeInfo ? timeInfo->currentTime : 0.0, relaxed);
+        slot.samplePosition.store(samplePosition, relaxed);
+        slot.graphLoad.store(counters.graphLoad.load(relaxed), relaxed);
+        counters.xrunCount.store(eventIndex + 1, std::memory_order_release);
+        
+        // Samples were dropped or repeated, so the sample counter no longer lines up with the DAC clock
+        counters.anchored = false;
+    }
+    
+    // Drift: how far the DAC clock has moved beyond what the frames we produced account for
+    if (!timeInfo || timeInfo->outputBufferDacTime <= 0.0 || sampleRate <= 0.0) {
+        return;
+    }
+    
+    if (!counters.anchored) {
+        counters.anchorDacTime = timeInfo->outputBufferDacTime;
+        counters.anchorSamples = samplePosition;
+        counters.anchored = true;
+        return;
+    }
+    
+    double dacElapsed = timeInfo->outputBufferDacTime - counters.anchorDacTime;
+    double sampleElapsed = static_cast<double>(samplePosition - counters.anchorSamples) / sampleRate;
+    if (sampleElapsed > 0.0) {
+        double drift = dacElapsed - sampleElapsed;
+        counters.clockDriftSeconds.store(drift, relaxed);
+        counters.clockDriftPpm.store(drift / sampleElapsed * 1e6, relaxed);
+    }
+}
+
+void AudioEngine::resetStreamStats() {
+    // Only called while no stream is running
+    auto& counters = streamCounters;
+    for (auto* counter : { &counters.callbacks, &counters.samplesProcessed, &counters.inputUnderflows,
+                           &counters.inputOverflows, &counters.outputUnderflows, &counters.outputOverflows,
+                           &counters.xrunCount }) {
+        counter->store(0);
+    }
+    for (auto* value : { &counters.graphLoad, &counters.peakGraphLoad, &counters.clockDriftSeconds, &counters.clockDriftPpm }) {
+        value->store(0.0);
+    }
+    counters.anchored = false;
+}
+
+AudioEngine::StreamStats AudioEngine::getStreamStats() const {
+    constexpr auto relaxed = std::memory_order_relaxed;
+    const auto& counters = streamCounters;
+    
+    StreamStats stats;
+    stats.callbacks = counters.callbacks.load(relaxed);
+    stats.samplesProcessed = counters.samplesProcessed.load(relaxed);
+    stats.inputUnderflows = counters.inputUnderflows.load(relaxed);
+    stats.inputOverflows = counters.inputOverflows.load(relaxed);
+    stats.outputUnderflows = counters.outputUnderflows.load(relaxed);
+    stats.outputOverflows = counters.outputOverflows.load(relaxed);
+    stats.graphLoad = counters.graphLoad.load(relaxed);
+    stats.peakGraphLoad = counters.peakGraphLoad.load(relaxed);
+    stats.clockDriftSeconds = counters.clockDriftSeconds.load(relaxed);
+    stats.clockDriftPpm = counters.clockDriftPpm.load(relaxed);
+    
+    // Copy the ring, then drop anything the audio thread may have overwritten meanwhile
+    // (including the slot it could be writing next)
+    uint64_t countBefore = counters.xrunCount.load(std::memory_order_acquire);
+    uint64_t first = countBefore > maxRecentXruns ? countBefore - maxRecentXruns : 0;
+    
+    std::vector<XrunEvent> events;
+    events.reserve(static_cast<size_t>(countBefore - first));
+    for (uint64_t index = first; index < countBefore; ++index) {
+        const auto& slot = counters.events[index % maxRecentXruns];
+        events.push_back({ slot.flags.load(relaxed), slot.callbackTime.load(relaxed),
+                           slot.samplePosition.load(relaxed), slot.graphLoad.load(relaxed) });
+    }
+    
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t countAfter = counters.xrunCount.load(relaxed);
+    uint64_t firstIntact = countAfter + 1 > maxRecentXruns ? countAfter + 1 - maxRecentXruns : 0;
+    size_t numStale = static_cast<size_t>(std::min(countBefore, std::max(firstIntact, first)) - first);
+    stats.recentXruns.assign(events.begin() + static_cast<std::ptrdiff_t>(numStale), events.end());
+    
+    return stats;
+}
+
 int AudioEngine::paCallback(
     const void* inputBuffer,
     void* outputBuffer,
@@ -252,82 +465,215 @@ int AudioEngine::paCallback(
 {
     AudioEngine* engine = static_cast<AudioEngine*>(userData);
     
-    // Check if graph needs recompilation and update processor atomically
-    // We do this in the audio thread but try to minimize blocking
-    if (engine->audioGraph && engine->audioGraph->needsRecompile()) {
-        Logger::debug("Engine recompiling audio graph...");
-        // Try to get current compiled graph first (lock-free)
-        engine->prepareAudioGraph();
-        auto compiledGraph = engine->audioGraph->getCompiledGraph();
-        if (engine->processor && compiledGraph) {
-            engine->processor->setCompiledGraph(compiledGraph);
+    if (engine->audioThreadSchedulingPending.load(std::memory_order_acquire)) {
+        // Once, from the thread the backend calls us on (system calls only, no allocation)
+        auto result = ThreadScheduling::applyToCurrentThread(engine->audioThreadScheduling);
+        engine->audioThreadSchedulingOutcome.store(result.scheduling, std::memory_order_relaxed);
+        engine->audioThreadAffinityOutcome.store(result.affinity, std::memory_order_relaxed);
+        engine->audioThreadSchedulingPending.store(false, std::memory_order_release);
+    }
+    
+    engine->recordCallbackStatus(timeInfo, statusFlags, framesPerBuffer);
+    CallbackLoadMeter loadMeter { engine->streamCounters.graphLoad, engine->streamCounters.peakGraphLoad,
+                                  engine->sampleRate > 0.0 ? framesPerBuffer / engine->sampleRate : 0.0 };
+    
+    // Graph edits are compiled on the graph compiler thread; the processor
+    // picks up the newest compiled graph with a single atomic load
+    
+    if (outputBuffer && engine->processor && engine->callbackOutputBuffer.getNumChannels() > 0) {
+        // Hosts may call back with more frames than we prepared for (or a different size each
+        // time): run the graph over prepared-size pieces of the device buffer
+        const auto maxFrames = static_cast<unsigned long>(engine->callbackOutputBuffer.getNumFrames());
+        for (unsigned long offset = 0; offset < framesPerBuffer; offset += maxFrames) {
+            auto numFrames = static_cast<int>(std::min(maxFrames, framesPerBuffer - offset));
+            engine->processDeviceBlock(inputBuffer, outputBuffer, static_cast<int>(offset), numFrames);
+        }
+        
+    } else if (outputBuffer && engine->outputChannels > 0) {
+        // Fallback: just zero the output
+        if (engine->nonInterleavedActive) {
+            auto** channels = static_cast<float**>(outputBuffer);
+            for (int ch = 0; ch < engine->outputChannels; ++ch) {
+                std::memset(channels[ch], 0, framesPerBuffer * sizeof(float));
+            }
+        } else {
+            std::memset(outputBuffer, 0, framesPerBuffer * sizeof(float) * engine->outputChannels);
         }
     }
     
-    if (outputBuffer && engine->processor && engine->outputChannels > 0) {
-        // Convert PortAudio interleaved buffer to separate channel pointers
-        float* interleavedOutput = static_cast<float*>(outputBuffer);
-        const float* interleavedInput = static_cast<const float*>(inputBuffer);
+    return paContinue;
+}
+
+void AudioEngine::processDeviceBlock(const void* inputBuffer, void* outputBuffer, int frameOffset, int numFrames) {
+    const auto numOutputChannels = callbackOutputBuffer.getNumChannels();
+    const auto numInputChannels = callbackInputBuffer.getNumChannels();
+    const auto start = static_cast<choc::buffer::FrameCount>(frameOffset);
+    const choc::buffer::FrameRange range { start, start + static_cast<choc::buffer::FrameCount>(numFrames) };
+    
+    auto inputScratch = callbackInputBuffer.getView().getFrameRange({ 0, range.size() });
+    
+    if (nonInterleavedActive) {
+        // PortAudio hands us one pointer per channel: run the graph straight on the device buffers
+        auto outputView = choc::buffer::createChannelArrayView(
+            static_cast<float* const*>(outputBuffer), numOutputChannels, range.end).getFrameRange(range);
         
-        // Use actual channel counts
-        const int numOutputChannels = engine->outputChannels;
-        const int numInputChannels = engine->inputChannels;
-        const int numSamples = static_cast<int>(framesPerBuffer);
+        choc::buffer::ChannelArrayView<const float> inputView = inputScratch;
+        if (inputBuffer && numInputChannels > 0) {
+            inputView = choc::buffer::createChannelArrayView(
+                static_cast<const float* const*>(inputBuffer), numInputChannels, range.end).getFrameRange(range);
+        } else if (numInputChannels > 0) {
+            inputScratch.clear();
+        }
         
-        // Ensure buffers are properly sized (only resize if needed - should be rare after stream start)
-        if (engine->callbackOutputBuffer.getNumFrames() != static_cast<choc::buffer::FrameCount>(numSamples) ||
-            engine->callbackOutputBuffer.getNumChannels() != static_cast<choc::buffer::ChannelCount>(numOutputChannels) ||
-            (numInputChannels > 0 && 
-             (engine->callbackInputBuffer.getNumFrames() != static_cast<choc::buffer::FrameCount>(numSamples) ||
-              engine->callbackInputBuffer.getNumChannels() != static_cast<choc::buffer::ChannelCount>(numInputChannels)))) {
-            engine->ensureCallbackBuffersSize(numInputChannels, numOutputChannels, numSamples);
+        processHostBlock(inputView, outputView);
+        return;
+    }
+    
+    // Convert interleaved input to deinterleaved input buffer (processGraph clears the output itself)
+    if (inputBuffer && numInputChannels > 0) {
+        AudioKernels::deinterleave(static_cast<const float*>(inputBuffer) + static_cast<size_t>(frameOffset) * numInputChannels,
+                                   inputScratch.data.channels, static_cast<int>(numInputChannels), numFrames);
+    } else if (numInputChannels > 0) {
+        // Clear input buffer if no input data
+        inputScratch.clear();
+    }
+    
+    auto outputView = callbackOutputBuffer.getView().getFrameRange({ 0, range.size() });
+    processHostBlock(inputScratch, outputView);
+    
+    // Convert back to interleaved format
+    AudioKernels::interleave(outputView.data.channels,
+                             static_cast<float*>(outputBuffer) + static_cast<size_t>(frameOffset) * numOutputChannels,
+                             static_cast<int>(numOutputChannels), numFrames);
+}
+
+void AudioEngine::processHostBlock(choc::buffer::ChannelArrayView<const float> input,
+                                   choc::buffer::ChannelArrayView<float> output) {
+    if (internalBlockSize <= 0) {
+        renderGraph(input, output);
+        return;
+    }
+    
+    const auto quantum = static_cast<choc::buffer::FrameCount>(internalBlockSize);
+    const auto numFrames = output.getNumFrames();
+    const bool hasInput = input.getNumChannels() > 0;
+    choc::buffer::FrameCount position = 0;
+    
+    while (position < numFrames) {
+        if (quantumOutputPending == 0) {
+            // Still in step with the host: run whole blocks straight on its buffers
+            if (numFrames - position >= quantum) {
+                choc::buffer::FrameRange range { position, position + quantum };
+                renderGraph(hasInput ? input.getFrameRange(range) : input, output.getFrameRange(range));
+                position += quantum;
+                continue;
+            }
+            
+            // A partial block: from now on run one block behind the host
+            quantumOutputBuffer.clear();
+            quantumInputFill = 0;
+            quantumOutputPending = internalBlockSize;
         }
         
-        // Clear the output buffer
-        engine->callbackOutputBuffer.clear();
+        auto numToCopy = std::min(numFrames - position, static_cast<choc::buffer::FrameCount>(quantumOutputPending));
+        auto fill = static_cast<choc::buffer::FrameCount>(quantumInputFill);
+        auto played = quantum - static_cast<choc::buffer::FrameCount>(quantumOutputPending);
         
-        // Convert interleaved input to deinterleaved input buffer
-        if (interleavedInput && numInputChannels > 0) {
-            for (int sample = 0; sample < numSamples; ++sample) {
-                for (int ch = 0; ch < numInputChannels; ++ch) {
-                    engine->callbackInputBuffer.getSample(static_cast<choc::buffer::ChannelCount>(ch), 
-                                                         static_cast<choc::buffer::FrameCount>(sample)) = 
-                        interleavedInput[sample * numInputChannels + ch];
-                }
-            }
-        } else if (numInputChannels > 0) {
-            // Clear input buffer if no input data
-            engine->callbackInputBuffer.clear();
+        if (hasInput) {
+            choc::buffer::copy(quantumInputBuffer.getView().getFrameRange({ fill, fill + numToCopy }),
+                               input.getFrameRange({ position, position + numToCopy }));
         }
+        choc::buffer::copy(output.getFrameRange({ position, position + numToCopy }),
+                           quantumOutputBuffer.getView().getFrameRange({ played, played + numToCopy }));
         
-        // Process the audio graph with both input and output buffers
-        engine->processor->processGraph(
-            engine->callbackInputBuffer.getView(),
-            engine->callbackOutputBuffer.getView(),
-            engine->sampleRate,
-            numSamples
-        );
+        position += numToCopy;
+        quantumInputFill += static_cast<int>(numToCopy);
+        quantumOutputPending -= static_cast<int>(numToCopy);
         
-        // Convert back to interleaved format
-        for (int sample = 0; sample < numSamples; ++sample) {
-            for (int ch = 0; ch < numOutputChannels; ++ch) {
-                interleavedOutput[sample * numOutputChannels + ch] = 
-                    engine->callbackOutputBuffer.getSample(static_cast<choc::buffer::ChannelCount>(ch), 
-                                                          static_cast<choc::buffer::FrameCount>(sample));
+        if (quantumOutputPending == 0) {
+            renderGraph(quantumInputBuffer.getView(), quantumOutputBuffer.getView());
+            quantumInputFill = 0;
+            quantumOutputPending = internalBlockSize;
+        }
+    }
+}
+
+void AudioEngine::renderGraph(choc::buffer::ChannelArrayView<const float> input,
+                              choc::buffer::ChannelArrayView<float> output) {
+    collectScheduledEvents();
+    
+    const auto blockStart = graphSamplePosition.load(std::memory_order_relaxed);
+    const auto numFrames = output.getNumFrames();
+    const bool hasInput = input.getNumChannels() > 0;
+    choc::buffer::FrameCount position = 0;
+    
+    while (position < numFrames) {
+        // Apply everything due by this sample, then run up to the next event
+        while (!pendingEvents.empty() && pendingEvents.back().samplePosition <= blockStart + position) {
+            const auto& event = pendingEvents.back();
+            if (event.parameter) {
+                event.parameter->setValue(event.value, event.rampTimeMs);
+            } else if (event.node) {
+                event.node->handleMidiMessage(event.message);
             }
+            pendingEvents.pop_back();
         }
         
-    } else if (outputBuffer && engine->outputChannels > 0) {
-        // Fallback: just zero the output
-        std::memset(outputBuffer, 0, framesPerBuffer * sizeof(float) * engine->outputChannels);
+        auto end = numFrames;
+        if (!pendingEvents.empty()) {
+            end = static_cast<choc::buffer::FrameCount>(
+                std::min<int64_t>(numFrames, pendingEvents.back().samplePosition - blockStart));
+        }
+        
+        choc::buffer::FrameRange range { position, end };
+        processor->processGraph(hasInput ? input.getFrameRange(range) : input, output.getFrameRange(range),
+                                sampleRate, static_cast<int>(end - position));
+        position = end;
     }
     
-    return paContinue;
+    graphSamplePosition.store(blockStart + numFrames, std::memory_order_relaxed);
+}
+
+bool AudioEngine::scheduleParameterChange(AudioParameter& parameter, float value, int64_t samplePosition,
+                                          float rampTimeMs) {
+    ScheduledEvent event;
+    event.samplePosition = samplePosition;
+    event.parameter = &parameter;
+    event.value = value;
+    event.rampTimeMs = rampTimeMs;
+    return pushScheduledEvent(event);
+}
+
+bool AudioEngine::scheduleMidiMessage(AudioNode& node, const choc::midi::ShortMessage& message, int64_t samplePosition) {
+    ScheduledEvent event;
+    event.samplePosition = samplePosition;
+    event.node = &node;
+    event.message = message;
+    return pushScheduledEvent(event);
+}
+
+bool AudioEngine::pushScheduledEvent(const ScheduledEvent& event) {
+    if (!eventQueue.push(event)) {
+        Logger::warn("Scheduled event queue is full, dropping event for sample {}", event.samplePosition);
+        return false;
+    }
+    return true;
+}
+
+void AudioEngine::collectScheduledEvents() {
+    // Events that don't fit stay queued until earlier ones have been delivered
+    ScheduledEvent event;
+    while (pendingEvents.size() < pendingEvents.capacity() && eventQueue.pop(event)) {
+        // Latest first; an event goes in front of any with the same time so those run first
+        auto position = std::lower_bound(pendingEvents.begin(), pendingEvents.end(), event.samplePosition,
+            [](const ScheduledEvent& pending, int64_t time) { return pending.samplePosition > time; });
+        pendingEvents.insert(position, event);
+    }
 }
 
 // Offline rendering implementation
 bool AudioEngine::renderOffline(const OfflineRenderParams& params) {
-    if (params.outputFilePath.empty()) {
+    if (params.outputFilePath.empty() && params.stems.empty()) {
         Logger::error("Output file path is required for offline rendering");
         return false;
     }
@@ -341,174 +687,247 @@ bool AudioEngine::renderOffline(const OfflineRenderParams& params) {
     
     Logger::info("Starting offline render: {} samples at {} Hz", totalSamples, params.renderSampleRate);
     
-    // Prepare audio graph for offline rendering
     if (!audioGraph) {
         Logger::error("No audio graph available for rendering");
         return false;
     }
     
-    // Store current state to restore later
-    double originalSampleRate = sampleRate;
-    int originalBufferSize = bufferSize;
-    int originalOutputChannels = outputChannels;
-    int originalInputChannels = inputChannels;
-    
-    // Set up for offline rendering
-    sampleRate = params.renderSampleRate;
-    bufferSize = params.renderBufferSize;
-    // Keep existing channel configuration or use defaults
-    if (outputChannels == 0) outputChannels = 2; // Default to stereo
-    
-    // Prepare the audio graph with offline settings
+    // The render runs on copies prepared with the offline settings; the live graph, its
+    // compiled graph and the engine's own settings are left alone, so a running stream
+    // carries on undisturbed
     AudioNode::PrepareInfo prepareInfo;
-    prepareInfo.sampleRate = sampleRate;
-    prepareInfo.maxBufferSize = bufferSize;
-    prepareInfo.numChannels = outputChannels;
-    
-    audioGraph->prepare(prepareInfo);
-    
-    // Create processor for offline rendering
-    auto offlineProcessor = std::make_unique<AudioGraphProcessor>();
-    auto compiledGraph = audioGraph->getCompiledGraph();
-    if (!compiledGraph) {
-        Logger::error("Failed to compile audio graph for offline rendering");
-        goto cleanup;
-    }
-    offlineProcessor->setCompiledGraph(compiledGraph);
+    prepareInfo.sampleRate = params.renderSampleRate;
+    prepareInfo.maxBufferSize = params.renderBufferSize;
+    prepareInfo.numChannels = outputChannels > 0 ? outputChannels : 2; // Default to stereo
     
+    bool success = false;
     try {
-        // Create output buffer for entire render
-        choc::buffer::ChannelArrayBuffer<float> fullOutputBuffer(
-            static_cast<choc::buffer::ChannelCount>(outputChannels),
-            static_cast<choc::buffer::FrameCount>(totalSamples)
-        );
-        
-        // Create input buffer (silent for offline rendering unless specified)
-        choc::buffer::ChannelArrayBuffer<float> inputBuffer(
-            static_cast<choc::buffer::ChannelCount>(params.includeInput ? inputChannels : 0),
-            static_cast<choc::buffer::FrameCount>(bufferSize)
-        );
-        if (params.includeInput) {
-            inputBuffer.clear(); // Fill with silence
+        if (!params.stems.empty()) {
+            success = renderStems(params, totalSamples, prepareInfo);
+        } else {
+            success = renderMix(params, totalSamples, prepareInfo);
         }
         
-        // Create empty input buffer for when no input is needed
-        choc::buffer::ChannelArrayBuffer<float> emptyInputBuffer(
-            static_cast<choc::buffer::ChannelCount>(0),
-            static_cast<choc::buffer::FrameCount>(bufferSize)
-        );
+        if (success) {
+            Logger::info("Rendered {} samples ({:.2f} seconds)", totalSamples, (totalSamples / params.renderSampleRate));
+        }
         
-        // Process in chunks
-        int samplesRendered = 0;
-        while (samplesRendered < totalSamples) {
-            int samplesThisChunk = std::min(bufferSize, totalSamples - samplesRendered);
-            
-            // Create output buffer view for this chunk
-            auto outputChunkView = fullOutputBuffer.getView().getFrameRange(
-                {static_cast<choc::buffer::FrameCount>(samplesRendered), 
-                 static_cast<choc::buffer::FrameCount>(samplesRendered + samplesThisChunk)}
-            );
-            
-            // Create input buffer view for this chunk (if using input)
-            choc::buffer::ChannelArrayView<const float> inputChunkView;
-            if (params.includeInput && inputChannels > 0) {
-                // Resize input buffer if needed for this chunk
-                if (inputBuffer.getNumFrames() != static_cast<choc::buffer::FrameCount>(samplesThisChunk)) {
-                    inputBuffer.resize({static_cast<choc::buffer::ChannelCount>(inputChannels), 
-                                       static_cast<choc::buffer::FrameCount>(samplesThisChunk)});
-                    inputBuffer.clear();
-                }
-                inputChunkView = inputBuffer.getView();
-            } else {
-                // Use the empty input buffer, resizing if needed
-                if (emptyInputBuffer.getNumFrames() != static_cast<choc::buffer::FrameCount>(samplesThisChunk)) {
-                    emptyInputBuffer.resize({static_cast<choc::buffer::ChannelCount>(0),
-                                           static_cast<choc::buffer::FrameCount>(samplesThisChunk)});
-                }
-                inputChunkView = emptyInputBuffer.getView();
+    } catch (const std::exception& e) {
+        Logger::error("Error during offline rendering: {}", e.what());
+    }
+    
+    return success;
+}
+
+bool AudioEngine::renderMix(const OfflineRenderParams& params, int totalSamples, const AudioNode::PrepareInfo& prepareInfo) {
+    // Nodes that can't be cloned are only borrowed from the live graph while no stream is
+    // running; they are put back to the live settings afterwards
+    const bool streamActive = isStreamActive();
+    bool borrowedNodes = false;
+    std::unordered_map<AudioNode*, std::shared_ptr<AudioNode>> copies;
+    auto copyNode = [&](const std::shared_ptr<AudioNode>& node) -> std::shared_ptr<AudioNode> {
+        auto& copy = copies[node.get()];
+        if (!copy) {
+            copy = node->clone();
+            if (!copy && !streamActive) {
+                copy = node;
+                borrowedNodes = true;
             }
+        }
+        if (!copy) {
+            Logger::error("Cannot render offline while the stream is running: node '{}' can't be cloned; "
+                          "stop the stream first", node->getName());
+        }
+        return copy;
+    };
+    
+    AudioGraph offlineGraph;
+    std::shared_ptr<AudioNode> sourceNode;
+    bool copied = true;
+    if (params.sourceNode) {
+        sourceNode = copyNode(params.sourceNode);
+        copied = sourceNode != nullptr;
+    } else {
+        for (const auto& outputNode : audioGraph->getOutputNodes()) {
+            copied = copied && audioGraph->copySubgraph(outputNode, offlineGraph, copyNode);
+        }
+    }
+    
+    bool success = false;
+    if (copied) {
+        AudioGraphProcessor renderProcessor;
+        if (sourceNode) {
+            sourceNode->prepare(prepareInfo);
+        } else {
+            offlineGraph.prepare(prepareInfo);
+            renderProcessor.setCompiledGraph(offlineGraph.getCompiledGraph());
+        }
+        
+        // Chunks stream to the file as they are rendered instead of piling up in memory
+        OfflineWavWriter writer(prepareInfo.numChannels, prepareInfo.maxBufferSize, params.writeQueueDepth);
+        if (writer.open(params.outputFilePath, prepareInfo.sampleRate)) {
+            bool rendered = renderBlocks(writer, totalSamples, prepareInfo.maxBufferSize,
+                params.includeInput ? inputChannels : 0,
+                [&](choc::buffer::ChannelArrayView<const float> input, choc::buffer::ChannelArrayView<float> output, int numSamples) {
+                    if (sourceNode) {
+                        // Render from specific node
+                        sourceNode->processCallback(input, output, prepareInfo.sampleRate, numSamples);
+                    } else {
+                        // Render entire graph
+                        renderProcessor.processGraph(input, output, prepareInfo.sampleRate, numSamples);
+                    }
+                });
             
-            // Process this chunk
-            if (params.sourceNode) {
-                // Render from specific node
-                params.sourceNode->processCallback(
-                    inputChunkView,
-                    outputChunkView,
-                    sampleRate,
-                    samplesThisChunk
-                );
+            if (writer.finish() && rendered) {
+                Logger::info("Offline render completed successfully: {}", params.outputFilePath);
+                success = true;
             } else {
-                // Render entire graph
-                offlineProcessor->processGraph(
-                    inputChunkView,
-                    outputChunkView,
-                    sampleRate,
-                    samplesThisChunk
-                );
-            }
-            
-            samplesRendered += samplesThisChunk;
-            
-            // Progress indicator
-            if (samplesRendered % (totalSamples / 10) == 0) {
-                int progress = (samplesRendered * 100) / totalSamples;
-                Logger::debug("Rendering progress: {}%", progress);
+                Logger::error("Failed to write audio data to file");
             }
         }
+    }
+    
+    if (borrowedNodes) {
+        prepareAudioGraph();
+    }
+    return success;
+}
+
+bool AudioEngine::renderBlocks(OfflineWavWriter& writer, int totalSamples, int blockSize, int numInputChannels,
+                               const std::function<void(choc::buffer::ChannelArrayView<const float>,
+                                                        choc::buffer::ChannelArrayView<float>, int)>& processBlock) {
+    // Input is silent for offline rendering
+    choc::buffer::ChannelArrayBuffer<float> inputBuffer(
+        static_cast<choc::buffer::ChannelCount>(numInputChannels),
+        static_cast<choc::buffer::FrameCount>(blockSize)
+    );
+    inputBuffer.clear();
+    
+    int progressInterval = std::max(totalSamples / 10, 1);
+    int samplesRendered = 0;
+    while (samplesRendered < totalSamples) {
+        int samplesThisChunk = std::min(blockSize, totalSamples - samplesRendered);
+        auto frameRange = choc::buffer::FrameRange { 0, static_cast<choc::buffer::FrameCount>(samplesThisChunk) };
         
-        // Write to WAV file
-        choc::audio::WAVAudioFileFormat<true> wavFormat; // Set to true to enable writing
-        
-        choc::audio::AudioFileProperties fileProps;
-        fileProps.sampleRate = params.renderSampleRate;
-        fileProps.numChannels = outputChannels;
-        fileProps.bitDepth = choc::audio::BitDepth::float32; // Use 32-bit float
-        
-        auto writer = wavFormat.createWriter(params.outputFilePath, fileProps);
-        if (!writer) {
-            Logger::error("Failed to create WAV writer for: {}", params.outputFilePath);
-            goto cleanup;
+        // Blocks until the writer has a free chunk, which keeps memory bounded
+        auto outputChunk = writer.acquireChunk();
+        if (outputChunk.getNumFrames() == 0) {
+            return false; // The file isn't open
         }
+        auto outputChunkView = outputChunk.getFrameRange(frameRange);
+        processBlock(inputBuffer.getView().getFrameRange(frameRange), outputChunkView, samplesThisChunk);
+        writer.submitChunk(samplesThisChunk);
         
-        if (!writer->appendFrames(fullOutputBuffer.getView())) {
-            Logger::error("Failed to write audio data to file");
-            goto cleanup;
+        if (writer.hasFailed()) {
+            return false;
         }
         
-        Logger::info("Offline render completed successfully: {}", params.outputFilePath);
-        Logger::info("Rendered {} samples ({:.2f} seconds)", totalSamples, (totalSamples / params.renderSampleRate));
-        
-        // Restore original state
-        sampleRate = originalSampleRate;
-        bufferSize = originalBufferSize;
-        outputChannels = originalOutputChannels;
-        inputChannels = originalInputChannels;
-        
-        // Re-prepare with original settings if we had a real-time session
-        if (originalSampleRate > 0 && originalBufferSize > 0) {
-            prepareAudioGraph();
+        // Progress indicator
+        int previousProgress = samplesRendered / progressInterval;
+        samplesRendered += samplesThisChunk;
+        if (samplesRendered / progressInterval != previousProgress) {
+            int progress = static_cast<int>((static_cast<int64_t>(samplesRendered) * 100) / totalSamples);
+            Logger::debug("Rendering progress: {}%", progress);
         }
+    }
+    
+    return true;
+}
+
+bool AudioEngine::renderStems(const OfflineRenderParams& params, int totalSamples, const AudioNode::PrepareInfo& prepareInfo) {
+    // A node feeding several stems has to be cloned for each; one only a single stem uses
+    // can be rendered as it is if it doesn't support cloning, provided no stream is running
+    // (it is put back to the live settings afterwards)
+    const bool streamActive = isStreamActive();
+    bool borrowedNodes = false;
+    std::unordered_map<AudioNode*, int> stemsUsingNode;
+    for (const auto& stem : params.stems) {
+        if (!stem.node || stem.outputFilePath.empty()) {
+            Logger::error("Every stem needs a node and an output file path");
+            return false;
+        }
+        for (const auto& node : audioGraph->getUpstreamNodes(stem.node)) {
+            ++stemsUsingNode[node.get()];
+        }
+    }
+    
+    struct StemRender {
+        std::unique_ptr<AudioGraph> graph;
+        std::unique_ptr<AudioGraphProcessor> processor;
+        std::string outputFilePath;
+    };
+    std::vector<StemRender> stemRenders;
+    
+    for (const auto& stem : params.stems) {
+        StemRender render { std::make_unique<AudioGraph>(), std::make_unique<AudioGraphProcessor>(), stem.outputFilePath };
         
-        return true;
+        bool copied = audioGraph->copySubgraph(stem.node, *render.graph,
+            [&](const std::shared_ptr<AudioNode>& node) -> std::shared_ptr<AudioNode> {
+                auto copy = node->clone();
+                if (!copy && !streamActive && stemsUsingNode[node.get()] == 1) {
+                    borrowedNodes = true;
+                    return node;
+                }
+                return copy;
+            });
+        if (!copied) {
+            Logger::error("Cannot render stem '{}': its nodes can't be separated from the other stems{}",
+                          stem.outputFilePath, streamActive ? " while the stream is running" : "");
+            if (borrowedNodes) {
+                prepareAudioGraph();
+            }
+            return false;
+        }
         
-    } catch (const std::exception& e) {
-        Logger::error("Error during offline rendering: {}", e.what());
-        goto cleanup;
+        render.graph->prepare(prepareInfo);
+        render.processor->setCompiledGraph(render.graph->getCompiledGraph());
+        stemRenders.push_back(std::move(render));
     }
     
-cleanup:
-    // Restore original state
-    sampleRate = originalSampleRate;
-    bufferSize = originalBufferSize;
-    outputChannels = originalOutputChannels;
-    inputChannels = originalInputChannels;
+    unsigned int numThreads = params.stemRenderThreads > 0 ? static_cast<unsigned int>(params.stemRenderThreads)
+                                                            : std::max(1u, std::thread::hardware_concurrency());
+    numThreads = std::min(numThreads, static_cast<unsigned int>(stemRenders.size()));
+    Logger::info("Rendering {} stems on {} threads", stemRenders.size(), numThreads);
     
-    // Re-prepare with original settings if we had a real-time session
-    if (originalSampleRate > 0 && originalBufferSize > 0) {
-        prepareAudioGraph();
+    std::atomic<size_t> nextStem{0};
+    std::atomic<bool> allRendered{true};
+    
+    auto renderWorker = [&] {
+        for (size_t index = nextStem++; index < stemRenders.size(); index = nextStem++) {
+            auto& render = stemRenders[index];
+            
+            OfflineWavWriter writer(prepareInfo.numChannels, prepareInfo.maxBufferSize, params.writeQueueDepth);
+            if (!writer.open(render.outputFilePath, prepareInfo.sampleRate)) {
+                allRendered = false;
+                continue;
+            }
+            
+            bool rendered = renderBlocks(writer, totalSamples, prepareInfo.maxBufferSize, 0,
+                [&](choc::buffer::ChannelArrayView<const float> input, choc::buffer::ChannelArrayView<float> output, int numSamples) {
+                    render.processor->processGraph(input, output, prepareInfo.sampleRate, numSamples);
+                });
+            
+            if (!writer.finish() || !rendered) {
+                Logger::error("Failed to write stem: {}", render.outputFilePath);
+                allRendered = false;
+                continue;
+            }
+            Logger::info("Stem rendered: {}", render.outputFilePath);
+        }
+    };
+    
+    std::vector<std::thread> renderThreads;
+    for (unsigned int i = 0; i < numThreads; ++i) {
+        renderThreads.emplace_back(renderWorker);
+    }
+    for (auto& thread : renderThreads) {
+        thread.join();
     }
     
-    return false;
+    if (borrowedNodes) {
+        prepareAudioGraph();
+    }
+    return allRendered;
 }
 
 int AudioEngine::calculateSamplesFromParams(const OfflineRenderParams& params) {
@@ -1,27 +1,36 @@
 #pragma once
 
 #include <portaudio.h>
+#include "AudioDeviceBackend.h"
+#include "ThreadScheduling.h"
 #include <vector>
 #include <string>
 #include <memory>
+#include <thread>
+#include <atomic>
+#include <array>
+#include <functional>
+#include <algorithm>
 #include "AudioGraph.h"
 #include "../../lib/choc/audio/choc_SampleBuffers.h"
 #include "AudioNode.h"
 #include "../../lib/choc/audio/choc_SampleBuffers.h"
 #include "../../lib/choc/audio/choc_AudioFileFormat_WAV.h"
+#include "../../lib/choc/audio/choc_MIDI.h"
+#include "../../lib/choc/containers/choc_SingleReaderMultipleWriterFIFO.h"
+
+class OfflineWavWriter;
+class AudioParameter;
 
 class AudioEngine {
 public:
-    struct DeviceInfo {
-        int index;
-        std::string name;
-        int maxInputChannels;
-        int maxOutputChannels;
-        double defaultSampleRate;
-    };
+    using DeviceInfo = AudioDeviceInfo;
 
-    AudioEngine();
+    // Runs on PortAudio unless given another backend (e.g. NullAudioBackend for headless machines)
+    explicit AudioEngine(std::unique_ptr<AudioDeviceBackend> deviceBackend = nullptr);
     ~AudioEngine();
+    
+    AudioDeviceBackend& getDeviceBackend() { return *backend; }
 
     const std::vector<DeviceInfo>& getInputDevices() const { return inputDevices; }
     const std::vector<DeviceInfo>& getOutputDevices() const { return outputDevices; }
@@ -34,6 +43,32 @@ public:
     void setBufferSize(int bufferSize);
     void setSampleRate(double sampleRate);
     int getBufferSize() const { return bufferSize; }
+    
+    // Largest block the graph and callback buffers are prepared for (0 = the requested buffer
+    // size). Hosts may deliver a different or varying callback size; anything longer than this
+    // is processed in pieces, so nothing is allocated on the audio thread. Takes effect on the
+    // next startStream.
+    void setMaxBlockSize(int frames) { maxBlockSize = std::max(0, frames); }
+    int getMaxBlockSize() const;
+    
+    // Run the graph in fixed blocks of this many frames (e.g. 32 or 64) whatever size the
+    // host calls back with; 0 = process host blocks as they come. Host blocks that aren't a
+    // multiple of it are buffered, which adds one block of latency from then on. Takes
+    // effect on the next startStream.
+    void setInternalBlockSize(int frames) { internalBlockSize = std::max(0, frames); }
+    int getInternalBlockSize() const { return internalBlockSize; }
+    
+    // Sample-accurate events for the running stream, callable from any thread. Times are
+    // graph sample positions (see getGraphSamplePosition); blocks are split so each event
+    // lands on exactly its sample, and events already due apply at the start of the next
+    // block. The target must stay alive until the event has been delivered. Returns false
+    // if the event queue is full.
+    bool scheduleParameterChange(AudioParameter& parameter, float value, int64_t samplePosition,
+                                 float rampTimeMs = 0.0f);
+    bool scheduleMidiMessage(AudioNode& node, const choc::midi::ShortMessage& message, int64_t samplePosition);
+    
+    // Samples the graph has rendered since startStream (the position of the next one)
+    int64_t getGraphSamplePosition() const { return graphSamplePosition.load(std::memory_order_relaxed); }
     double getSampleRate() const { return sampleRate; }
     
     // Channel configuration
@@ -43,10 +78,72 @@ public:
     int getInputChannels() const { return inputChannels; }
     int getOutputChannels() const { return outputChannels; }
 
+    // Ask for non-interleaved device buffers so the graph runs directly on the host's channel
+    // pointers (no conversion copies). Takes effect on the next startStream; host APIs that
+    // can't do it fall back to interleaved.
+    void setNonInterleavedMode(bool enabled) { nonInterleavedRequested = enabled; }
+    bool isNonInterleavedMode() const { return nonInterleavedRequested; }
+    bool isStreamNonInterleaved() const { return nonInterleavedActive; }
+
+    // Real-time scheduling and affinity for the audio callback thread, applied by that thread
+    // at the start of each stream's first callback. Set while the stream is stopped.
+    void setAudioThreadScheduling(const ThreadScheduling::Settings& settings);
+    // Same for graph worker threads (see AudioGraphProcessor::setWorkerThreadScheduling);
+    // restarts the workers, so not while the stream is running
+    void setGraphWorkerScheduling(const ThreadScheduling::Settings& settings);
+    
+    // Lock the process's memory (mlockall) so the audio thread never page-faults
+    bool lockMemory();
+    void unlockMemory();
+    
+    // What each request above actually got
+    struct SchedulingReport {
+        ThreadScheduling::Result audioThread;  // NotRequested until the first callback has run
+        std::vector<ThreadScheduling::Result> graphWorkers;
+        bool memoryLocked = false;
+    };
+    SchedulingReport getSchedulingReport() const;
+
     // Audio graph integration
     AudioGraph* getAudioGraph() { return audioGraph.get(); }
     AudioGraphProcessor* getProcessor() { return processor.get(); }
     void prepareAudioGraph();
+    
+    // Parallel graph processing: 0 workers runs everything on the audio thread.
+    // Change only while the stream is stopped.
+    void setGraphWorkerThreads(int numWorkers);
+    int getGraphWorkerThreads() const { return graphWorkerThreads; }
+
+    // Stream health as reported by PortAudio's status flags and time info. Counters are
+    // lock-free and restart with each startStream; poll getStreamStats from any thread.
+    struct XrunEvent {
+        PaStreamCallbackFlags flags = 0;  // paInputUnderflow, paInputOverflow, paOutputUnderflow, paOutputOverflow
+        double callbackTime = 0.0;        // timeInfo->currentTime (stream clock, seconds)
+        uint64_t samplePosition = 0;      // Frames the stream had processed when it happened
+        double graphLoad = 0.0;           // Previous callback's time over its buffer duration
+    };
+    
+    struct StreamStats {
+        uint64_t callbacks = 0;
+        uint64_t samplesProcessed = 0;
+        uint64_t inputUnderflows = 0;
+        uint64_t inputOverflows = 0;
+        uint64_t outputUnderflows = 0;
+        uint64_t outputOverflows = 0;
+        double graphLoad = 0.0;          // Last callback's time over its buffer duration
+        double peakGraphLoad = 0.0;
+        
+        // Output DAC clock against the sample counter since the stream started (or the last
+        // xrun): seconds the device ran ahead, and the same as a rate in parts per million.
+        // Zero when the host API doesn't report DAC times.
+        double clockDriftSeconds = 0.0;
+        double clockDriftPpm = 0.0;
+        
+        std::vector<XrunEvent> recentXruns;  // Oldest first, at most maxRecentXruns
+    };
+    
+    static constexpr int maxRecentXruns = 64;
+    StreamStats getStreamStats() const;
 
     // Device utilities
     int getDefaultOutputDeviceIndex() const;
@@ -68,9 +165,20 @@ public:
         double renderSampleRate = 44100.0; // Sample rate for offline render
         int renderBufferSize = 1024;       // Buffer size for processing chunks
         bool includeInput = false;         // Whether to include input buffers (silent for offline)
+        int writeQueueDepth = 8;           // Rendered chunks in flight to the background file writer
+        
+        // Stems: render each of these nodes (with everything feeding it) to its own file instead of
+        // outputFilePath. Stems render in parallel, each on cloned nodes (see AudioNode::clone).
+        struct Stem {
+            std::shared_ptr<AudioNode> node;
+            std::string outputFilePath;
+        };
+        std::vector<Stem> stems;
+        int stemRenderThreads = 0;         // 0 = one per hardware thread
     };
     
-    // Perform offline render
+    // Perform offline render. Renders cloned nodes (see AudioNode::clone), so it can run alongside
+    // a live stream; nodes that can't be cloned are only rendered while no stream is running.
     bool renderOffline(const OfflineRenderParams& params);
     
     // Helper to calculate samples from different time units
@@ -87,21 +195,110 @@ private:
 
     void enumerateDevices();
     void ensureCallbackBuffersSize(int inputChannels, int outputChannels, int bufferSize);
+    void processDeviceBlock(const void* inputBuffer, void* outputBuffer, int frameOffset, int numFrames);
+    void processHostBlock(choc::buffer::ChannelArrayView<const float> input, choc::buffer::ChannelArrayView<float> output);
+    void renderGraph(choc::buffer::ChannelArrayView<const float> input, choc::buffer::ChannelArrayView<float> output);
+    bool renderStems(const OfflineRenderParams& params, int totalSamples, const AudioNode::PrepareInfo& prepareInfo);
+    bool renderMix(const OfflineRenderParams& params, int totalSamples, const AudioNode::PrepareInfo& prepareInfo);
+    bool renderBlocks(OfflineWavWriter& writer, int totalSamples, int blockSize, int numInputChannels,
+                      const std::function<void(choc::buffer::ChannelArrayView<const float>,
+                                               choc::buffer::ChannelArrayView<float>, int)>& processBlock);
+    void recordCallbackStatus(const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags,
+                              unsigned long framesPerBuffer);
+    void resetStreamStats();
+    
+    // Background graph compilation (keeps compileGraph off the audio thread)
+    void startGraphCompiler();
+    void stopGraphCompiler();
+    void graphCompilerThreadFunction();
+    void publishCompiledGraph();
 
-    // PortAudio members
-    PaStream* stream = nullptr;
+    // Device members
+    std::unique_ptr<AudioDeviceBackend> backend;
     std::vector<DeviceInfo> inputDevices;
     std::vector<DeviceInfo> outputDevices;
     int bufferSize = 0;
+    int maxBlockSize = 0;
+    static constexpr int defaultMaxBlockSize = 1024;  // When no buffer size was requested either
+    int internalBlockSize = 0;
     double sampleRate = 0.0;
     int inputChannels = 0;   // Current input channel count
     int outputChannels = 2;  // Default to stereo output
+    bool nonInterleavedRequested = false;
+    bool nonInterleavedActive = false;  // Format of the currently open stream
+    
+    // Written only by the audio thread; read with relaxed loads by getStreamStats
+    struct StreamCounters {
+        std::atomic<uint64_t> callbacks{0};
+        std::atomic<uint64_t> samplesProcessed{0};
+        std::atomic<uint64_t> inputUnderflows{0};
+        std::atomic<uint64_t> inputOverflows{0};
+        std::atomic<uint64_t> outputUnderflows{0};
+        std::atomic<uint64_t> outputOverflows{0};
+        std::atomic<double> graphLoad{0.0};
+        std::atomic<double> peakGraphLoad{0.0};
+        std::atomic<double> clockDriftSeconds{0.0};
+        std::atomic<double> clockDriftPpm{0.0};
+        
+        // Drift is measured from here; re-anchored after every xrun
+        double anchorDacTime = 0.0;
+        uint64_t anchorSamples = 0;
+        bool anchored = false;
+        
+        // Ring of recent xruns: a slot is written before xrunCount is bumped
+        struct EventSlot {
+            std::atomic<PaStreamCallbackFlags> flags{0};
+            std::atomic<double> callbackTime{0.0};
+            std::atomic<uint64_t> samplePosition{0};
+            std::atomic<double> graphLoad{0.0};
+        };
+        std::array<EventSlot, maxRecentXruns> events;
+        std::atomic<uint64_t> xrunCount{0};
+    };
+    StreamCounters streamCounters;
 
     // Audio graph system
     std::unique_ptr<AudioGraph> audioGraph;
     std::unique_ptr<AudioGraphProcessor> processor;
+    int graphWorkerThreads = 0;
+    std::thread graphCompilerThread;
+    std::atomic<bool> shouldStopGraphCompiler{false};
+    static constexpr int graphCompilerPollMs = 10;
+    
+    // Thread scheduling
+    ThreadScheduling::Settings audioThreadScheduling;
+    std::atomic<bool> audioThreadSchedulingPending{false};
+    std::atomic<ThreadScheduling::Outcome> audioThreadSchedulingOutcome{ThreadScheduling::Outcome::NotRequested};
+    std::atomic<ThreadScheduling::Outcome> audioThreadAffinityOutcome{ThreadScheduling::Outcome::NotRequested};
+    bool memoryLocked = false;
     
     // Pre-allocated buffers for audio callback (to avoid real-time allocations)
     choc::buffer::ChannelArrayBuffer<float> callbackInputBuffer;
     choc::buffer::ChannelArrayBuffer<float> callbackOutputBuffer;
+    
+    // Internal block buffering (audio thread only). Once host blocks stop lining up with the
+    // internal block size, input collects here and output plays one block behind:
+    // quantumInputFill + quantumOutputPending == internalBlockSize.
+    choc::buffer::ChannelArrayBuffer<float> quantumInputBuffer;
+    choc::buffer::ChannelArrayBuffer<float> quantumOutputBuffer;
+    int quantumInputFill = 0;
+    int quantumOutputPending = 0;  // Rendered frames not yet handed to the host
+    
+    // Scheduled events: any thread pushes, the audio thread moves them into pendingEvents
+    // (kept sorted latest-first, so the next one due is at the back)
+    struct ScheduledEvent {
+        int64_t samplePosition = 0;
+        AudioParameter* parameter = nullptr;  // Parameter change if set, else MIDI for node
+        float value = 0.0f;
+        float rampTimeMs = 0.0f;
+        AudioNode* node = nullptr;
+        choc::midi::ShortMessage message;
+    };
+    static constexpr size_t maxScheduledEvents = 1024;
+    choc::fifo::SingleReaderMultipleWriterFIFO<ScheduledEvent> eventQueue;
+    std::vector<ScheduledEvent> pendingEvents;  // Capacity reserved up front
+    std::atomic<int64_t> graphSamplePosition{0};
+    
+    bool pushScheduledEvent(const ScheduledEvent& event);
+    void collectScheduledEvents();
 };
\ No newline at end of file
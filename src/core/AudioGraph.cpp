@@ -1,11 +1,13 @@
 #include "AudioGraph.h"
 #include "Logger.h"
 #include <algorithm>
-#include <queue>
+#include <iterator>
+#include <limits>
 #include <unordered_set>
 #include <cstring>
 #include <iostream>
 #include "Spinlock.h"
+#include "AudioKernels.h"
 
 
 AudioGraph::AudioGraph() {
@@ -19,30 +21,75 @@ void AudioGraph::addNode(std::shared_ptr<AudioNode> node) {
     // Check if node already exists
     auto it = std::find(nodes.begin(), nodes.end(), node);
     if (it == nodes.end()) {
-        nodes.push_back(node);
-        connections[node] = std::vector<std::shared_ptr<AudioNode>>();
+        addNodeLocked(node);
         markDirty();
     }
 }
 
+void AudioGraph::addNodeLocked(const std::shared_ptr<AudioNode>& node) {
+    nodes.push_back(node);
+    connections[node] = std::vector<std::shared_ptr<AudioNode>>();
+    
+    // A node without connections can go anywhere in the order, so put it last
+    insertionOrder[node.get()] = nextInsertionOrder++;
+    topologicalOrder[node.get()] = nextTopologicalOrder++;
+    structureChanged = true;
+    markEdited(node);
+}
+
 void AudioGraph::removeNode(std::shared_ptr<AudioNode> node) {
     if (!node) return;
     
     SpinLockGuard lock(compilationLock);
     
-    // Remove from nodes list
-    nodes.erase(std::remove(nodes.begin(), nodes.end(), node), nodes.end());
+    // Drop the node from the reverse adjacency of everything it fed
+    auto targetsIt = connections.find(node);
+    if (targetsIt != connections.end()) {
+        for (auto& target : targetsIt->second) {
+            auto& targetInputs = cachedInputs[target.get()];
+            targetInputs.erase(std::remove_if(targetInputs.begin(), targetInputs.end(),
+                                              [&node](const NodeInput& input) { return input.source == node; }),
+                               targetInputs.end());
+            markEdited(target);
+            markRewired(target);
+        }
+    }
+    markRewired(node);
+    schedulePositions.erase(node.get());
     
-    // Remove from output nodes if it's there
+    // Its sources lose a consumer
+    auto inputsIt = cachedInputs.find(node.get());
+    if (inputsIt != cachedInputs.end()) {
+        for (auto& input : inputsIt->second) {
+            markEdited(input.source);
+        }
+        cachedInputs.erase(inputsIt);
+    }
+    insertionOrder.erase(node.get());
+    topologicalOrder.erase(node.get());
+    
+    removeNodeLocked(node);
+    structureChanged = true;
+    markDirty();
+}
+
+void AudioGraph::removeNodeLocked(const std::shared_ptr<AudioNode>& node) {
+    nodes.erase(std::remove(nodes.begin(), nodes.end(), node), nodes.end());
     outputNodes.erase(std::remove(outputNodes.begin(), outputNodes.end(), node), outputNodes.end());
     
     // Remove all connections to and from this node
     connections.erase(node);
+    preparedNodes.erase(node.get());
     for (auto& [sourceNode, targets] : connections) {
         targets.erase(std::remove(targets.begin(), targets.end(), node), targets.end());
     }
-    
-    markDirty();
+    for (auto it = connectionPorts.begin(); it != connectionPorts.end();) {
+        if (it->first.first == node.get() || it->first.second == node.get()) {
+            it = connectionPorts.erase(it);
+        } else {
+            ++it;
+        }
+    }
 }
 
 void AudioGraph::clear() {
@@ -51,34 +98,79 @@ void AudioGraph::clear() {
     nodes.clear();
     outputNodes.clear();
     connections.clear();
+    connectionPorts.clear();
+    preparedNodes.clear();
+    cachedInputs.clear();
+    insertionOrder.clear();
+    topologicalOrder.clear();
+    cachedSortedNodes.clear();
+    schedulePositions.clear();
+    scheduleDiscoveries.clear();
+    discoveryPositions.clear();
+    discoveryScheduleSizes.clear();
+    scheduleResumePoint = 0;
+    editedNodes.clear();
+    cachedCompiledGraph.reset();
+    structureChanged = true;
     prepared = false;
     markDirty();
 }
 
-void AudioGraph::connectNodes(std::shared_ptr<AudioNode> source, std::shared_ptr<AudioNode> destination) {
-    if (!source || !destination) return;
+bool AudioGraph::connectNodes(std::shared_ptr<AudioNode> source, std::shared_ptr<AudioNode> destination, int inputPort) {
+    if (!source || !destination) return false;
+    
+    if (inputPort < 0 || inputPort >= destination->getNumInputPorts()) {
+        Logger::warn("Cannot connect to input port {} of '{}': node has {} input ports",
+                     inputPort, destination->getName(), destination->getNumInputPorts());
+        return false;
+    }
     
     SpinLockGuard lock(compilationLock);
     
     // Ensure both nodes are in the graph (without calling addNode to avoid recursive locking)
     auto sourceIt = std::find(nodes.begin(), nodes.end(), source);
     if (sourceIt == nodes.end()) {
-        nodes.push_back(source);
-        connections[source] = std::vector<std::shared_ptr<AudioNode>>();
+        addNodeLocked(source);
     }
     
     auto destIt = std::find(nodes.begin(), nodes.end(), destination);
     if (destIt == nodes.end()) {
-        nodes.push_back(destination);
-        connections[destination] = std::vector<std::shared_ptr<AudioNode>>();
+        addNodeLocked(destination);
+    }
+    
+    // Catch up after performGraphModification (unless it left a loop for compileGraph to report)
+    if (cachesStale && !hasCycle()) {
+        rebuildCaches();
     }
     
     // Add connection if it doesn't exist
     auto& targets = connections[source];
     if (std::find(targets.begin(), targets.end(), destination) == targets.end()) {
+        if (!cachesStale && !insertTopologicalEdge(source, destination)) {
+            Logger::warn("Not connecting '{}' to '{}': it would create a feedback loop",
+                         source->getName(), destination->getName());
+            return false;
+        }
+        
         targets.push_back(destination);
+        if (inputPort != 0) {
+            connectionPorts[{ source.get(), destination.get() }] = inputPort;
+        }
+        
+        // Keep each node's sources in insertion order, as a full rebuild would
+        auto& destinationInputs = cachedInputs[destination.get()];
+        uint64_t sourceOrder = insertionOrder[source.get()];
+        auto position = std::find_if(destinationInputs.begin(), destinationInputs.end(),
+            [&](const NodeInput& input) { return insertionOrder[input.source.get()] > sourceOrder; });
+        destinationInputs.insert(position, { source, inputPort });
+        
+        markEdited(source);
+        markEdited(destination);
+        markRewired(destination);
+        structureChanged = true;
         markDirty();
     }
+    return true;
 }
 
 void AudioGraph::disconnectNodes(std::shared_ptr<AudioNode> source, std::shared_ptr<AudioNode> destination) {
@@ -90,6 +182,21 @@ void AudioGraph::disconnectNodes(std::shared_ptr<AudioNode> source, std::shared_
     if (it != connections.end()) {
         auto& targets = it->second;
         targets.erase(std::remove(targets.begin(), targets.end(), destination), targets.end());
+        connectionPorts.erase({ source.get(), destination.get() });
+        
+        // Removing an edge never invalidates the topological order
+        auto inputsIt = cachedInputs.find(destination.get());
+        if (inputsIt != cachedInputs.end()) {
+            auto& destinationInputs = inputsIt->second;
+            destinationInputs.erase(std::remove_if(destinationInputs.begin(), destinationInputs.end(),
+                                                   [&source](const NodeInput& input) { return input.source == source; }),
+                                    destinationInputs.end());
+        }
+        
+        markEdited(source);
+        markEdited(destination);
+        markRewired(destination);
+        structureChanged = true;
         markDirty();
     }
 }
@@ -97,16 +204,21 @@ void AudioGraph::disconnectNodes(std::shared_ptr<AudioNode> source, std::shared_
 void AudioGraph::setOutputNode(std::shared_ptr<AudioNode> node) {
     SpinLockGuard lock(compilationLock);
     
+    for (auto& output : outputNodes) {
+        markEdited(output);
+    }
     outputNodes.clear();
     if (node) {
+        markEdited(node);
         outputNodes.push_back(node);
         // Ensure it's in the graph (without calling addNode to avoid recursive locking)
         auto it = std::find(nodes.begin(), nodes.end(), node);
         if (it == nodes.end()) {
-            nodes.push_back(node);
-            connections[node] = std::vector<std::shared_ptr<AudioNode>>();
+            addNodeLocked(node);
         }
     }
+    scheduleResumePoint = 0; // The schedule search starts from the outputs
+    structureChanged = true;
     markDirty();
 }
 
@@ -119,12 +231,14 @@ void AudioGraph::addOutputNode(std::shared_ptr<AudioNode> node) {
     auto it = std::find(outputNodes.begin(), outputNodes.end(), node);
     if (it == outputNodes.end()) {
         outputNodes.push_back(node);
+        markEdited(node);
         // Ensure it's in the graph (without calling addNode to avoid recursive locking)
         auto nodeIt = std::find(nodes.begin(), nodes.end(), node);
         if (nodeIt == nodes.end()) {
-            nodes.push_back(node);
-            connections[node] = std::vector<std::shared_ptr<AudioNode>>();
+            addNodeLocked(node);
         }
+        scheduleResumePoint = 0;
+        structureChanged = true;
         markDirty();
     }
 }
@@ -135,19 +249,248 @@ void AudioGraph::removeOutputNode(std::shared_ptr<AudioNode> node) {
     SpinLockGuard lock(compilationLock);
     
     outputNodes.erase(std::remove(outputNodes.begin(), outputNodes.end(), node), outputNodes.end());
+    markEdited(node);
+    scheduleResumePoint = 0;
+    structureChanged = true;
     markDirty();
 }
 
+bool AudioGraph::insertTopologicalEdge(const std::shared_ptr<AudioNode>& source, const std::shared_ptr<AudioNode>& destination) {
+    if (source == destination) {
+        return false;
+    }
+    
+    int lowerBound = topologicalOrder[destination.get()];
+    int upperBound = topologicalOrder[source.get()];
+    if (upperBound < lowerBound) {
+        return true; // Already ordered correctly
+    }
+    
+    // Pearce-Kelly: only nodes ranked between destination and source can be affected.
+    // Search forward from the destination; reaching the source means a cycle.
+    std::vector<std::shared_ptr<AudioNode>> forward, backward, stack;
+    std::unordered_set<AudioNode*> visited;
+    
+    stack.push_back(destination);
+    visited.insert(destination.get());
+    while (!stack.empty()) {
+        auto current = stack.back();
+        stack.pop_back();
+        forward.push_back(current);
+        
+        for (auto& target : connections[current]) {
+            if (target == source) {
+                return false;
+            }
+            if (topologicalOrder[target.get()] < upperBound && visited.insert(target.get()).second) {
+                stack.push_back(target);
+            }
+        }
+    }
+    
+    // ...and backward from the source
+    stack.push_back(source);
+    visited.insert(source.get());
+    while (!stack.empty()) {
+        auto current = stack.back();
+        stack.pop_back();
+        backward.push_back(current);
+        
+        for (auto& input : cachedInputs[current.get()]) {
+            if (topologicalOrder[input.source.get()] > lowerBound && visited.insert(input.source.get()).second) {
+                stack.push_back(input.source);
+            }
+        }
+    }
+    
+    // Hand the affected ranks back out: the source's ancestors first, then the destination's descendants
+    auto byRank = [this](const std::shared_ptr<AudioNode>& a, const std::shared_ptr<AudioNode>& b) {
+        return topologicalOrder[a.get()] < topologicalOrder[b.get()];
+    };
+    std::sort(forward.begin(), forward.end(), byRank);
+    std::sort(backward.begin(), backward.end(), byRank);
+    
+    std::vector<int> ranks;
+    ranks.reserve(forward.size() + backward.size());
+    for (auto& node : backward) ranks.push_back(topologicalOrder[node.get()]);
+    for (auto& node : forward) ranks.push_back(topologicalOrder[node.get()]);
+    std::sort(ranks.begin(), ranks.end());
+    
+    size_t next = 0;
+    for (auto& node : backward) topologicalOrder[node.get()] = ranks[next++];
+    for (auto& node : forward) topologicalOrder[node.get()] = ranks[next++];
+    return true;
+}
+
+void AudioGraph::rebuildCaches() {
+    cachedInputs = buildInputMap();
+    
+    insertionOrder.clear();
+    topologicalOrder.clear();
+    nextInsertionOrder = 0;
+    nextTopologicalOrder = 0;
+    for (auto& node : nodes) {
+        insertionOrder[node.get()] = nextInsertionOrder++;
+    }
+    
+    // Any valid order will do as a starting point, and the schedule is one
+    scheduleResumePoint = 0;
+    updateSchedule();
+    for (auto& node : cachedSortedNodes) {
+        topologicalOrder[node.get()] = nextTopologicalOrder++;
+    }
+    
+    // Nothing is known about what changed, so nothing from the last compile is reused
+    editedNodes.clear();
+    cachedCompiledGraph.reset();
+    
+    structureChanged = false;
+    cachesStale = false;
+}
+
+void AudioGraph::Transaction::addNode(std::shared_ptr<AudioNode> node) {
+    if (node) edits.push_back({ EditType::AddNode, std::move(node), nullptr });
+}
+
+void AudioGraph::Transaction::removeNode(std::shared_ptr<AudioNode> node) {
+    if (node) edits.push_back({ EditType::RemoveNode, std::move(node), nullptr });
+}
+
+void AudioGraph::Transaction::connectNodes(std::shared_ptr<AudioNode> source, std::shared_ptr<AudioNode> destination, int inputPort) {
+    if (!source || !destination) return;
+    
+    if (inputPort < 0 || inputPort >= destination->getNumInputPorts()) {
+        Logger::warn("Cannot connect to input port {} of '{}': node has {} input ports",
+                     inputPort, destination->getName(), destination->getNumInputPorts());
+        return;
+    }
+    edits.push_back({ EditType::Connect, std::move(source), std::move(destination), inputPort });
+}
+
+void AudioGraph::Transaction::disconnectNodes(std::shared_ptr<AudioNode> source, std::shared_ptr<AudioNode> destination) {
+    if (source && destination) edits.push_back({ EditType::Disconnect, std::move(source), std::move(destination) });
+}
+
+void AudioGraph::Transaction::addOutputNode(std::shared_ptr<AudioNode> node) {
+    if (node) edits.push_back({ EditType::AddOutput, std::move(node), nullptr });
+}
+
+void AudioGraph::Transaction::removeOutputNode(std::shared_ptr<AudioNode> node) {
+    if (node) edits.push_back({ EditType::RemoveOutput, std::move(node), nullptr });
+}
+
+bool AudioGraph::commitTransaction(Transaction& transaction) {
+    if (transaction.isEmpty()) return true;
+    
+    SpinLockGuard lock(compilationLock);
+    
+    // Keep the old structure so a rejected batch leaves no trace. The adjacency cache isn't
+    // touched while applying, but addNodeLocked ranks the staged nodes, so the ranks go too.
+    auto previousNodes = nodes;
+    auto previousOutputNodes = outputNodes;
+    auto previousConnections = connections;
+    auto previousConnectionPorts = connectionPorts;
+    auto previousPreparedNodes = preparedNodes;
+    auto previousInsertionOrder = insertionOrder;
+    auto previousTopologicalOrder = topologicalOrder;
+    auto previousNextInsertionOrder = nextInsertionOrder;
+    auto previousNextTopologicalOrder = nextTopologicalOrder;
+    bool previousStructureChanged = structureChanged;
+    
+    auto ensureNode = [this](const std::shared_ptr<AudioNode>& node) {
+        if (std::find(nodes.begin(), nodes.end(), node) == nodes.end()) {
+            addNodeLocked(node);
+        }
+    };
+    
+    for (auto& edit : transaction.edits) {
+        switch (edit.type) {
+            case Transaction::EditType::AddNode:
+                ensureNode(edit.node);
+                break;
+                
+            case Transaction::EditType::RemoveNode:
+                removeNodeLocked(edit.node);
+                break;
+                
+            case Transaction::EditType::Connect: {
+                ensureNode(edit.node);
+                ensureNode(edit.destination);
+                auto& targets = connections[edit.node];
+                if (std::find(targets.begin(), targets.end(), edit.destination) == targets.end()) {
+                    targets.push_back(edit.destination);
+                    connectionPorts.erase({ edit.node.get(), edit.destination.get() });
+                    if (edit.inputPort != 0) {
+                        connectionPorts[{ edit.node.get(), edit.destination.get() }] = edit.inputPort;
+                    }
+                }
+                break;
+            }
+                
+            case Transaction::EditType::Disconnect: {
+                auto it = connections.find(edit.node);
+                if (it != connections.end()) {
+                    auto& targets = it->second;
+                    targets.erase(std::remove(targets.begin(), targets.end(), edit.destination), targets.end());
+                    connectionPorts.erase({ edit.node.get(), edit.destination.get() });
+                }
+                break;
+            }
+                
+            case Transaction::EditType::AddOutput:
+                ensureNode(edit.node);
+                if (std::find(outputNodes.begin(), outputNodes.end(), edit.node) == outputNodes.end()) {
+                    outputNodes.push_back(edit.node);
+                }
+                break;
+                
+            case Transaction::EditType::RemoveOutput:
+                outputNodes.erase(std::remove(outputNodes.begin(), outputNodes.end(), edit.node), outputNodes.end());
+                break;
+        }
+    }
+    
+    // One cycle check for the whole batch
+    if (hasCycle()) {
+        nodes = std::move(previousNodes);
+        outputNodes = std::move(previousOutputNodes);
+        connections = std::move(previousConnections);
+        connectionPorts = std::move(previousConnectionPorts);
+        preparedNodes = std::move(previousPreparedNodes);
+        insertionOrder = std::move(previousInsertionOrder);
+        topologicalOrder = std::move(previousTopologicalOrder);
+        nextInsertionOrder = previousNextInsertionOrder;
+        nextTopologicalOrder = previousNextTopologicalOrder;
+        structureChanged = previousStructureChanged;
+        
+        Logger::warn("Graph transaction with {} edits rejected: it would create a feedback loop",
+                     transaction.getNumEdits());
+        return false;
+    }
+    
+    Logger::debug("Committed graph transaction with {} edits", transaction.getNumEdits());
+    transaction.edits.clear();
+    
+    // The caches are rebuilt in one pass by the single compile that follows
+    structureChanged = true;
+    cachesStale = true;
+    markDirty();
+    return true;
+}
+
 void AudioGraph::prepare(const AudioNode::PrepareInfo& info) {
     Logger::debug("Preparing AudioGraph with {} nodes...", nodes.size());
     SpinLockGuard lock(compilationLock);
     
     currentPrepareInfo = info;
+    cachedCompiledGraph.reset(); // Widths and latencies may change with the new settings
     
     // Prepare all nodes
+    preparedNodes.clear();
     for (auto& node : nodes) {
         if (node) {
             node->prepare(info);
+            preparedNodes.insert(node.get());
         }
     }
     
@@ -155,17 +498,103 @@ void AudioGraph::prepare(const AudioNode::PrepareInfo& info) {
     markDirty();
 }
 
+void AudioGraph::markDirty() {
+    {
+        std::lock_guard<std::mutex> lock(dirtyMutex);
+        isDirty.store(true);
+    }
+    dirtyCondition.notify_all();
+}
+
+bool AudioGraph::waitForChanges(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(dirtyMutex);
+    return dirtyCondition.wait_for(lock, timeout, [this] { return isDirty.load(); });
+}
+
+void AudioGraph::setParallelProcessing(bool enabled) {
+    SpinLockGuard lock(compilationLock);
+    
+    if (parallelProcessing != enabled) {
+        parallelProcessing = enabled;
+        cachedCompiledGraph.reset();
+        markDirty();
+    }
+}
+
+void AudioGraph::setIncrementalCompilation(bool enabled) {
+    SpinLockGuard lock(compilationLock);
+    
+    if (incrementalCompilation != enabled) {
+        incrementalCompilation = enabled;
+        structureChanged = true;
+        markDirty();
+    }
+}
+
 void AudioGraph::performGraphModification(std::function<void()> modification) {
     SpinLockGuard lock(compilationLock);
     modification();
+    
+    // We can't tell what changed, so rebuild the caches on the next compile
+    structureChanged = true;
+    cachesStale = true;
     markDirty();
 }
 
+std::vector<std::shared_ptr<AudioNode>> AudioGraph::getUpstreamNodes(const std::shared_ptr<AudioNode>& node) const {
+    SpinLockGuard lock(compilationLock);
+    return collectUpstreamNodes(node, buildInputMap());
+}
+
+bool AudioGraph::copySubgraph(const std::shared_ptr<AudioNode>& outputNode, AudioGraph& destination,
+                              const NodeCopier& copyNode) const {
+    std::vector<std::shared_ptr<AudioNode>> upstream;
+    InputMap inputs;
+    {
+        SpinLockGuard lock(compilationLock);
+        inputs = buildInputMap();
+        upstream = collectUpstreamNodes(outputNode, inputs);
+    }
+    
+    if (upstream.empty()) {
+        Logger::error("Cannot copy subgraph: output node is not in the graph");
+        return false;
+    }
+    
+    // Copy outside the lock: cloning a node can mean copying a lot of sample data
+    std::unordered_map<AudioNode*, std::shared_ptr<AudioNode>> copies;
+    for (const auto& node : upstream) {
+        auto copy = copyNode(node);
+        if (!copy) {
+            Logger::error("Cannot copy subgraph: node '{}' could not be copied", node->getName());
+            return false;
+        }
+        copies[node.get()] = std::move(copy);
+    }
+    
+    auto transaction = destination.beginTransaction();
+    for (const auto& node : upstream) {
+        transaction.addNode(copies[node.get()]);
+    }
+    for (const auto& node : upstream) {
+        auto it = inputs.find(node.get());
+        if (it == inputs.end()) continue;
+        for (const auto& input : it->second) {
+            transaction.connectNodes(copies[input.source.get()], copies[node.get()], input.port);
+        }
+    }
+    transaction.addOutputNode(copies[outputNode.get()]);
+    
+    return destination.commitTransaction(transaction);
+}
+
 std::shared_ptr<AudioGraph::CompiledGraph> AudioGraph::getCompiledGraph() {
-    if (needsRecompile()) {
+    std::lock_guard<std::mutex> lock(compiledGraphMutex);
+    
+    // Clear the flag before compiling so an edit made meanwhile triggers another pass
+    if (isDirty.exchange(false)) {
         Logger::debug("Graph recompiling...");
         currentCompiledGraph = compileGraph();
-        isDirty.store(false);
     }
     return currentCompiledGraph;
 }
@@ -179,99 +608,609 @@ std::shared_ptr<AudioGraph::CompiledGraph> AudioGraph::compileGraph() {
         return compiled;
     }
     
-    // Check for cycles
-    if (hasCycle()) {
-        // Handle cycle error - for now, return empty graph
-        return compiled;
+    // Nodes added since the last prepare() get prepared here, off the audio thread
+    for (auto& node : nodes) {
+        if (preparedNodes.insert(node.get()).second) {
+            node->prepare(currentPrepareInfo);
+        }
     }
     
-    // Topological sort to determine processing order
-    auto sortedNodes = topologicalSort();
+    // connectNodes() refuses feedback loops, so the full cycle check is only needed
+    // when the caches can't be trusted
+    if (!incrementalCompilation || cachesStale) {
+        if (hasCycle()) {
+            // Handle cycle error - for now, return empty graph
+            return compiled;
+        }
+        if (incrementalCompilation) {
+            rebuildCaches();
+        }
+    }
     
-    // Create processing instructions
+    // Topological sort to determine processing order, searched again only from the first rewired node
+    InputMap rebuiltInputs;
+    if (!incrementalCompilation) {
+        rebuiltInputs = buildInputMap();
+    }
+    const InputMap& inputs = incrementalCompilation ? cachedInputs : rebuiltInputs;
+    
+    std::vector<std::shared_ptr<AudioNode>> rebuiltSchedule;
+    if (!incrementalCompilation) {
+        rebuiltSchedule = topologicalSort(inputs);
+    } else if (structureChanged) {
+        updateSchedule();
+        structureChanged = false;
+    }
+    const auto& sortedNodes = incrementalCompilation ? cachedSortedNodes : rebuiltSchedule;
+    
+    // Create processing instructions, carrying over everything scheduled before the first edit
+    size_t numReused = 0;
+    if (incrementalCompilation) {
+        numReused = countReusableInstructions(sortedNodes);
+        editedNodes.clear();
+    }
     compiled->instructions.reserve(sortedNodes.size());
-    assignBufferIndices(sortedNodes, compiled->instructions);
+    compiled->numTempBuffers = assignBufferIndices(sortedNodes, inputs, numReused, compiled->instructions);
     
-    // Set the number of temp buffers needed
-    compiled->numTempBuffers = static_cast<int>(sortedNodes.size());
+    // Record how many channels each (possibly shared) temp buffer carries
+    compiled->tempBufferChannels.assign(compiled->numTempBuffers, 1);
+    for (const auto& instruction : compiled->instructions) {
+        auto& channels = compiled->tempBufferChannels[instruction.outputBufferIndex];
+        channels = std::max(channels, instruction.numOutputChannels);
+        
+        for (const auto& sum : instruction.inputSums) {
+            auto& junctionChannels = compiled->tempBufferChannels[sum.bufferIndex];
+            junctionChannels = std::max(junctionChannels, sum.numChannels);
+        }
+    }
+    
+    // Instructions that can start as soon as a block begins
+    for (int i = 0; i < static_cast<int>(compiled->instructions.size()); ++i) {
+        if (compiled->instructions[i].numDependencies == 0) {
+            compiled->rootInstructions.push_back(i);
+        }
+    }
+    
+    // Resolve where each output node's result lands so the mix doesn't have to search
+    std::unordered_map<AudioNode*, int> nodeToInstruction;
+    for (int i = 0; i < static_cast<int>(compiled->instructions.size()); ++i) {
+        nodeToInstruction[compiled->instructions[i].node.get()] = i;
+    }
+    for (auto& node : outputNodes) {
+        auto it = nodeToInstruction.find(node.get());
+        if (it != nodeToInstruction.end()) {
+            const auto& instruction = compiled->instructions[it->second];
+            compiled->outputInstructions.push_back(it->second);
+            compiled->outputBufferIndices.push_back(instruction.outputBufferIndex);
+            compiled->outputChannelCounts.push_back(instruction.numOutputChannels);
+            compiled->latencySamples = std::max(compiled->latencySamples, instruction.latencySamples);
+        }
+    }
+    
+    // Outputs that arrive early are delayed to line up with the slowest one
+    for (int outputInstruction : compiled->outputInstructions) {
+        compiled->outputDelaySamples.push_back(compiled->latencySamples
+                                               - compiled->instructions[outputInstruction].latencySamples);
+    }
+    
+    if (compiled->latencySamples > 0) {
+        Logger::debug("Graph latency: {} samples", compiled->latencySamples);
+    }
     
     // Set output nodes
     compiled->outputNodes = outputNodes;
     compiled->prepared = prepared;
     compiled->prepareInfo = currentPrepareInfo;
+    
+    if (incrementalCompilation) {
+        cachedCompiledGraph = compiled;
+    }
     return compiled;
 }
 
-std::vector<std::shared_ptr<AudioNode>> AudioGraph::topologicalSort() {
-    std::vector<std::shared_ptr<AudioNode>> result;
-    std::unordered_map<std::shared_ptr<AudioNode>, int> inDegree;
-    
-    // Initialize in-degree count
-    for (auto& node : nodes) {
-        inDegree[node] = 0;
+AudioGraph::InputMap AudioGraph::buildInputMap() const {
+    // Walk sources in insertion order so the schedule and input order are deterministic
+    InputMap inputs;
+    inputs.reserve(nodes.size());
+    for (auto& source : nodes) {
+        auto it = connections.find(source);
+        if (it != connections.end()) {
+            for (auto& target : it->second) {
+                auto portIt = connectionPorts.find({ source.get(), target.get() });
+                int port = (portIt != connectionPorts.end()) ? portIt->second : 0;
+                inputs[target.get()].push_back({ source, port });
+            }
+        }
+    }
+    return inputs;
+}
+
+std::vector<std::shared_ptr<AudioNode>> AudioGraph::collectUpstreamNodes(const std::shared_ptr<AudioNode>& node,
+                                                                          const InputMap& inputs) const {
+    if (!node || std::find(nodes.begin(), nodes.end(), node) == nodes.end()) {
+        return {};
     }
     
-    // Calculate in-degrees
-    for (auto& [source, targets] : connections) {
-        for (auto& target : targets) {
-            inDegree[target]++;
+    std::unordered_set<AudioNode*> reached { node.get() };
+    std::vector<AudioNode*> pending { node.get() };
+    while (!pending.empty()) {
+        AudioNode* current = pending.back();
+        pending.pop_back();
+        
+        auto it = inputs.find(current);
+        if (it == inputs.end()) continue;
+        for (const auto& input : it->second) {
+            if (reached.insert(input.source.get()).second) {
+                pending.push_back(input.source.get());
+            }
         }
     }
     
-    // Queue for nodes with no incoming edges
-    std::queue<std::shared_ptr<AudioNode>> queue;
-    for (auto& [node, degree] : inDegree) {
-        if (degree == 0) {
-            queue.push(node);
+    std::vector<std::shared_ptr<AudioNode>> upstream;
+    for (const auto& candidate : nodes) {
+        if (reached.count(candidate.get())) {
+            upstream.push_back(candidate);
         }
     }
+    return upstream;
+}
+
+std::vector<std::shared_ptr<AudioNode>> AudioGraph::topologicalSort(const InputMap& inputs) {
+    std::vector<std::shared_ptr<AudioNode>> result;
+    result.reserve(nodes.size());
+    static const std::vector<NodeInput> noInputs;
     
-    // Process nodes
-    while (!queue.empty()) {
-        auto current = queue.front();
-        queue.pop();
-        result.push_back(current);
+    // Depth-first post-order over inputs, starting from the outputs. Each branch is
+    // finished before the next one starts, which keeps few buffers live at once.
+    std::unordered_set<std::shared_ptr<AudioNode>> visited;
+    std::vector<std::pair<std::shared_ptr<AudioNode>, size_t>> stack;
+    
+    auto visit = [&](const std::shared_ptr<AudioNode>& start) {
+        if (!visited.insert(start).second) return;
+        stack.emplace_back(start, 0);
         
-        // Reduce in-degree for connected nodes
-        auto it = connections.find(current);
-        if (it != connections.end()) {
-            for (auto& target : it->second) {
-                inDegree[target]--;
-                if (inDegree[target] == 0) {
-                    queue.push(target);
+        while (!stack.empty()) {
+            auto& [current, nextInput] = stack.back();
+            auto inputsIt = inputs.find(current.get());
+            auto& currentInputs = (inputsIt != inputs.end()) ? inputsIt->second : noInputs;
+            
+            if (nextInput < currentInputs.size()) {
+                auto input = currentInputs[nextInput++].source;
+                if (visited.insert(input).second) {
+                    stack.emplace_back(input, 0);
                 }
+            } else {
+                result.push_back(current);
+                stack.pop_back();
             }
         }
+    };
+    
+    for (auto& node : outputNodes) {
+        visit(node);
+    }
+    
+    // Nodes that don't feed an output (meters, recorders, ...) still need to run
+    for (auto& node : nodes) {
+        visit(node);
     }
     
     return result;
 }
 
-void AudioGraph::assignBufferIndices(const std::vector<std::shared_ptr<AudioNode>>& sortedNodes, 
-                                    std::vector<ProcessingInstruction>& instructions) {
-    std::unordered_map<std::shared_ptr<AudioNode>, int> nodeToBufferIndex;
-    int nextBufferIndex = 0;
+void AudioGraph::markRewired(const std::shared_ptr<AudioNode>& node) {
+    // The schedule search only reads a node's inputs once it reaches the node, so it runs as
+    // before up to the earliest rewired node it reached last time. New nodes are reached
+    // through a rewired consumer or after everything else.
+    auto it = schedulePositions.find(node.get());
+    if (it != schedulePositions.end() && it->second >= 0) {
+        scheduleResumePoint = std::min(scheduleResumePoint, static_cast<size_t>(scheduleDiscoveries[it->second]));
+    }
+}
+
+void AudioGraph::updateSchedule() {
+    // Same search as topologicalSort, over the cached inputs, recording enough to resume it
+    static const std::vector<NodeInput> noInputs;
+    auto& schedule = cachedSortedNodes;
+    
+    struct Frame {
+        std::shared_ptr<AudioNode> node;
+        size_t nextInput;
+        int discovery;
+    };
+    std::vector<Frame> stack;
+    
+    auto inputsOf = [this](AudioNode* node) -> const std::vector<NodeInput>& {
+        auto it = cachedInputs.find(node);
+        return (it != cachedInputs.end()) ? it->second : noInputs;
+    };
+    
+    // Positions past the kept part of the schedule are stale until the node is scheduled again
+    auto isDiscovered = [&](AudioNode* node) {
+        auto it = schedulePositions.find(node);
+        if (it == schedulePositions.end()) return false;
+        int position = it->second;
+        return position < 0 || (position < static_cast<int>(schedule.size()) && schedule[position].get() == node);
+    };
+    
+    auto discover = [&](const std::shared_ptr<AudioNode>& node) {
+        int discovery = static_cast<int>(discoveryScheduleSizes.size());
+        discoveryScheduleSizes.push_back(static_cast<int>(schedule.size()));
+        discoveryPositions.push_back(-1);
+        schedulePositions[node.get()] = -1;
+        stack.push_back({ node, 0, discovery });
+    };
+    
+    auto search = [&]() {
+        while (!stack.empty()) {
+            auto& frame = stack.back();
+            const auto& frameInputs = inputsOf(frame.node.get());
+            if (frame.nextInput < frameInputs.size()) {
+                const auto& input = frameInputs[frame.nextInput++].source;
+                if (!isDiscovered(input.get())) {
+                    discover(input);
+                }
+            } else {
+                int position = static_cast<int>(schedule.size());
+                schedulePositions[frame.node.get()] = position;
+                discoveryPositions[frame.discovery] = position;
+                scheduleDiscoveries.push_back(frame.discovery);
+                schedule.push_back(std::move(frame.node));
+                stack.pop_back();
+            }
+        }
+    };
+    
+    auto restart = [&]() {
+        schedule.clear();
+        schedulePositions.clear();
+        scheduleDiscoveries.clear();
+        discoveryPositions.clear();
+        discoveryScheduleSizes.clear();
+        stack.clear();
+    };
+    
+    size_t resumeDiscovery = std::min(scheduleResumePoint, discoveryPositions.size());
+    if (resumeDiscovery == 0) {
+        restart();
+    } else {
+        // Keep what was scheduled before the search reached the resume node, and put the nodes
+        // it was still inside of back on the stack in the order it entered them
+        size_t keptSize = (resumeDiscovery < discoveryScheduleSizes.size())
+                          ? static_cast<size_t>(discoveryScheduleSizes[resumeDiscovery]) : schedule.size();
+        std::shared_ptr<AudioNode> resumeNode;
+        if (resumeDiscovery < discoveryPositions.size()) {
+            // removeNode drops the position, so a node removed (and maybe added back) since
+            // has none. It was reached as a root, so nothing was in progress.
+            int position = discoveryPositions[resumeDiscovery];
+            auto it = schedulePositions.find(schedule[position].get());
+            if (it != schedulePositions.end() && it->second == position) {
+                resumeNode = schedule[position];
+            }
+        }
+        
+        std::vector<Frame> unfinished;
+        for (size_t position = keptSize; position < schedule.size(); ++position) {
+            if (scheduleDiscoveries[position] < static_cast<int>(resumeDiscovery)) {
+                unfinished.push_back({ schedule[position], 0, scheduleDiscoveries[position] });
+            }
+        }
+        std::sort(unfinished.begin(), unfinished.end(),
+                  [](const Frame& a, const Frame& b) { return a.discovery < b.discovery; });
+        
+        // Each one continues after the input the search went into
+        bool consistent = unfinished.empty() || resumeNode;
+        for (size_t i = 0; consistent && i < unfinished.size(); ++i) {
+            AudioNode* next = (i + 1 < unfinished.size()) ? unfinished[i + 1].node.get() : resumeNode.get();
+            const auto& frameInputs = inputsOf(unfinished[i].node.get());
+            auto it = std::find_if(frameInputs.begin(), frameInputs.end(),
+                                   [next](const NodeInput& input) { return input.source.get() == next; });
+            consistent = (it != frameInputs.end());
+            unfinished[i].nextInput = static_cast<size_t>(it - frameInputs.begin()) + 1;
+        }
+        
+        if (!consistent) {
+            restart();
+        } else {
+            schedule.resize(keptSize);
+            scheduleDiscoveries.resize(keptSize);
+            discoveryScheduleSizes.resize(resumeDiscovery);
+            discoveryPositions.resize(resumeDiscovery);
+            for (auto& frame : unfinished) {
+                schedulePositions[frame.node.get()] = -1;
+                discoveryPositions[frame.discovery] = -1;
+            }
+            stack = std::move(unfinished);
+            if (resumeNode) {
+                discover(resumeNode);
+            }
+            search();
+        }
+    }
+    
+    // Roots searched before the resume point are all discovered, so going over them again is cheap
+    for (auto& node : outputNodes) {
+        if (!isDiscovered(node.get())) {
+            discover(node);
+            search();
+        }
+    }
+    for (auto& node : nodes) {
+        if (!isDiscovered(node.get())) {
+            discover(node);
+            search();
+        }
+    }
+    
+    scheduleResumePoint = std::numeric_limits<size_t>::max();
+}
+
+size_t AudioGraph::countReusableInstructions(const std::vector<std::shared_ptr<AudioNode>>& sortedNodes) const {
+    if (!cachedCompiledGraph) return 0;
+    
+    // An instruction only depends on its node, its sources (all scheduled earlier) and the
+    // buffer state left by earlier instructions, so the run up to the first node that moved,
+    // was edited or changed width or latency compiles exactly as before
+    const auto& previous = cachedCompiledGraph->instructions;
+    size_t limit = std::min(previous.size(), sortedNodes.size());
+    size_t count = 0;
+    for (; count < limit; ++count) {
+        const auto& instruction = previous[count];
+        const auto& node = sortedNodes[count];
+        if (instruction.node != node || editedNodes.count(node.get())
+            || instruction.numOutputChannels != resolveNumOutputChannels(node)) {
+            break;
+        }
+        
+        int inputLatency = 0;
+        for (int source : instruction.sourceInstructions) {
+            inputLatency = std::max(inputLatency, previous[source].latencySamples);
+        }
+        if (instruction.latencySamples != inputLatency + std::max(0, node->getLatencySamples())) {
+            break;
+        }
+    }
+    return count;
+}
+
+int AudioGraph::assignBufferIndices(const std::vector<std::shared_ptr<AudioNode>>& sortedNodes,
+                                   const InputMap& inputs,
+                                   size_t numReused,
+                                   std::vector<ProcessingInstruction>& instructions) {
+    std::unordered_map<AudioNode*, int> nodeToInstruction;
+    nodeToInstruction.reserve(sortedNodes.size());
+    
+    // Per instruction: a buffer stays live until the last node reading it has run, and the
+    // outputs' buffers stay live to the end
+    std::vector<int> remainingConsumers;
+    std::vector<char> holdsOutput;
+    remainingConsumers.reserve(sortedNodes.size());
+    holdsOutput.reserve(sortedNodes.size());
+    auto addBookkeeping = [&](const std::shared_ptr<AudioNode>& node) {
+        auto targetsIt = connections.find(node);
+        remainingConsumers.push_back(targetsIt != connections.end() ? static_cast<int>(targetsIt->second.size()) : 0);
+        holdsOutput.push_back(std::find(outputNodes.begin(), outputNodes.end(), node) != outputNodes.end());
+    };
+    
+    std::vector<int> bufferChannels;          // Widest use of each buffer so far
+    std::vector<std::vector<int>> bufferUsers; // Instructions that wrote or read each buffer's current contents
+    std::vector<int> freeBuffers;
+    
+    auto addDependency = [&instructions](int from, ProcessingInstruction& to, int toIndex) {
+        auto& dependents = instructions[from].dependents;
+        if (std::find(dependents.begin(), dependents.end(), toIndex) == dependents.end()) {
+            dependents.push_back(toIndex);
+            to.numDependencies++;
+        }
+    };
+    
+    // Reuse a dead buffer, preferring the narrowest one that is already wide enough
+    auto acquireBuffer = [&](int numChannels) {
+        int bufferIndex;
+        if (!freeBuffers.empty() && !parallelProcessing) {
+            auto best = freeBuffers.begin();
+            for (auto it = freeBuffers.begin(); it != freeBuffers.end(); ++it) {
+                bool fits = bufferChannels[*it] >= numChannels;
+                bool bestFits = bufferChannels[*best] >= numChannels;
+                if ((fits && (!bestFits || bufferChannels[*it] < bufferChannels[*best]))
+                    || (!fits && !bestFits && bufferChannels[*it] > bufferChannels[*best])) {
+                    best = it;
+                }
+            }
+            bufferIndex = *best;
+            freeBuffers.erase(best);
+        } else {
+            bufferIndex = static_cast<int>(bufferChannels.size());
+            bufferChannels.push_back(0);
+            bufferUsers.emplace_back();
+        }
+        bufferChannels[bufferIndex] = std::max(bufferChannels[bufferIndex], numChannels);
+        return bufferIndex;
+    };
+    
+    // Take back the buffer a reused instruction acquired last time: a new one, or one of the free ones
+    auto reacquireBuffer = [&](int bufferIndex, int numChannels) {
+        if (bufferIndex == static_cast<int>(bufferChannels.size())) {
+            bufferChannels.push_back(0);
+            bufferUsers.emplace_back();
+        } else {
+            auto it = std::find(freeBuffers.begin(), freeBuffers.end(), bufferIndex);
+            if (it != freeBuffers.end()) {
+                freeBuffers.erase(it);
+            }
+        }
+        bufferChannels[bufferIndex] = std::max(bufferChannels[bufferIndex], numChannels);
+    };
     
-    for (auto& node : sortedNodes) {
+    // Everything that touched a buffer's previous contents must finish before it is overwritten
+    auto claimBuffer = [&](int bufferIndex, ProcessingInstruction& instruction, int instructionIndex) {
+        auto& users = bufferUsers[bufferIndex];
+        for (int user : users) {
+            if (user != instructionIndex) {
+                addDependency(user, instruction, instructionIndex);
+            }
+        }
+        users.assign(1, instructionIndex);
+    };
+    
+    // Once an instruction has run, hand the buffers nobody reads any more to later producers
+    auto releaseBuffers = [&](const ProcessingInstruction& instruction, int instructionIndex) {
+        for (int source : instruction.sourceInstructions) {
+            if (--remainingConsumers[source] == 0 && !holdsOutput[source]) {
+                int bufferIndex = instructions[source].outputBufferIndex;
+                if (bufferIndex != instruction.outputBufferIndex) {
+                    freeBuffers.push_back(bufferIndex);
+                }
+            }
+        }
+        for (const auto& sum : instruction.inputSums) {
+            if (sum.bufferIndex != instruction.outputBufferIndex) {
+                freeBuffers.push_back(sum.bufferIndex);
+            }
+        }
+        
+        // Nothing reads a dead-end node, so its buffer is free as soon as it has run
+        if (remainingConsumers[instructionIndex] == 0 && !holdsOutput[instructionIndex]) {
+            freeBuffers.push_back(instruction.outputBufferIndex);
+        }
+    };
+    
+    // Instructions carried over from the last compile: copy them and replay their buffer
+    // bookkeeping, dropping the dependents that later instructions added
+    const int firstAssigned = static_cast<int>(numReused);
+    for (size_t i = 0; i < numReused; ++i) {
+        int instructionIndex = static_cast<int>(i);
+        ProcessingInstruction instruction = cachedCompiledGraph->instructions[i];
+        addBookkeeping(instruction.node);
+        auto& dependents = instruction.dependents;
+        dependents.erase(std::remove_if(dependents.begin(), dependents.end(),
+                                        [firstAssigned](int dependent) { return dependent >= firstAssigned; }),
+                         dependents.end());
+        
+        for (int source : instruction.sourceInstructions) {
+            bufferUsers[instructions[source].outputBufferIndex].push_back(instructionIndex);
+        }
+        for (const auto& sum : instruction.inputSums) {
+            reacquireBuffer(sum.bufferIndex, sum.numChannels);
+            bufferUsers[sum.bufferIndex].assign(1, instructionIndex);
+        }
+        if (instruction.processInPlace) {
+            auto& channels = bufferChannels[instruction.outputBufferIndex];
+            channels = std::max(channels, instruction.numOutputChannels);
+        } else {
+            reacquireBuffer(instruction.outputBufferIndex, instruction.numOutputChannels);
+        }
+        bufferUsers[instruction.outputBufferIndex].assign(1, instructionIndex);
+        
+        releaseBuffers(instruction, instructionIndex);
+        nodeToInstruction[instruction.node.get()] = instructionIndex;
+        instructions.push_back(std::move(instruction));
+    }
+    
+    for (size_t position = numReused; position < sortedNodes.size(); ++position) {
+        const auto& node = sortedNodes[position];
+        int instructionIndex = static_cast<int>(instructions.size());
         ProcessingInstruction instruction;
         instruction.node = node;
+        instruction.numOutputChannels = resolveNumOutputChannels(node);
+        addBookkeeping(node);
         
-        // Find input buffer indices
-        for (auto& [source, targets] : connections) {
-            if (std::find(targets.begin(), targets.end(), node) != targets.end()) {
-                auto bufferIt = nodeToBufferIndex.find(source);
-                if (bufferIt != nodeToBufferIndex.end()) {
-                    instruction.inputBufferIndices.push_back(bufferIt->second);
+        // Group the sources by input port (stable, so each port keeps connection order)
+        std::vector<std::pair<int, int>> sources; // (port, source instruction)
+        auto inputsIt = inputs.find(node.get());
+        if (inputsIt != inputs.end()) {
+            for (auto& input : inputsIt->second) {
+                auto sourceIt = nodeToInstruction.find(input.source.get());
+                if (sourceIt != nodeToInstruction.end()) {
+                    sources.emplace_back(input.port, sourceIt->second);
                 }
             }
         }
+        std::stable_sort(sources.begin(), sources.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
         
-        // Assign output buffer index
-        instruction.outputBufferIndex = nextBufferIndex++;
-        nodeToBufferIndex[node] = instruction.outputBufferIndex;
+        // Paths arriving early are delayed to meet the slowest one
+        int inputLatency = 0;
+        for (auto& [port, source] : sources) {
+            instruction.sourceInstructions.push_back(source);
+            addDependency(source, instruction, instructionIndex);
+            bufferUsers[instructions[source].outputBufferIndex].push_back(instructionIndex);
+            inputLatency = std::max(inputLatency, instructions[source].latencySamples);
+        }
+        instruction.latencySamples = inputLatency + std::max(0, node->getLatencySamples());
         
-        instructions.push_back(instruction);
+        auto sourceDelay = [&](int source) { return inputLatency - instructions[source].latencySamples; };
+        
+        // One input per connected port; ports with several (or delayed) sources read a junction buffer
+        bool mixesJunction = false;
+        for (size_t first = 0; first < sources.size();) {
+            size_t last = first + 1;
+            while (last < sources.size() && sources[last].first == sources[first].first) {
+                ++last;
+            }
+            
+            if (last - first == 1 && sourceDelay(sources[first].second) == 0) {
+                const auto& source = instructions[sources[first].second];
+                instruction.inputBufferIndices.push_back(source.outputBufferIndex);
+                instruction.inputChannelCounts.push_back(source.numOutputChannels);
+            } else {
+                InputSum sum;
+                sum.numChannels = 1;
+                for (size_t i = first; i < last; ++i) {
+                    const auto& source = instructions[sources[i].second];
+                    sum.sourceBufferIndices.push_back(source.outputBufferIndex);
+                    sum.sourceChannelCounts.push_back(source.numOutputChannels);
+                    sum.numChannels = std::max(sum.numChannels, source.numOutputChannels);
+                    sum.sourceNodes.push_back(source.node.get());
+                    
+                    int delay = sourceDelay(sources[i].second);
+                    instruction.inputDelaySamples = std::max(instruction.inputDelaySamples, delay);
+                    sum.sourceDelaySamples.push_back(delay);
+                }
+                sum.bufferIndex = acquireBuffer(sum.numChannels);
+                claimBuffer(sum.bufferIndex, instruction, instructionIndex);
+                mixesJunction = true;
+                
+                instruction.inputBufferIndices.push_back(sum.bufferIndex);
+                instruction.inputChannelCounts.push_back(sum.numChannels);
+                instruction.inputSums.push_back(std::move(sum));
+            }
+            first = last;
+        }
+        
+        // Run in place when this node owns its single input: a junction it just mixed,
+        // or a source buffer nobody else still needs
+        bool ownsSingleInput = false;
+        if (instruction.inputBufferIndices.size() == 1) {
+            int source = sources.front().second;
+            ownsSingleInput = mixesJunction || (remainingConsumers[source] == 1 && !holdsOutput[source]);
+        }
+        instruction.processInPlace = node->supportsInPlaceProcessing() && ownsSingleInput;
+        
+        if (instruction.processInPlace) {
+            instruction.outputBufferIndex = instruction.inputBufferIndices.front();
+            auto& channels = bufferChannels[instruction.outputBufferIndex];
+            channels = std::max(channels, instruction.numOutputChannels);
+        } else {
+            instruction.outputBufferIndex = acquireBuffer(instruction.numOutputChannels);
+        }
+        claimBuffer(instruction.outputBufferIndex, instruction, instructionIndex);
+        
+        releaseBuffers(instruction, instructionIndex);
+        nodeToInstruction[node.get()] = instructionIndex;
+        instructions.push_back(std::move(instruction));
     }
+    
+    return static_cast<int>(bufferChannels.size());
+}
+
+int AudioGraph::resolveNumOutputChannels(const std::shared_ptr<AudioNode>& node) const {
+    // Nodes that don't ask for a specific width follow the graph's channel count
+    int channels = node->getNumOutputChannels();
+    if (channels <= 0) {
+        channels = currentPrepareInfo.numChannels;
+    }
+    return std::max(1, channels);
 }
 
 bool AudioGraph::hasCycle() const {
@@ -314,13 +1253,248 @@ void AudioGraph::dfsVisit(std::shared_ptr<AudioNode> node,
 }
 
 // AudioGraphProcessor implementation
+namespace {
+    // Counts a processGraph call as finished however it returns
+    struct BlockFinishedCounter {
+        std::atomic<uint64_t>& blocksFinished;
+        ~BlockFinishedCounter() { blocksFinished.fetch_add(1); }
+    };
+}
+
 AudioGraphProcessor::AudioGraphProcessor() {
 }
 
+AudioGraphProcessor::~AudioGraphProcessor() {
+    stopWorkerThreads();
+    delete activeGraph.exchange(nullptr);
+}
+
 void AudioGraphProcessor::setCompiledGraph(std::shared_ptr<AudioGraph::CompiledGraph> graph) {
-    Logger::debug("Setting compiled graph with {} instructions...", graph->instructions.size());
-    SpinLockGuard lock(graphLock);
-    compiledGraph = graph;
+    Logger::debug("Setting compiled graph with {} instructions...", graph ? graph->instructions.size() : 0);
+    std::lock_guard<std::mutex> publishLock(publishMutex);
+    
+    // Lay out the temp buffers and work queues here, off the audio thread
+    auto prepared = std::make_unique<PreparedGraph>();
+    prepared->graph = graph;
+    if (graph) {
+        allocateTempBuffers(*prepared, graph->prepareInfo.maxBufferSize);
+        allocateParallelState(*prepared);
+        
+        // Only setCompiledGraph replaces or retires the active graph, and it holds publishMutex,
+        // so the active graph stays alive here. The audio thread only touches line contents.
+        allocateDelayLines(*prepared, activeGraph.load());
+        prepared->outputSilent.assign(graph->instructions.size(), 0);
+        prepared->silentInputSamples.assign(graph->instructions.size(), 0);
+    }
+    
+    // Any block that could have loaded the old pointer has already bumped blocksStarted,
+    // so the old graph is unreachable once blocksFinished catches up with this value
+    std::unique_ptr<PreparedGraph> previous(activeGraph.exchange(prepared.release()));
+    uint64_t blocksStartedWhenRetired = blocksStarted.load();
+    
+    {
+        std::lock_guard<std::mutex> lock(retiredGraphsMutex);
+        if (previous) {
+            retiredGraphs.push_back({ std::move(previous), blocksStartedWhenRetired });
+        }
+    }
+    
+    releaseRetiredGraphs();
+}
+
+void AudioGraphProcessor::releaseRetiredGraphs() {
+    std::vector<RetiredGraph> graphsToFree;
+    
+    {
+        std::lock_guard<std::mutex> lock(retiredGraphsMutex);
+        uint64_t finished = blocksFinished.load();
+        
+        auto stillInUse = std::partition(retiredGraphs.begin(), retiredGraphs.end(),
+            [finished](const RetiredGraph& retired) { return retired.blocksStartedWhenRetired > finished; });
+        
+        std::move(stillInUse, retiredGraphs.end(), std::back_inserter(graphsToFree));
+        retiredGraphs.erase(stillInUse, retiredGraphs.end());
+    }
+    
+    // graphsToFree (and any node references they hold) are destroyed here, outside the lock
+}
+
+void AudioGraphProcessor::setNumWorkerThreads(int numWorkers) {
+    stopWorkerThreads();
+    
+    shouldStopWorkers.store(false);
+    {
+        std::lock_guard<std::mutex> lock(workerSchedulingMutex);
+        workerSchedulingResults.assign(static_cast<size_t>(std::max(0, numWorkers)), {});
+    }
+    
+    unsigned int numCores = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 0; i < numWorkers; ++i) {
+        int participant = i + 1; // Participant 0 is the audio thread
+        
+        auto settings = workerScheduling;
+        if (!settings.cores.empty()) {
+            settings.cores = { settings.cores[static_cast<size_t>(i) % settings.cores.size()] };
+        }
+        
+        workerThreads.emplace_back([this, i, participant, numCores, settings] {
+            if (ThreadScheduling::isRequested(settings)) {
+                auto result = ThreadScheduling::applyToCurrentThread(settings);
+                if (!result.succeeded()) {
+                    Logger::warn("Graph worker {}: scheduling {}, affinity {}", participant,
+                                 ThreadScheduling::toString(result.scheduling), ThreadScheduling::toString(result.affinity));
+                }
+                
+                std::lock_guard<std::mutex> lock(workerSchedulingMutex);
+                workerSchedulingResults[static_cast<size_t>(i)] = result;
+            }
+            
+            // Best-effort by default: keep each worker on its own core so it isn't migrated mid-block
+            if (settings.cores.empty()) {
+                ThreadScheduling::pinCurrentThreadToCore(static_cast<int>(participant % numCores));
+            }
+            workerThreadFunction(participant);
+        });
+    }
+    
+    // The active graph needs one ready queue per participant
+    if (auto* prepared = activeGraph.load()) {
+        allocateParallelState(*prepared);
+    }
+    
+    Logger::debug("AudioGraphProcessor using {} worker threads", numWorkers);
+}
+
+std::vector<ThreadScheduling::Result> AudioGraphProcessor::getWorkerSchedulingResults() const {
+    std::lock_guard<std::mutex> lock(workerSchedulingMutex);
+    return workerSchedulingResults;
+}
+
+void AudioGraphProcessor::stopWorkerThreads() {
+    if (workerThreads.empty()) {
+        return;
+    }
+    
+    shouldStopWorkers.store(true);
+    workerWakeup.release(static_cast<std::ptrdiff_t>(workerThreads.size()));
+    for (auto& worker : workerThreads) {
+        worker.join();
+    }
+    workerThreads.clear();
+}
+
+void AudioGraphProcessor::allocateTempBuffers(PreparedGraph& prepared, int numFrames) {
+    const auto& graph = *prepared.graph;
+    
+    // Round every channel up to a whole number of cache lines so each one starts aligned
+    auto framesPerChannel = static_cast<size_t>(std::max(numFrames, 1));
+    framesPerChannel = (framesPerChannel + slabAlignmentFloats - 1) / slabAlignmentFloats * slabAlignmentFloats;
+    
+    int totalChannels = 0;
+    prepared.bufferFirstChannel.resize(graph.tempBufferChannels.size());
+    for (size_t bufferIdx = 0; bufferIdx < graph.tempBufferChannels.size(); ++bufferIdx) {
+        prepared.bufferFirstChannel[bufferIdx] = totalChannels;
+        totalChannels += graph.tempBufferChannels[bufferIdx];
+    }
+    
+    prepared.slab.assign(static_cast<size_t>(totalChannels) * framesPerChannel + slabAlignmentFloats, 0.0f);
+    prepared.framesPerChannel = static_cast<int>(framesPerChannel);
+    
+    void* base = prepared.slab.data();
+    size_t space = prepared.slab.size() * sizeof(float);
+    auto* alignedBase = static_cast<float*>(std::align(slabAlignmentFloats * sizeof(float),
+                                                       static_cast<size_t>(totalChannels) * framesPerChannel * sizeof(float),
+                                                       base, space));
+    
+    prepared.channelPtrs.resize(totalChannels);
+    for (int ch = 0; ch < totalChannels; ++ch) {
+        prepared.channelPtrs[ch] = alignedBase + static_cast<size_t>(ch) * framesPerChannel;
+    }
+    
+    // Each instruction gets its own slice of input channel pointers, so concurrently
+    // running nodes never share a table and nothing is built per block
+    prepared.inputChannelTable.clear();
+    prepared.inputTableOffsets.resize(graph.instructions.size());
+    for (size_t i = 0; i < graph.instructions.size(); ++i) {
+        const auto& instruction = graph.instructions[i];
+        prepared.inputTableOffsets[i] = prepared.inputChannelTable.size();
+        
+        for (size_t input = 0; input < instruction.inputBufferIndices.size(); ++input) {
+            int firstChannel = prepared.bufferFirstChannel[instruction.inputBufferIndices[input]];
+            for (int ch = 0; ch < instruction.inputChannelCounts[input]; ++ch) {
+                prepared.inputChannelTable.push_back(prepared.channelPtrs[firstChannel + ch]);
+            }
+        }
+    }
+}
+
+void AudioGraphProcessor::allocateParallelState(PreparedGraph& prepared) {
+    size_t numInstructions = prepared.graph->instructions.size();
+    size_t numParticipants = workerThreads.size() + 1;
+    
+    prepared.pendingDependencies = std::make_unique<std::atomic<int>[]>(std::max<size_t>(numInstructions, 1));
+    prepared.readyQueues.clear();
+    for (size_t participant = 0; participant < numParticipants; ++participant) {
+        prepared.readyQueues.push_back(std::make_unique<WorkStealingQueue>(numInstructions));
+    }
+    
+#if AUDIO_PROFILING
+    prepared.nodeTimings = std::make_unique<TimingHistogram[]>(std::max<size_t>(numParticipants * numInstructions, 1));
+#endif
+}
+
+void AudioGraphProcessor::allocateDelayLines(PreparedGraph& prepared, const PreparedGraph* previous) {
+    const auto& graph = *prepared.graph;
+    
+    // Reuse the previous graph's line for the same connection when it's still the same shape.
+    // Only one graph is processed per block, so the old and new graph never use it at once.
+    auto getLine = [&](AudioNode* source, AudioNode* destination, int numChannels, int delaySamples) -> DelayLine* {
+        if (delaySamples <= 0) return nullptr;
+        
+        auto key = std::make_pair(source, destination);
+        std::shared_ptr<DelayLine> line;
+        if (previous) {
+            auto it = previous->delayLines.find(key);
+            if (it != previous->delayLines.end() && it->second->getDelaySamples() == delaySamples
+                && it->second->getNumChannels() == numChannels) {
+                line = it->second;
+            }
+        }
+        if (!line) {
+            line = std::make_shared<DelayLine>(numChannels, delaySamples);
+        }
+        
+        prepared.delayLines[key] = line;
+        return line.get();
+    };
+    
+    prepared.inputDelayOffsets.resize(graph.instructions.size());
+    for (size_t i = 0; i < graph.instructions.size(); ++i) {
+        const auto& instruction = graph.instructions[i];
+        prepared.inputDelayOffsets[i] = prepared.inputDelays.size();
+        
+        for (const auto& sum : instruction.inputSums) {
+            for (size_t source = 0; source < sum.sourceNodes.size(); ++source) {
+                prepared.inputDelays.push_back(getLine(sum.sourceNodes[source], instruction.node.get(),
+                                                       sum.sourceChannelCounts[source], sum.sourceDelaySamples[source]));
+            }
+        }
+    }
+    
+    for (size_t output = 0; output < graph.outputDelaySamples.size(); ++output) {
+        AudioNode* outputNode = graph.instructions[static_cast<size_t>(graph.outputInstructions[output])].node.get();
+        prepared.outputDelays.push_back(getLine(outputNode, nullptr, graph.outputChannelCounts[output],
+                                                graph.outputDelaySamples[output]));
+    }
+}
+
+choc::buffer::ChannelArrayView<float> AudioGraphProcessor::getTempBufferView(const PreparedGraph& prepared, int bufferIndex,
+                                                                             int numChannels, choc::buffer::FrameCount numFrames) const {
+    return choc::buffer::createChannelArrayView(
+        prepared.channelPtrs.data() + prepared.bufferFirstChannel[bufferIndex],
+        static_cast<choc::buffer::ChannelCount>(numChannels),
+        numFrames
+    );
 }
 
 void AudioGraphProcessor::processGraph(
@@ -329,140 +1503,336 @@ void AudioGraphProcessor::processGraph(
     double sampleRate,
     int blockSize
 ) {
-    std::shared_ptr<AudioGraph::CompiledGraph> graph;
-    {
-        SpinLockGuard lock(graphLock);
-        graph = compiledGraph;
-    }
+    blocksStarted.fetch_add(1);
+    BlockFinishedCounter finishedCounter { blocksFinished };
+    
+    PreparedGraph* prepared = activeGraph.load();
     
-    auto numOutputChannels = outputBuffers.getNumChannels();
     auto numSamples = outputBuffers.getNumFrames();
     
-    if (!graph || !graph->prepared || graph->instructions.empty()) {
+    if (!prepared || !prepared->graph || !prepared->graph->prepared || prepared->graph->instructions.empty()) {
         // Clear output buffers if no graph
         outputBuffers.clear();
         return;
     }
     
-    // Ensure temp buffers are sized correctly
-    ensureTempBuffersSize(graph->numTempBuffers, static_cast<int>(numOutputChannels), static_cast<int>(numSamples));
+    const auto& graph = *prepared->graph;
     
-    // Clear all temp buffers
-    for (int bufferIdx = 0; bufferIdx < graph->numTempBuffers; ++bufferIdx) {
-        if (bufferIdx < static_cast<int>(tempBuffers.size())) {
-            std::memset(tempBuffers[bufferIdx].data(), 0, numSamples * sizeof(float));
+#if AUDIO_PROFILING
+    struct CallbackTiming {
+        CallbackProfile& profile;
+        uint64_t budgetNanos;
+        uint64_t start = TimingHistogram::nowNanos();
+        ~CallbackTiming() { profile.record(TimingHistogram::nowNanos() - start, budgetNanos); }
+    };
+    CallbackTiming callbackTiming { callbackProfile,
+                                    sampleRate > 0.0 ? static_cast<uint64_t>(numSamples * 1e9 / sampleRate) : 0 };
+#endif
+    
+    // Blocks longer than the graph was prepared for run in prepared-size pieces, so the
+    // audio thread never has to grow the slab
+    auto maxFrames = static_cast<choc::buffer::FrameCount>(
+        std::min(std::max(graph.prepareInfo.maxBufferSize, 1), prepared->framesPerChannel));
+    if (numSamples <= maxFrames) {
+        processBlock(*prepared, inputBuffers, outputBuffers, sampleRate, blockSize);
+        return;
+    }
+    
+    for (choc::buffer::FrameCount start = 0; start < numSamples; start += maxFrames) {
+        choc::buffer::FrameRange range { start, std::min(numSamples, start + maxFrames) };
+        auto inputRange = inputBuffers.getNumChannels() > 0 ? inputBuffers.getFrameRange(range) : inputBuffers;
+        processBlock(*prepared, inputRange, outputBuffers.getFrameRange(range), sampleRate,
+                     static_cast<int>(range.end - range.start));
+    }
+}
+
+void AudioGraphProcessor::processBlock(PreparedGraph& prepared,
+                                       choc::buffer::ChannelArrayView<const float> inputBuffers,
+                                       choc::buffer::ChannelArrayView<float> outputBuffers,
+                                       double sampleRate,
+                                       int blockSize) {
+    const auto& graph = *prepared.graph;
+    auto numOutputChannels = outputBuffers.getNumChannels();
+    auto numSamples = outputBuffers.getNumFrames();
+    
+    BlockContext context { inputBuffers, numSamples, sampleRate, blockSize };
+    
+    // Small graphs aren't worth waking the workers for
+    if (!workerThreads.empty() && static_cast<int>(graph.instructions.size()) >= parallelThreshold) {
+        processParallel(prepared, context);
+    } else {
+        for (int i = 0; i < static_cast<int>(graph.instructions.size()); ++i) {
+            processInstruction(prepared, i, 0, context);
         }
     }
     
-    // Process each instruction in order
-    for (const auto& instruction : graph->instructions) {
-        if (!instruction.node) continue;
+    // Mix output nodes to final output buffers
+    outputBuffers.clear();
+    
+    for (size_t output = 0; output < graph.outputBufferIndices.size(); ++output) {
+        float* const* nodeOutput = prepared.channelPtrs.data() + prepared.bufferFirstChannel[graph.outputBufferIndices[output]];
+        int nodeChannels = graph.outputChannelCounts[output];
+        DelayLine* delay = prepared.outputDelays[output];
         
-        // Create input buffer views for this node
-        std::vector<float*> inputPtrs;
+        // Silent outputs add nothing (a delay line still has to be fed)
+        if (!delay && prepared.outputSilent[graph.outputInstructions[output]]) {
+            continue;
+        }
         
-        // If no input connections, use the actual input buffers from PortAudio
-        if (instruction.inputBufferIndices.empty() && inputBuffers.getNumChannels() > 0) {
-            // This is an input node - use the input buffers from PortAudio
-            // For simplicity, we'll pass the input buffer as a const view
-            // The node should handle const input appropriately
+        // Channels map one-to-one; a mono node is spread across every output channel
+        for (choc::buffer::ChannelCount ch = 0; ch < numOutputChannels; ++ch) {
+            int sourceChannel = (nodeChannels == 1) ? 0 : static_cast<int>(ch);
+            if (sourceChannel >= nodeChannels) continue;
             
-            // Process with input from PortAudio
-            float* outputPtr = nullptr;
-            if (instruction.outputBufferIndex < static_cast<int>(tempBufferPtrs.size())) {
-                outputPtr = tempBufferPtrs[instruction.outputBufferIndex];
-            }
-            
-            if (outputPtr) {
-                float* outputPtrArray[] = { outputPtr };
-                auto outputView = choc::buffer::createChannelArrayView(
-                    outputPtrArray,
-                    static_cast<choc::buffer::ChannelCount>(1),
-                    static_cast<choc::buffer::FrameCount>(numSamples)
-                );
-                
-                // Process the node with input from PortAudio
-                instruction.node->processCallback(
-                    inputBuffers,  // Pass the actual input buffers
-                    outputView,
-                    sampleRate,
-                    blockSize
-                );
+            float* destination = outputBuffers.data.channels[ch] + outputBuffers.data.offset;
+            if (delay) {
+                delay->read(sourceChannel, nodeOutput[sourceChannel], destination, static_cast<int>(numSamples), true);
+            } else {
+                AudioKernels::addSamples(destination, nodeOutput[sourceChannel], static_cast<int>(numSamples));
             }
+        }
+        
+        if (delay) {
+            delay->write(nodeOutput, static_cast<int>(numSamples));
+        }
+    }
+}
+
+void AudioGraphProcessor::processInstruction(PreparedGraph& prepared, int instructionIndex, int participant,
+                                             const BlockContext& context) {
+    const auto& instruction = prepared.graph->instructions[instructionIndex];
+    if (!instruction.node) return;
+    
+#if AUDIO_PROFILING
+    ScopedTiming timing(prepared.nodeTimings[static_cast<size_t>(participant) * prepared.graph->instructions.size() + instructionIndex]);
+#else
+    (void) participant;
+#endif
+    
+    auto numFrames = static_cast<int>(context.numSamples);
+    
+    // Put the node to sleep once all of its inputs have been silent for longer than its tail
+    // (plus any compensation delay still flushing); sources always run
+    if (!instruction.sourceInstructions.empty()) {
+        bool inputsSilent = std::all_of(instruction.sourceInstructions.begin(), instruction.sourceInstructions.end(),
+                                        [&prepared](int source) { return prepared.outputSilent[source] != 0; });
+        int& silentSamples = prepared.silentInputSamples[instructionIndex];
+        
+        if (!inputsSilent) {
+            silentSamples = 0;
         } else {
-            // This node has inputs from other nodes in the graph
-            for (int inputIndex : instruction.inputBufferIndices) {
-                if (inputIndex < static_cast<int>(tempBufferPtrs.size())) {
-                    inputPtrs.push_back(tempBufferPtrs[inputIndex]);
-                }
+            int tail = instruction.node->getTailSamples();
+            if (tail != AudioNode::neverSleeps && silentSamples >= tail + instruction.inputDelaySamples) {
+                getTempBufferView(prepared, instruction.outputBufferIndex,
+                                  instruction.numOutputChannels, context.numSamples).clear();
+                prepared.outputSilent[instructionIndex] = 1;
+                return;
             }
+            silentSamples = std::min(silentSamples + numFrames, std::numeric_limits<int>::max() / 2);
+        }
+    }
+    
+    // Mix fanned-in connections into their junction buffers first
+    DelayLine* const* inputDelays = prepared.inputDelays.data() + prepared.inputDelayOffsets[instructionIndex];
+    for (const auto& sum : instruction.inputSums) {
+        float* const* junction = prepared.channelPtrs.data() + prepared.bufferFirstChannel[sum.bufferIndex];
+        
+        for (size_t source = 0; source < sum.sourceBufferIndices.size(); ++source) {
+            float* const* sourceChannels = prepared.channelPtrs.data() + prepared.bufferFirstChannel[sum.sourceBufferIndices[source]];
+            int numSourceChannels = sum.sourceChannelCounts[source];
+            DelayLine* delay = *inputDelays++;
             
-            // Get output buffer for this node
-            float* outputPtr = nullptr;
-            if (instruction.outputBufferIndex < static_cast<int>(tempBufferPtrs.size())) {
-                outputPtr = tempBufferPtrs[instruction.outputBufferIndex];
+            // Channels map one-to-one; a mono source is spread across every junction channel
+            for (int ch = 0; ch < sum.numChannels; ++ch) {
+                int sourceChannel = (numSourceChannels == 1) ? 0 : ch;
+                if (sourceChannel >= numSourceChannels) {
+                    if (source == 0) std::memset(junction[ch], 0, static_cast<size_t>(numFrames) * sizeof(float));
+                    continue;
+                }
+                
+                if (delay) {
+                    delay->read(sourceChannel, sourceChannels[sourceChannel], junction[ch], numFrames, source != 0);
+                } else if (source == 0) {
+                    AudioKernels::copySamples(junction[ch], sourceChannels[sourceChannel], numFrames);
+                } else {
+                    AudioKernels::addSamples(junction[ch], sourceChannels[sourceChannel], numFrames);
+                }
             }
             
-            if (outputPtr) {
-                // Create choc buffer views for input and output
-                auto inputView = choc::buffer::createChannelArrayView(
-                    inputPtrs.empty() ? nullptr : inputPtrs.data(),
-                    static_cast<choc::buffer::ChannelCount>(inputPtrs.size()),
-                    static_cast<choc::buffer::FrameCount>(numSamples)
-                );
-                
-                float* outputPtrArray[] = { outputPtr };
-                auto outputView = choc::buffer::createChannelArrayView(
-                    outputPtrArray,
-                    static_cast<choc::buffer::ChannelCount>(1),
-                    static_cast<choc::buffer::FrameCount>(numSamples)
-                );
-                
-                // Process the node
-                instruction.node->processCallback(
-                    inputView,
-                    outputView,
-                    sampleRate,
-                    blockSize
-                );
+            if (delay) {
+                delay->write(sourceChannels, numFrames);
             }
         }
     }
     
-    // Mix output nodes to final output buffers
-    outputBuffers.clear();
+    auto outputView = getTempBufferView(prepared, instruction.outputBufferIndex,
+                                        instruction.numOutputChannels, context.numSamples);
     
-    for (auto& outputNode : graph->outputNodes) {
-        // Find the buffer index for this output node
-        for (const auto& instruction : graph->instructions) {
-            if (instruction.node == outputNode) {
-                if (instruction.outputBufferIndex < static_cast<int>(tempBufferPtrs.size())) {
-                    float* nodeOutput = tempBufferPtrs[instruction.outputBufferIndex];
-                    
-                    // Mix to all output channels (mono to stereo)
-                    for (choc::buffer::FrameCount sample = 0; sample < numSamples; ++sample) {
-                        float sampleValue = nodeOutput[sample];
-                        for (choc::buffer::ChannelCount ch = 0; ch < numOutputChannels; ++ch) {
-                            outputBuffers.getSample(ch, sample) += sampleValue;
-                        }
-                    }
-                }
-                break;
+    // Buffers are recycled between nodes, so start from silence unless reading in place
+    if (!instruction.processInPlace) {
+        outputView.clear();
+    }
+    
+    instruction.node->setOutputSilent(false);
+    
+    if (instruction.inputBufferIndices.empty() && context.inputBuffers.getNumChannels() > 0) {
+        // This is an input node - process with the input buffers from PortAudio
+        instruction.node->processCallback(
+            context.inputBuffers,
+            outputView,
+            context.sampleRate,
+            context.blockSize
+        );
+    } else if (instruction.inputBufferIndices.size() == 1) {
+        // Single input port - read its buffer (or junction) directly
+        auto inputView = getTempBufferView(prepared, instruction.inputBufferIndices.front(),
+                                           instruction.inputChannelCounts.front(), context.numSamples);
+        
+        instruction.node->processCallback(
+            inputView,
+            outputView,
+            context.sampleRate,
+            context.blockSize
+        );
+    } else {
+        // Several input ports - present their channels one after another
+        size_t firstInput = prepared.inputTableOffsets[instructionIndex];
+        size_t lastInput = (instructionIndex + 1 < static_cast<int>(prepared.inputTableOffsets.size()))
+                               ? prepared.inputTableOffsets[instructionIndex + 1]
+                               : prepared.inputChannelTable.size();
+        size_t numInputChannels = lastInput - firstInput;
+        
+        auto inputView = choc::buffer::createChannelArrayView(
+            numInputChannels == 0 ? nullptr : prepared.inputChannelTable.data() + firstInput,
+            static_cast<choc::buffer::ChannelCount>(numInputChannels),
+            context.numSamples
+        );
+        
+        instruction.node->processCallback(
+            inputView,
+            outputView,
+            context.sampleRate,
+            context.blockSize
+        );
+    }
+    
+    prepared.outputSilent[instructionIndex] = instruction.node->isOutputSilent() ? 1 : 0;
+}
+
+void AudioGraphProcessor::processParallel(PreparedGraph& prepared, const BlockContext& context) {
+    const auto& graph = *prepared.graph;
+    
+    // Reset this block's ref counts and queues; workers are all outside the block here
+    for (size_t i = 0; i < graph.instructions.size(); ++i) {
+        prepared.pendingDependencies[i].store(graph.instructions[i].numDependencies, std::memory_order_relaxed);
+    }
+    for (auto& queue : prepared.readyQueues) {
+        queue->reset();
+    }
+    prepared.remainingInstructions.store(static_cast<int>(graph.instructions.size()), std::memory_order_relaxed);
+    
+    for (int root : graph.rootInstructions) {
+        prepared.readyQueues.front()->push(root);
+    }
+    
+    parallelGraph = &prepared;
+    parallelContext = context;
+    blockActive.store(true);
+    workerWakeup.release(static_cast<std::ptrdiff_t>(workerThreads.size()));
+    
+    // The audio thread works too, so the block completes even if no worker wakes in time
+    runReadyInstructions(prepared, 0, context);
+    
+    // Don't return (and let the graph be retired or reset) while a worker is still inside
+    blockActive.store(false);
+    while (workersInBlock.load() != 0) {
+        std::this_thread::yield();
+    }
+}
+
+void AudioGraphProcessor::runReadyInstructions(PreparedGraph& prepared, int participant, const BlockContext& context) {
+    auto& queues = prepared.readyQueues;
+    auto numQueues = static_cast<int>(queues.size());
+    auto& ownQueue = *queues[participant];
+    
+    while (prepared.remainingInstructions.load(std::memory_order_acquire) > 0) {
+        int instructionIndex = ownQueue.pop();
+        
+        // Nothing local: steal from the other participants
+        for (int offset = 1; instructionIndex == WorkStealingQueue::empty && offset < numQueues; ++offset) {
+            instructionIndex = queues[(participant + offset) % numQueues]->steal();
+        }
+        
+        if (instructionIndex == WorkStealingQueue::empty) {
+            continue;
+        }
+        
+        processInstruction(prepared, instructionIndex, participant, context);
+        
+        // Whoever releases the last dependency runs the dependent (or lets it be stolen)
+        for (int dependent : prepared.graph->instructions[instructionIndex].dependents) {
+            if (prepared.pendingDependencies[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                ownQueue.push(dependent);
             }
         }
+        
+        prepared.remainingInstructions.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void AudioGraphProcessor::workerThreadFunction(int participant) {
+    while (true) {
+        workerWakeup.acquire();
+        if (shouldStopWorkers.load()) {
+            break;
+        }
+        
+        // Announce ourselves before checking the block, so processParallel can't miss us
+        workersInBlock.fetch_add(1);
+        if (blockActive.load()) {
+            runReadyInstructions(*parallelGraph, participant, parallelContext);
+        }
+        workersInBlock.fetch_sub(1);
     }
 }
 
-void AudioGraphProcessor::ensureTempBuffersSize(int numBuffers, int numChannels, int numSamples) {
-    if (tempBuffers.size() < static_cast<size_t>(numBuffers)) {
-        tempBuffers.resize(numBuffers);
-        tempBufferPtrs.resize(numBuffers);
+GraphProfileSnapshot AudioGraphProcessor::getProfileSnapshot() {
+    GraphProfileSnapshot snapshot;
+    
+#if AUDIO_PROFILING
+    snapshot.available = true;
+    
+    TimingHistogram::Totals callbackTotals;
+    callbackTotals.add(callbackProfile.timings);
+    snapshot.callback = callbackTotals.summarize();
+    snapshot.deadlineMisses = callbackProfile.deadlineMisses.load(std::memory_order_relaxed);
+    snapshot.peakCpuLoadPercent = callbackProfile.peakLoad.load(std::memory_order_relaxed) * 100.0;
+    
+    uint64_t bufferNanos = callbackProfile.bufferNanos.load(std::memory_order_relaxed);
+    if (bufferNanos > 0) {
+        snapshot.cpuLoadPercent = 100.0 * static_cast<double>(callbackTotals.totalNanos) / static_cast<double>(bufferNanos);
     }
     
-    for (int bufferIdx = 0; bufferIdx < numBuffers; ++bufferIdx) {
-        if (tempBuffers[bufferIdx].size() < static_cast<size_t>(numSamples)) {
-            tempBuffers[bufferIdx].resize(numSamples);
+    // A replaced graph only joins retiredGraphs under this lock, and is only freed from there,
+    // so the one loaded here can't be freed until the snapshot is done with it
+    std::lock_guard<std::mutex> lock(retiredGraphsMutex);
+    PreparedGraph* prepared = activeGraph.load();
+    if (!prepared || !prepared->graph || !prepared->nodeTimings) {
+        return snapshot;
+    }
+    
+    const auto& instructions = prepared->graph->instructions;
+    size_t numParticipants = prepared->readyQueues.size();
+    for (size_t i = 0; i < instructions.size(); ++i) {
+        if (!instructions[i].node) continue;
+        
+        TimingHistogram::Totals totals;
+        for (size_t participant = 0; participant < numParticipants; ++participant) {
+            totals.add(prepared->nodeTimings[participant * instructions.size() + i]);
         }
-        tempBufferPtrs[bufferIdx] = tempBuffers[bufferIdx].data();
+        snapshot.nodes.push_back({ instructions[i].node->getName(), totals.summarize() });
     }
+#endif
+    
+    return snapshot;
 }
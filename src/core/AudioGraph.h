@@ -1,33 +1,96 @@
 #pragma once
 
 #include "AudioNode.h"
+#include "WorkStealingQueue.h"
+#include "DelayLine.h"
+#include "CallbackProfiler.h"
+#include "ThreadScheduling.h"
 #include "../../lib/choc/threading/choc_SpinLock.h"
 #include "../../lib/choc/audio/choc_SampleBuffers.h"
 #include <vector>
 #include <memory>
 #include <unordered_set>
 #include <unordered_map>
+#include <map>
 #include <atomic>
 #include <functional>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <semaphore>
 
 class AudioGraph {
 public:
+    // Fan-in of several connections on one input port, summed before the node runs
+    struct InputSum {
+        int bufferIndex;                      // Junction buffer the sources are mixed into
+        int numChannels;                      // Widest source; mono sources are spread across it
+        std::vector<int> sourceBufferIndices;
+        std::vector<int> sourceChannelCounts;
+        std::vector<AudioNode*> sourceNodes;
+        std::vector<int> sourceDelaySamples;  // Latency compensation per source (0 = none)
+    };
+
     // Compiled processing instruction for real-time thread
     struct ProcessingInstruction {
         std::shared_ptr<AudioNode> node;
-        std::vector<int> inputBufferIndices;  // Which temp buffers to read from
+        std::vector<InputSum> inputSums;      // Junctions to mix before processing
+        std::vector<int> inputBufferIndices;  // Which temp buffers to read from, one per connected port
+        std::vector<int> inputChannelCounts;  // Channels the upstream node rendered into each input buffer
         int outputBufferIndex;                // Which temp buffer to write to
+        int numOutputChannels = 1;            // Channels the node renders into its output buffer
+        bool processInPlace = false;          // Output buffer is the (single) input buffer
+        std::vector<int> sourceInstructions;  // Instructions feeding this one, over all ports
+        int inputDelaySamples = 0;            // Longest latency-compensation delay on any input
+        int latencySamples = 0;               // Latency from graph input to this node's output
+        std::vector<int> dependents;          // Instructions waiting on this one (data and buffer-reuse edges)
+        int numDependencies = 0;              // Instructions that must finish before this one can start
     };
 
     // Compiled graph for real-time processing
     struct CompiledGraph {
         std::vector<ProcessingInstruction> instructions;
         std::vector<std::shared_ptr<AudioNode>> outputNodes;
-        int numTempBuffers;
+        int numTempBuffers = 0;
+        std::vector<int> tempBufferChannels;  // Channel count of each temp buffer
+        std::vector<int> rootInstructions;    // Instructions with no dependencies
+        std::vector<int> outputInstructions;  // Instruction of each output node
+        std::vector<int> outputBufferIndices; // Temp buffer holding each output node's result
+        std::vector<int> outputChannelCounts; // Channels rendered into each of those buffers
+        std::vector<int> outputDelaySamples;  // Lines output nodes up with the slowest one (0 = none)
+        int latencySamples = 0;               // Total latency from graph input to output
         bool prepared = false;
         AudioNode::PrepareInfo prepareInfo;
     };
 
+    // A batch of edits staged off to the side and applied together by commitTransaction(),
+    // so the graph is validated and recompiled once instead of after every call
+    class Transaction {
+    public:
+        void addNode(std::shared_ptr<AudioNode> node);
+        void removeNode(std::shared_ptr<AudioNode> node);
+        void connectNodes(std::shared_ptr<AudioNode> source, std::shared_ptr<AudioNode> destination, int inputPort = 0);
+        void disconnectNodes(std::shared_ptr<AudioNode> source, std::shared_ptr<AudioNode> destination);
+        void addOutputNode(std::shared_ptr<AudioNode> node);
+        void removeOutputNode(std::shared_ptr<AudioNode> node);
+        
+        bool isEmpty() const { return edits.empty(); }
+        size_t getNumEdits() const { return edits.size(); }
+        
+    private:
+        friend class AudioGraph;
+        
+        enum class EditType { AddNode, RemoveNode, Connect, Disconnect, AddOutput, RemoveOutput };
+        struct Edit {
+            EditType type;
+            std::shared_ptr<AudioNode> node;         // The node, or the source of a connection
+            std::shared_ptr<AudioNode> destination;
+            int inputPort = 0;
+        };
+        std::vector<Edit> edits;
+    };
+
     AudioGraph();
     ~AudioGraph() = default;
 
@@ -35,9 +98,16 @@ public:
     void addNode(std::shared_ptr<AudioNode> node);
     void removeNode(std::shared_ptr<AudioNode> node);
     void clear();
-    void connectNodes(std::shared_ptr<AudioNode> source, std::shared_ptr<AudioNode> destination);
+    // Returns false (leaving the graph untouched) if the port doesn't exist or the connection
+    // would create a feedback loop
+    bool connectNodes(std::shared_ptr<AudioNode> source, std::shared_ptr<AudioNode> destination, int inputPort = 0);
     void disconnectNodes(std::shared_ptr<AudioNode> source, std::shared_ptr<AudioNode> destination);
 
+    // Batched edits: stage on a Transaction, then commit. Returns false (leaving the graph
+    // untouched) if the batch would create a feedback loop.
+    Transaction beginTransaction() const { return Transaction(); }
+    bool commitTransaction(Transaction& transaction);
+
     // Set the output node(s) - these are the final nodes in the chain
     void setOutputNode(std::shared_ptr<AudioNode> node);
     void addOutputNode(std::shared_ptr<AudioNode> node);
@@ -45,8 +115,12 @@ public:
 
     // Prepare and compile the graph (called from non-real-time thread)
     void prepare(const AudioNode::PrepareInfo& info);
-    void markDirty() { isDirty.store(true); }
+    void markDirty();
     bool needsRecompile() const { return isDirty.load(); }
+    
+    // Block the calling (compiler) thread until the graph changes or the timeout expires.
+    // Returns true if the graph needs recompiling.
+    bool waitForChanges(std::chrono::milliseconds timeout);
 
     // Get compiled graph for real-time processing
     std::shared_ptr<CompiledGraph> getCompiledGraph();
@@ -54,32 +128,105 @@ public:
     // Get current compiled graph without recompilation (lock-free)
     std::shared_ptr<CompiledGraph> getCurrentCompiledGraph() const { return currentCompiledGraph; }
 
+    // Reuse cached adjacency and scheduling between compiles (on by default). Turning it off
+    // rebuilds everything from scratch on every compile; both produce identical graphs.
+    // The schedule is searched again only from the first node whose inputs an edit changed,
+    // and instructions scheduled before the first node an edit touched are carried over from
+    // the previous compile, so buffers are only assigned again from that node on.
+    void setIncrementalCompilation(bool enabled);
+    bool isIncrementalCompilation() const { return incrementalCompilation; }
+
+    // Keep independent branches in separate buffers so they can run concurrently.
+    // In-place chains still share buffers; takes effect on the next compile.
+    void setParallelProcessing(bool enabled);
+    bool isParallelProcessing() const { return parallelProcessing; }
+
     // Utility functions
     size_t getNodeCount() const { return nodes.size(); }
     const std::vector<std::shared_ptr<AudioNode>>& getNodes() const { return nodes; }
+    const std::vector<std::shared_ptr<AudioNode>>& getOutputNodes() const { return outputNodes; }
     
     // Safe way to modify graph from application thread
     void performGraphModification(std::function<void()> modification);
+    
+    // Rebuild `outputNode` and everything feeding it in `destination` (same order, ports and
+    // output), using copyNode(original) for each node. Fails if copyNode returns nullptr.
+    using NodeCopier = std::function<std::shared_ptr<AudioNode>(const std::shared_ptr<AudioNode>&)>;
+    bool copySubgraph(const std::shared_ptr<AudioNode>& outputNode, AudioGraph& destination,
+                      const NodeCopier& copyNode) const;
+    
+    // `node` and every node feeding it, in insertion order
+    std::vector<std::shared_ptr<AudioNode>> getUpstreamNodes(const std::shared_ptr<AudioNode>& node) const;
 
 private:
     // Graph structure (modified from non-real-time thread)
     std::vector<std::shared_ptr<AudioNode>> nodes;
     std::vector<std::shared_ptr<AudioNode>> outputNodes;
     std::unordered_map<std::shared_ptr<AudioNode>, std::vector<std::shared_ptr<AudioNode>>> connections;
+    std::map<std::pair<AudioNode*, AudioNode*>, int> connectionPorts; // (source, destination) -> input port, when not 0
     
     // Compilation state
     std::atomic<bool> isDirty{true};
     std::shared_ptr<CompiledGraph> currentCompiledGraph;
     mutable choc::threading::SpinLock compilationLock;
+    std::mutex compiledGraphMutex;              // Serialises getCompiledGraph between non-real-time threads
+    std::mutex dirtyMutex;
+    std::condition_variable dirtyCondition;     // Wakes the compiler thread on edits
     
     AudioNode::PrepareInfo currentPrepareInfo;
     bool prepared = false;
+    bool parallelProcessing = false;
+    std::unordered_set<AudioNode*> preparedNodes; // Nodes already prepared with currentPrepareInfo
+
+    // Each node's sources, in insertion order
+    struct NodeInput {
+        std::shared_ptr<AudioNode> source;
+        int port;
+    };
+    using InputMap = std::unordered_map<AudioNode*, std::vector<NodeInput>>;
+    
+    // Incremental compilation state, kept up to date by the edit methods
+    bool incrementalCompilation = true;
+    InputMap cachedInputs;                              // Reverse adjacency
+    std::unordered_map<AudioNode*, uint64_t> insertionOrder; // Position of each node in `nodes`
+    uint64_t nextInsertionOrder = 0;
+    std::unordered_map<AudioNode*, int> topologicalOrder; // Valid topological ranks (Pearce-Kelly)
+    int nextTopologicalOrder = 0;
+    bool structureChanged = true;                       // Nodes, connections or outputs edited since the last sort
+    bool cachesStale = false;                           // Structure edited behind our back (performGraphModification)
+    std::unordered_set<AudioNode*> editedNodes;         // Inputs, consumers or output status changed since the last incremental compile
+    std::shared_ptr<CompiledGraph> cachedCompiledGraph; // Last compile, reused up to the first edited node
+    
+    // The last schedule and how its depth-first search went, so the next search can resume
+    // where an edit first changes it. Discoveries number nodes in the order the search reached them.
+    std::vector<std::shared_ptr<AudioNode>> cachedSortedNodes;
+    std::unordered_map<AudioNode*, int> schedulePositions; // Index in cachedSortedNodes (-1 while being searched)
+    std::vector<int> scheduleDiscoveries;               // Discovery of each scheduled node
+    std::vector<int> discoveryPositions;                // Schedule index of each discovered node
+    std::vector<int> discoveryScheduleSizes;            // Nodes already scheduled when each was discovered
+    size_t scheduleResumePoint = 0;                     // First discovery whose inputs may have changed
+    
+    // Edit helpers, called with compilationLock held
+    void addNodeLocked(const std::shared_ptr<AudioNode>& node);
+    void markEdited(const std::shared_ptr<AudioNode>& node) { editedNodes.insert(node.get()); }
+    void markRewired(const std::shared_ptr<AudioNode>& node);
+    void removeNodeLocked(const std::shared_ptr<AudioNode>& node);
+    bool insertTopologicalEdge(const std::shared_ptr<AudioNode>& source, const std::shared_ptr<AudioNode>& destination);
+    void rebuildCaches();
 
     // Graph compilation methods
     std::shared_ptr<CompiledGraph> compileGraph();
-    std::vector<std::shared_ptr<AudioNode>> topologicalSort();
-    void assignBufferIndices(const std::vector<std::shared_ptr<AudioNode>>& sortedNodes, 
-                           std::vector<ProcessingInstruction>& instructions);
+    InputMap buildInputMap() const;
+    std::vector<std::shared_ptr<AudioNode>> collectUpstreamNodes(const std::shared_ptr<AudioNode>& node,
+                                                                 const InputMap& inputs) const;
+    std::vector<std::shared_ptr<AudioNode>> topologicalSort(const InputMap& inputs);
+    void updateSchedule();
+    size_t countReusableInstructions(const std::vector<std::shared_ptr<AudioNode>>& sortedNodes) const;
+    int assignBufferIndices(const std::vector<std::shared_ptr<AudioNode>>& sortedNodes, 
+                            const InputMap& inputs,
+                            size_t numReused,
+                            std::vector<ProcessingInstruction>& instructions);
+    int resolveNumOutputChannels(const std::shared_ptr<AudioNode>& node) const;
     bool hasCycle() const;
     void dfsVisit(std::shared_ptr<AudioNode> node, 
                   std::unordered_set<std::shared_ptr<AudioNode>>& visited,
@@ -91,26 +238,128 @@ private:
 class AudioGraphProcessor {
 public:
     AudioGraphProcessor();
-    ~AudioGraphProcessor() = default;
+    ~AudioGraphProcessor();
 
-    // Set the compiled graph (called from non-real-time thread)
+    // Publish a compiled graph (called from non-real-time thread). The audio thread picks it
+    // up with a single atomic load; the previous graph is retired rather than freed.
     void setCompiledGraph(std::shared_ptr<AudioGraph::CompiledGraph> graph);
+    
+    // Free retired graphs the audio thread can no longer be using (called from non-real-time thread)
+    void releaseRetiredGraphs();
+    
+    // Worker threads that run ready instructions alongside the audio thread (0 = serial).
+    // Must not be called while processGraph is running.
+    void setNumWorkerThreads(int numWorkers);
+    int getNumWorkerThreads() const { return static_cast<int>(workerThreads.size()); }
+    
+    // Scheduling for workers started by the next setNumWorkerThreads. Worker i is pinned to
+    // cores[i % cores.size()]; with no cores given, workers spread one per core after the
+    // audio thread's. Results are filled in as each worker starts.
+    void setWorkerThreadScheduling(const ThreadScheduling::Settings& settings) { workerScheduling = settings; }
+    std::vector<ThreadScheduling::Result> getWorkerSchedulingResults() const;
+    
+    // Graphs with fewer instructions than this are processed serially
+    void setParallelThreshold(int minInstructions) { parallelThreshold = minInstructions; }
+    int getParallelThreshold() const { return parallelThreshold; }
 
-    // Process the graph (called from real-time thread)
+    // Process the graph (called from real-time thread). Never allocates: blocks longer than the
+    // graph's prepared maxBufferSize are processed in pieces of that size.
     void processGraph(
         choc::buffer::ChannelArrayView<const float> inputBuffers,
         choc::buffer::ChannelArrayView<float> outputBuffers,
         double sampleRate,
         int blockSize
     );
+    
+    // Callback and per-node timings (non-real-time thread). Empty unless built with AUDIO_PROFILING.
+    GraphProfileSnapshot getProfileSnapshot();
 
 private:
-    std::shared_ptr<AudioGraph::CompiledGraph> compiledGraph;
-    mutable choc::threading::SpinLock graphLock;
+    // A compiled graph together with the temp buffer slab laid out for it
+    struct PreparedGraph {
+        std::shared_ptr<AudioGraph::CompiledGraph> graph;
+        std::vector<float> slab;               // One block for every temp channel (over-allocated for alignment)
+        std::vector<float*> channelPtrs;       // Start of each temp channel inside the slab
+        std::vector<int> bufferFirstChannel;   // Index into channelPtrs of each temp buffer's first channel
+        std::vector<float*> inputChannelTable; // Input channel pointers of every instruction, back to back
+        std::vector<size_t> inputTableOffsets; // Where each instruction's inputs start in inputChannelTable
+        int framesPerChannel = 0;
+        
+        // Parallel execution state: one ready queue per participant (audio thread first, then workers)
+        std::unique_ptr<std::atomic<int>[]> pendingDependencies;
+        std::vector<std::unique_ptr<WorkStealingQueue>> readyQueues;
+        std::atomic<int> remainingInstructions{0};
+        
+        // Latency compensation lines. Their contents are per-block state, so they live here
+        // rather than in the shared compiled graph, keyed by (source, destination) or (output
+        // node, nullptr): a recompile hands each line that still exists, and the audio in
+        // flight in it, over to the next graph.
+        std::map<std::pair<AudioNode*, AudioNode*>, std::shared_ptr<DelayLine>> delayLines;
+        std::vector<DelayLine*> inputDelays;       // Every input sum source, instruction by instruction (null = none)
+        std::vector<size_t> inputDelayOffsets;     // Where each instruction's sources start in inputDelays
+        std::vector<DelayLine*> outputDelays;      // Per graph output (null = none)
+        
+        // Silence tracking, per instruction
+        std::vector<char> outputSilent;        // Output was all zeros this block
+        std::vector<int> silentInputSamples;   // How long every input has been silent
+        
+#if AUDIO_PROFILING
+        // Per participant, per instruction: each thread only writes its own row
+        std::unique_ptr<TimingHistogram[]> nodeTimings;
+#endif
+    };
+    
+    struct BlockContext {
+        choc::buffer::ChannelArrayView<const float> inputBuffers;
+        choc::buffer::FrameCount numSamples = 0;
+        double sampleRate = 0.0;
+        int blockSize = 0;
+    };
+
+    // Graph used by processGraph, swapped wait-free by setCompiledGraph
+    std::atomic<PreparedGraph*> activeGraph{nullptr};
+    
+    // processGraph calls started/finished, used to tell when a retired graph is unreachable
+    std::atomic<uint64_t> blocksStarted{0};
+    std::atomic<uint64_t> blocksFinished{0};
+    
+    struct RetiredGraph {
+        std::unique_ptr<PreparedGraph> graph;
+        uint64_t blocksStartedWhenRetired;
+    };
+    std::vector<RetiredGraph> retiredGraphs;
+    std::mutex retiredGraphsMutex;
+    std::mutex publishMutex;  // Serialises setCompiledGraph, which takes over the active graph's delay lines
+
+    static constexpr size_t slabAlignmentFloats = 16; // 64-byte alignment for every channel
+
+    // Parallel execution
+    std::vector<std::thread> workerThreads;
+    ThreadScheduling::Settings workerScheduling;
+    std::vector<ThreadScheduling::Result> workerSchedulingResults;
+    mutable std::mutex workerSchedulingMutex;
+    std::counting_semaphore<> workerWakeup{0};
+    std::atomic<bool> shouldStopWorkers{false};
+    std::atomic<bool> blockActive{false};
+    std::atomic<int> workersInBlock{0};
+    PreparedGraph* parallelGraph = nullptr;  // Handed to workers along with blockActive
+    BlockContext parallelContext;
+    int parallelThreshold = 16;
     
-    // Temporary buffers for intermediate processing
-    std::vector<std::vector<float>> tempBuffers;
-    std::vector<float*> tempBufferPtrs;
+#if AUDIO_PROFILING
+    CallbackProfile callbackProfile;
+#endif
     
-    void ensureTempBuffersSize(int numBuffers, int numChannels, int numSamples);
+    void allocateTempBuffers(PreparedGraph& prepared, int numFrames);
+    void allocateParallelState(PreparedGraph& prepared);
+    void allocateDelayLines(PreparedGraph& prepared, const PreparedGraph* previous);
+    void processBlock(PreparedGraph& prepared, choc::buffer::ChannelArrayView<const float> inputBuffers,
+                      choc::buffer::ChannelArrayView<float> outputBuffers, double sampleRate, int blockSize);
+    void processInstruction(PreparedGraph& prepared, int instructionIndex, int participant, const BlockContext& context);
+    void processParallel(PreparedGraph& prepared, const BlockContext& context);
+    void runReadyInstructions(PreparedGraph& prepared, int participant, const BlockContext& context);
+    void workerThreadFunction(int participant);
+    void stopWorkerThreads();
+    choc::buffer::ChannelArrayView<float> getTempBufferView(const PreparedGraph& prepared, int bufferIndex,
+                                                            int numChannels, choc::buffer::FrameCount numFrames) const;
 };
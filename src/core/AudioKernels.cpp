@@ -0,0 +1,575 @@
+#include "AudioKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace AudioKernels {
+
+namespace {
+    // Each kernel handles `width` consecutive channels starting at `firstChannel`.
+    // Interleaved frames are `stride` floats apart; the group's samples sit at firstChannel within each frame.
+
+    void interleaveGroupScalar(const float* const* source, float* destination, int firstChannel, int width,
+                               int stride, int firstFrame, int numFrames) {
+        for (int frame = firstFrame; frame < numFrames; ++frame) {
+            float* out = destination + static_cast<size_t>(frame) * stride + firstChannel;
+            for (int ch = 0; ch < width; ++ch) {
+                out[ch] = source[firstChannel + ch][frame];
+            }
+        }
+    }
+
+    void deinterleaveGroupScalar(const float* source, float* const* destination, int firstChannel, int width,
+                                 int stride, int firstFrame, int numFrames) {
+        for (int frame = firstFrame; frame < numFrames; ++frame) {
+            const float* in = source + static_cast<size_t>(frame) * stride + firstChannel;
+            for (int ch = 0; ch < width; ++ch) {
+                destination[firstChannel + ch][frame] = in[ch];
+            }
+        }
+    }
+
+#if defined(AUDIO_KERNELS_SSE)
+    using Vec4 = __m128;
+    inline Vec4 load4(const float* p) { return _mm_loadu_ps(p); }
+    inline void store4(float* p, Vec4 v) { _mm_storeu_ps(p, v); }
+    inline void transpose4(Vec4& r0, Vec4& r1, Vec4& r2, Vec4& r3) { _MM_TRANSPOSE4_PS(r0, r1, r2, r3); }
+#elif defined(AUDIO_KERNELS_NEON)
+    using Vec4 = float32x4_t;
+    inline Vec4 load4(const float* p) { return vld1q_f32(p); }
+    inline void store4(float* p, Vec4 v) { vst1q_f32(p, v); }
+    inline void transpose4(Vec4& r0, Vec4& r1, Vec4& r2, Vec4& r3) {
+        float32x4x2_t t01 = vtrnq_f32(r0, r1);
+        float32x4x2_t t23 = vtrnq_f32(r2, r3);
+        r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+        r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+        r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+        r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+    }
+#endif
+
+#if defined(AUDIO_KERNELS_SSE) || defined(AUDIO_KERNELS_NEON)
+    // 4 channels x 4 frames per step: load one vector per channel, transpose, store one per frame
+    int interleave4(const float* const* source, float* destination, int firstChannel, int stride, int numFrames) {
+        const float* c0 = source[firstChannel];
+        const float* c1 = source[firstChannel + 1];
+        const float* c2 = source[firstChannel + 2];
+        const float* c3 = source[firstChannel + 3];
+        
+        int frame = 0;
+        for (; frame + 4 <= numFrames; frame += 4) {
+            Vec4 r0 = load4(c0 + frame), r1 = load4(c1 + frame), r2 = load4(c2 + frame), r3 = load4(c3 + frame);
+            transpose4(r0, r1, r2, r3);
+            float* out = destination + static_cast<size_t>(frame) * stride + firstChannel;
+            store4(out, r0);
+            store4(out + stride, r1);
+            store4(out + 2 * stride, r2);
+            store4(out + 3 * stride, r3);
+        }
+        return frame;
+    }
+
+    int deinterleave4(const float* source, float* const* destination, int firstChannel, int stride, int numFrames) {
+        float* c0 = destination[firstChannel];
+        float* c1 = destination[firstChannel + 1];
+        float* c2 = destination[firstChannel + 2];
+        float* c3 = destination[firstChannel + 3];
+        
+        int frame = 0;
+        for (; frame + 4 <= numFrames; frame += 4) {
+            const float* in = source + static_cast<size_t>(frame) * stride + firstChannel;
+            Vec4 r0 = load4(in), r1 = load4(in + stride), r2 = load4(in + 2 * stride), r3 = load4(in + 3 * stride);
+            transpose4(r0, r1, r2, r3);
+            store4(c0 + frame, r0);
+            store4(c1 + frame, r1);
+            store4(c2 + frame, r2);
+            store4(c3 + frame, r3);
+        }
+        return frame;
+    }
+#endif
+
+#if defined(AUDIO_KERNELS_AVX2)
+    // Full 8x8 transpose in 256-bit registers
+    inline void transpose8(__m256 r[8]) {
+        __m256 t0 = _mm256_unpacklo_ps(r[0], r[1]), t1 = _mm256_unpackhi_ps(r[0], r[1]);
+        __m256 t2 = _mm256_unpacklo_ps(r[2], r[3]), t3 = _mm256_unpackhi_ps(r[2], r[3]);
+        __m256 t4 = _mm256_unpacklo_ps(r[4], r[5]), t5 = _mm256_unpackhi_ps(r[4], r[5]);
+        __m256 t6 = _mm256_unpacklo_ps(r[6], r[7]), t7 = _mm256_unpackhi_ps(r[6], r[7]);
+        
+        __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)), s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)), s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0)), s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0)), s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+        
+        r[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+        r[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+        r[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+        r[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+        r[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+        r[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+        r[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+        r[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+    }
+
+    int interleave8(const float* const* source, float* destination, int firstChannel, int stride, int numFrames) {
+        int frame = 0;
+        for (; frame + 8 <= numFrames; frame += 8) {
+            __m256 r[8];
+            for (int ch = 0; ch < 8; ++ch) r[ch] = _mm256_loadu_ps(source[firstChannel + ch] + frame);
+            transpose8(r);
+            float* out = destination + static_cast<size_t>(frame) * stride + firstChannel;
+            for (int i = 0; i < 8; ++i) _mm256_storeu_ps(out + i * stride, r[i]);
+        }
+        return frame;
+    }
+
+    int deinterleave8(const float* source, float* const* destination, int firstChannel, int stride, int numFrames) {
+        int frame = 0;
+        for (; frame + 8 <= numFrames; frame += 8) {
+            const float* in = source + static_cast<size_t>(frame) * stride + firstChannel;
+            __m256 r[8];
+            for (int i = 0; i < 8; ++i) r[i] = _mm256_loadu_ps(in + i * stride);
+            transpose8(r);
+            for (int ch = 0; ch < 8; ++ch) _mm256_storeu_ps(destination[firstChannel + ch] + frame, r[ch]);
+        }
+        return frame;
+    }
+#elif defined(AUDIO_KERNELS_SSE) || defined(AUDIO_KERNELS_NEON)
+    // Two 4x4 transposes side by side
+    int interleave8(const float* const* source, float* destination, int firstChannel, int stride, int numFrames) {
+        int done = interleave4(source, destination, firstChannel, stride, numFrames);
+        interleave4(source, destination, firstChannel + 4, stride, done);
+        return done;
+    }
+
+    int deinterleave8(const float* source, float* const* destination, int firstChannel, int stride, int numFrames) {
+        int done = deinterleave4(source, destination, firstChannel, stride, numFrames);
+        deinterleave4(source, destination, firstChannel + 4, stride, done);
+        return done;
+    }
+#endif
+
+#if defined(AUDIO_KERNELS_SSE)
+    int interleave2(const float* const* source, float* destination, int firstChannel, int stride, int numFrames) {
+        const float* left = source[firstChannel];
+        const float* right = source[firstChannel + 1];
+        
+        int frame = 0;
+        for (; frame + 4 <= numFrames; frame += 4) {
+            __m128 l = _mm_loadu_ps(left + frame), r = _mm_loadu_ps(right + frame);
+            __m128 lo = _mm_unpacklo_ps(l, r); // L0 R0 L1 R1
+            __m128 hi = _mm_unpackhi_ps(l, r); // L2 R2 L3 R3
+            float* out = destination + static_cast<size_t>(frame) * stride + firstChannel;
+            
+            if (stride == 2) {
+                _mm_storeu_ps(out, lo);
+                _mm_storeu_ps(out + 4, hi);
+            } else {
+                _mm_storel_pi(reinterpret_cast<__m64*>(out), lo);
+                _mm_storeh_pi(reinterpret_cast<__m64*>(out + stride), lo);
+                _mm_storel_pi(reinterpret_cast<__m64*>(out + 2 * stride), hi);
+                _mm_storeh_pi(reinterpret_cast<__m64*>(out + 3 * stride), hi);
+            }
+        }
+        return frame;
+    }
+
+    int deinterleave2(const float* source, float* const* destination, int firstChannel, int stride, int numFrames) {
+        float* left = destination[firstChannel];
+        float* right = destination[firstChannel + 1];
+        
+        int frame = 0;
+        for (; frame + 4 <= numFrames; frame += 4) {
+            const float* in = source + static_cast<size_t>(frame) * stride + firstChannel;
+            __m128 lo, hi;
+            if (stride == 2) {
+                lo = _mm_loadu_ps(in);
+                hi = _mm_loadu_ps(in + 4);
+            } else {
+                lo = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(in)),
+                                  reinterpret_cast<const __m64*>(in + stride));
+                hi = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(in + 2 * stride)),
+                                  reinterpret_cast<const __m64*>(in + 3 * stride));
+            }
+            _mm_storeu_ps(left + frame, _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(right + frame, _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+        return frame;
+    }
+#elif defined(AUDIO_KERNELS_NEON)
+    int interleave2(const float* const* source, float* destination, int firstChannel, int stride, int numFrames) {
+        const float* left = source[firstChannel];
+        const float* right = source[firstChannel + 1];
+        
+        int frame = 0;
+        for (; frame + 4 <= numFrames; frame += 4) {
+            float32x4x2_t zipped = vzipq_f32(vld1q_f32(left + frame), vld1q_f32(right + frame));
+            float* out = destination + static_cast<size_t>(frame) * stride + firstChannel;
+            vst1_f32(out, vget_low_f32(zipped.val[0]));
+            vst1_f32(out + stride, vget_high_f32(zipped.val[0]));
+            vst1_f32(out + 2 * stride, vget_low_f32(zipped.val[1]));
+            vst1_f32(out + 3 * stride, vget_high_f32(zipped.val[1]));
+        }
+        return frame;
+    }
+
+    int deinterleave2(const float* source, float* const* destination, int firstChannel, int stride, int numFrames) {
+        float* left = destination[firstChannel];
+        float* right = destination[firstChannel + 1];
+        
+        int frame = 0;
+        for (; frame + 4 <= numFrames; frame += 4) {
+            const float* in = source + static_cast<size_t>(frame) * stride + firstChannel;
+            float32x4_t lo = vcombine_f32(vld1_f32(in), vld1_f32(in + stride));
+            float32x4_t hi = vcombine_f32(vld1_f32(in + 2 * stride), vld1_f32(in + 3 * stride));
+            float32x4x2_t unzipped = vuzpq_f32(lo, hi);
+            vst1q_f32(left + frame, unzipped.val[0]);
+            vst1q_f32(right + frame, unzipped.val[1]);
+        }
+        return frame;
+    }
+#endif
+}
+
+void interleaveScalar(const float* const* source, float* destination, int numChannels, int numFrames) {
+    interleaveGroupScalar(source, destination, 0, numChannels, numChannels, 0, numFrames);
+}
+
+void deinterleaveScalar(const float* source, float* const* destination, int numChannels, int numFrames) {
+    deinterleaveGroupScalar(source, destination, 0, numChannels, numChannels, 0, numFrames);
+}
+
+void interleave(const float* const* source, float* destination, int numChannels, int numFrames) {
+    if (numChannels == 1) {
+        copySamples(destination, source[0], numFrames);
+        return;
+    }
+    
+#if defined(AUDIO_KERNELS_SSE) || defined(AUDIO_KERNELS_NEON)
+    for (int channel = 0; channel < numChannels;) {
+        int remaining = numChannels - channel;
+        int width = remaining >= 8 ? 8 : remaining >= 4 ? 4 : remaining >= 2 ? 2 : 1;
+        
+        int done = 0;
+        switch (width) {
+            case 8: done = interleave8(source, destination, channel, numChannels, numFrames); break;
+            case 4: done = interleave4(source, destination, channel, numChannels, numFrames); break;
+            case 2: done = interleave2(source, destination, channel, numChannels, numFrames); break;
+            default: break;
+        }
+        
+        // Frames left over by the vector loop (and single channels) go through the scalar path
+        interleaveGroupScalar(source, destination, channel, width, numChannels, done, numFrames);
+        channel += width;
+    }
+#else
+    interleaveScalar(source, destination, numChannels, numFrames);
+#endif
+}
+
+void deinterleave(const float* source, float* const* destination, int numChannels, int numFrames) {
+    if (numChannels == 1) {
+        copySamples(destination[0], source, numFrames);
+        return;
+    }
+    
+#if defined(AUDIO_KERNELS_SSE) || defined(AUDIO_KERNELS_NEON)
+    for (int channel = 0; channel < numChannels;) {
+        int remaining = numChannels - channel;
+        int width = remaining >= 8 ? 8 : remaining >= 4 ? 4 : remaining >= 2 ? 2 : 1;
+        
+        int done = 0;
+        switch (width) {
+            case 8: done = deinterleave8(source, destination, channel, numChannels, numFrames); break;
+            case 4: done = deinterleave4(source, destination, channel, numChannels, numFrames); break;
+            case 2: done = deinterleave2(source, destination, channel, numChannels, numFrames); break;
+            default: break;
+        }
+        
+        deinterleaveGroupScalar(source, destination, channel, width, numChannels, done, numFrames);
+        channel += width;
+    }
+#else
+    deinterleaveScalar(source, destination, numChannels, numFrames);
+#endif
+}
+
+
+namespace {
+    // Positions advance by repeated addition, exactly as a per-sample loop would, and each
+    // frame's index and fraction come from its own position
+    inline double advance(double position, double increment, int numFrames, int* indices, float* fractions) {
+        for (int i = 0; i < numFrames; ++i) {
+            auto index = static_cast<int>(position);
+            indices[i] = index;
+            fractions[i] = static_cast<float>(position - index);
+            position += increment;
+        }
+        return position;
+    }
+    
+    inline float linearTap(const float* source, size_t stride, int index, float a) {
+        float y1 = source[static_cast<size_t>(index) * stride];
+        float y2 = source[static_cast<size_t>(index + 1) * stride];
+        return y1 + a * (y2 - y1);
+    }
+    
+    inline float cubicTap(const float* source, size_t stride, int index, float a) {
+        float y0 = source[static_cast<size_t>(index - 1) * stride];
+        float y1 = source[static_cast<size_t>(index) * stride];
+        float y2 = source[static_cast<size_t>(index + 1) * stride];
+        float y3 = source[static_cast<size_t>(index + 2) * stride];
+        float a2 = a * a;
+        float a3 = a2 * a;
+        return y1 + 0.5f * a * (y2 - y0) + 
+               0.5f * a2 * (2.0f * y0 - 5.0f * y1 + 4.0f * y2 - y3) + 
+               0.5f * a3 * (-y0 + 3.0f * y1 - 3.0f * y2 + y3);
+    }
+    
+#if defined(AUDIO_KERNELS_SSE)
+    inline Vec4 gather4(const float* source, size_t stride, const int* indices, int offset) {
+        return _mm_setr_ps(source[static_cast<size_t>(indices[0] + offset) * stride], source[static_cast<size_t>(indices[1] + offset) * stride],
+                           source[static_cast<size_t>(indices[2] + offset) * stride], source[static_cast<size_t>(indices[3] + offset) * stride]);
+    }
+    inline Vec4 splat4(float value) { return _mm_set1_ps(value); }
+    inline Vec4 add4(Vec4 a, Vec4 b) { return _mm_add_ps(a, b); }
+    inline Vec4 sub4(Vec4 a, Vec4 b) { return _mm_sub_ps(a, b); }
+    inline Vec4 mul4(Vec4 a, Vec4 b) { return _mm_mul_ps(a, b); }
+    inline Vec4 negate4(Vec4 a) { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+#elif defined(AUDIO_KERNELS_NEON)
+    inline Vec4 gather4(const float* source, size_t stride, const int* indices, int offset) {
+        float lanes[4] = { source[static_cast<size_t>(indices[0] + offset) * stride], source[static_cast<size_t>(indices[1] + offset) * stride],
+                           source[static_cast<size_t>(indices[2] + offset) * stride], source[static_cast<size_t>(indices[3] + offset) * stride] };
+        return vld1q_f32(lanes);
+    }
+    inline Vec4 splat4(float value) { return vdupq_n_f32(value); }
+    inline Vec4 add4(Vec4 a, Vec4 b) { return vaddq_f32(a, b); }
+    inline Vec4 sub4(Vec4 a, Vec4 b) { return vsubq_f32(a, b); }
+    inline Vec4 mul4(Vec4 a, Vec4 b) { return vmulq_f32(a, b); }
+    inline Vec4 negate4(Vec4 a) { return vnegq_f32(a); }
+#endif
+}
+
+double resampleNearest(const float* source, size_t stride, double position, double increment,
+                       float gain, float* destination, int numFrames) {
+    for (int i = 0; i < numFrames; ++i) {
+        destination[i] = source[static_cast<size_t>(static_cast<int>(position)) * stride] * gain;
+        position += increment;
+    }
+    return position;
+}
+
+double resampleLinear(const float* source, size_t stride, double position, double increment,
+                      float gain, float* destination, int numFrames) {
+    int indices[4];
+    float fractions[4];
+    int i = 0;
+#if defined(AUDIO_KERNELS_SSE) || defined(AUDIO_KERNELS_NEON)
+    const Vec4 gains = splat4(gain);
+    for (; i + 4 <= numFrames; i += 4) {
+        position = advance(position, increment, 4, indices, fractions);
+        Vec4 y1 = gather4(source, stride, indices, 0);
+        Vec4 y2 = gather4(source, stride, indices, 1);
+        Vec4 a = load4(fractions);
+        store4(destination + i, mul4(add4(y1, mul4(a, sub4(y2, y1))), gains));
+    }
+#endif
+    for (; i < numFrames; ++i) {
+        position = advance(position, increment, 1, indices, fractions);
+        destination[i] = linearTap(source, stride, indices[0], fractions[0]) * gain;
+    }
+    return position;
+}
+
+double resampleCubic(const float* source, size_t stride, double position, double increment,
+                     float gain, float* destination, int numFrames) {
+    int indices[4];
+    float fractions[4];
+    int i = 0;
+#if defined(AUDIO_KERNELS_SSE) || defined(AUDIO_KERNELS_NEON)
+    const Vec4 gains = splat4(gain);
+    const Vec4 half = splat4(0.5f), two = splat4(2.0f), three = splat4(3.0f), four = splat4(4.0f), five = splat4(5.0f);
+    for (; i + 4 <= numFrames; i += 4) {
+        position = advance(position, increment, 4, indices, fractions);
+        Vec4 y0 = gather4(source, stride, indices, -1);
+        Vec4 y1 = gather4(source, stride, indices, 0);
+        Vec4 y2 = gather4(source, stride, indices, 1);
+        Vec4 y3 = gather4(source, stride, indices, 2);
+        Vec4 a = load4(fractions);
+        Vec4 a2 = mul4(a, a);
+        Vec4 a3 = mul4(a2, a);
+        
+        // Same operations in the same order as cubicTap, so both give identical results
+        Vec4 c1 = mul4(mul4(half, a), sub4(y2, y0));
+        Vec4 c2 = mul4(mul4(half, a2), sub4(add4(sub4(mul4(two, y0), mul4(five, y1)), mul4(four, y2)), y3));
+        Vec4 c3 = mul4(mul4(half, a3), add4(sub4(add4(negate4(y0), mul4(three, y1)), mul4(three, y2)), y3));
+        store4(destination + i, mul4(add4(add4(add4(y1, c1), c2), c3), gains));
+    }
+#endif
+    for (; i < numFrames; ++i) {
+        position = advance(position, increment, 1, indices, fractions);
+        destination[i] = cubicTap(source, stride, indices[0], fractions[0]) * gain;
+    }
+    return position;
+}
+
+namespace {
+    constexpr int sincZeroCrossings = 16;
+    constexpr int sincPhases = 128;
+    constexpr int sincStepsPerOctave = 4;
+    constexpr int sincNumTables = 3 * sincStepsPerOctave + 1;   // Stretched 1x to 8x
+    constexpr double sincCutoff = 0.88;      // Of Nyquist: the transition band ends just below it
+    constexpr double sincKaiserBeta = 6.5;   // Roughly 70 dB stop band
+    
+    // One cutoff's polyphase filter: sincPhases + 1 rows of numTaps coefficients, row p for a
+    // fraction of p / sincPhases (the last row is for interpolating towards a fraction of 1)
+    struct SincTable {
+        int numTaps = 0;
+        std::vector<float> coefficients;
+    };
+    
+    double besselI0(double x) {
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; k < 50 && term > sum * 1e-12; ++k) {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    }
+    
+    std::vector<SincTable> buildSincTables() {
+        const double pi = 3.14159265358979323846;
+        std::vector<SincTable> tables(sincNumTables);
+        
+        for (int step = 0; step < sincNumTables; ++step) {
+            // Stretching the kernel by the decimation factor lowers its cutoff by the same amount
+            const double stretch = std::pow(2.0, static_cast<double>(step) / sincStepsPerOctave);
+            const double cutoff = sincCutoff / stretch;
+            int halfWidth = static_cast<int>(std::ceil(sincZeroCrossings * stretch));
+            halfWidth += halfWidth & 1;   // Whole vectors of taps
+            
+            SincTable& table = tables[static_cast<size_t>(step)];
+            table.numTaps = 2 * halfWidth;
+            table.coefficients.resize(static_cast<size_t>((sincPhases + 1) * table.numTaps));
+            
+            for (int phase = 0; phase <= sincPhases; ++phase) {
+                float* row = table.coefficients.data() + phase * table.numTaps;
+                const double fraction = static_cast<double>(phase) / sincPhases;
+                double sum = 0.0;
+                
+                for (int tap = 0; tap < table.numTaps; ++tap) {
+                    const double distance = (tap - halfWidth + 1) - fraction;
+                    const double x = pi * cutoff * distance;
+                    const double sinc = x == 0.0 ? 1.0 : std::sin(x) / x;
+                    const double r = distance / halfWidth;
+                    const double window = std::abs(r) < 1.0 ? besselI0(sincKaiserBeta * std::sqrt(1.0 - r * r)) / besselI0(sincKaiserBeta) : 0.0;
+                    row[tap] = static_cast<float>(sinc * window);
+                    sum += sinc * window;
+                }
+                
+                // Unity gain at DC for every phase
+                for (int tap = 0; tap < table.numTaps; ++tap) {
+                    row[tap] = static_cast<float>(row[tap] / sum);
+                }
+            }
+        }
+        return tables;
+    }
+    
+    const std::vector<SincTable>& getSincTables() {
+        static const std::vector<SincTable> tables = buildSincTables();
+        return tables;
+    }
+    
+    const SincTable& getSincTable(double increment) {
+        int step = 0;
+        if (increment > 1.0) {
+            // The first table whose cutoff is at or below the decimated Nyquist
+            step = std::clamp(static_cast<int>(std::ceil(std::log2(increment) * sincStepsPerOctave - 1e-9)), 0, sincNumTables - 1);
+        }
+        return getSincTables()[static_cast<size_t>(step)];
+    }
+    
+#if defined(AUDIO_KERNELS_SSE)
+    inline Vec4 loadStrided4(const float* p, size_t stride) { return _mm_setr_ps(p[0], p[stride], p[2 * stride], p[3 * stride]); }
+    inline float sum4(Vec4 v) {
+        Vec4 sums = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        return _mm_cvtss_f32(_mm_add_ss(sums, _mm_shuffle_ps(sums, sums, 1)));
+    }
+#elif defined(AUDIO_KERNELS_NEON)
+    inline Vec4 loadStrided4(const float* p, size_t stride) {
+        float lanes[4] = { p[0], p[stride], p[2 * stride], p[3 * stride] };
+        return vld1q_f32(lanes);
+    }
+    inline float sum4(Vec4 v) {
+        float32x2_t sums = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+        return vget_lane_f32(vpadd_f32(sums, sums), 0);
+    }
+#endif
+    
+    // The taps against two adjacent phase rows at once, four taps per step
+    inline void sincDot(const float* taps, size_t stride, const float* row0, const float* row1, int numTaps,
+                        float& sum0, float& sum1) {
+#if defined(AUDIO_KERNELS_SSE) || defined(AUDIO_KERNELS_NEON)
+        Vec4 accumulator0 = splat4(0.0f), accumulator1 = splat4(0.0f);
+        if (stride == 1) {
+            for (int tap = 0; tap < numTaps; tap += 4) {
+                Vec4 x = load4(taps + tap);
+                accumulator0 = add4(accumulator0, mul4(load4(row0 + tap), x));
+                accumulator1 = add4(accumulator1, mul4(load4(row1 + tap), x));
+            }
+        } else {
+            for (int tap = 0; tap < numTaps; tap += 4) {
+                Vec4 x = loadStrided4(taps + static_cast<size_t>(tap) * stride, stride);
+                accumulator0 = add4(accumulator0, mul4(load4(row0 + tap), x));
+                accumulator1 = add4(accumulator1, mul4(load4(row1 + tap), x));
+            }
+        }
+        sum0 = sum4(accumulator0);
+        sum1 = sum4(accumulator1);
+#else
+        sum0 = sum1 = 0.0f;
+        for (int tap = 0; tap < numTaps; ++tap) {
+            float x = taps[static_cast<size_t>(tap) * stride];
+            sum0 += row0[tap] * x;
+            sum1 += row1[tap] * x;
+        }
+#endif
+    }
+}
+
+void prepareSinc() {
+    getSincTables();
+}
+
+int getSincHalfWidth(double increment) {
+    return getSincTable(increment).numTaps / 2;
+}
+
+double resampleSinc(const float* source, size_t stride, double position, double increment,
+                    float gain, float* destination, int numFrames) {
+    const SincTable& table = getSincTable(increment);
+    const int numTaps = table.numTaps;
+    const int halfWidth = numTaps / 2;
+    
+    for (int i = 0; i < numFrames; ++i) {
+        auto index = static_cast<int>(position);
+        
+        // Between two phase rows; a fraction just under 1 can round up to the last row
+        float phase = static_cast<float>(position - index) * sincPhases;
+        int row = std::min(static_cast<int>(phase), sincPhases - 1);
+        float between = phase - static_cast<float>(row);
+        
+        const float* row0 = table.coefficients.data() + row * numTaps;
+        const float* taps = source + static_cast<std::ptrdiff_t>(index - halfWidth + 1) * static_cast<std::ptrdiff_t>(stride);
+        float sum0, sum1;
+        sincDot(taps, stride, row0, row0 + numTaps, numTaps, sum0, sum1);
+        
+        destination[i] = (sum0 + between * (sum1 - sum0)) * gain;
+        position += increment;
+    }
+    return position;
+}
+
+} // namespace AudioKernels
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define AUDIO_KERNELS_SSE 1
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define AUDIO_KERNELS_AVX2 1
+#endif
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define AUDIO_KERNELS_NEON 1
+#endif
+
+// Small vectorised sample kernels used on the audio thread.
+// Pointers may be unaligned; source and destination must not overlap.
+namespace AudioKernels {
+
+inline void copySamples(float* destination, const float* source, int numSamples) {
+    std::memcpy(destination, source, static_cast<size_t>(numSamples) * sizeof(float));
+}
+
+// destination[i] += source[i]
+inline void addSamples(float* destination, const float* source, int numSamples) {
+    int i = 0;
+#if defined(AUDIO_KERNELS_SSE)
+    for (; i + 8 <= numSamples; i += 8) {
+        __m128 a0 = _mm_loadu_ps(destination + i);
+        __m128 a1 = _mm_loadu_ps(destination + i + 4);
+        __m128 b0 = _mm_loadu_ps(source + i);
+        __m128 b1 = _mm_loadu_ps(source + i + 4);
+        _mm_storeu_ps(destination + i, _mm_add_ps(a0, b0));
+        _mm_storeu_ps(destination + i + 4, _mm_add_ps(a1, b1));
+    }
+#elif defined(AUDIO_KERNELS_NEON)
+    for (; i + 8 <= numSamples; i += 8) {
+        float32x4_t a0 = vld1q_f32(destination + i);
+        float32x4_t a1 = vld1q_f32(destination + i + 4);
+        vst1q_f32(destination + i, vaddq_f32(a0, vld1q_f32(source + i)));
+        vst1q_f32(destination + i + 4, vaddq_f32(a1, vld1q_f32(source + i + 4)));
+    }
+#endif
+    for (; i < numSamples; ++i) {
+        destination[i] += source[i];
+    }
+}
+
+// destination[i] *= gain
+inline void applyGain(float* destination, float gain, int numSamples) {
+    int i = 0;
+#if defined(AUDIO_KERNELS_SSE)
+    const __m128 g = _mm_set1_ps(gain);
+    for (; i + 4 <= numSamples; i += 4) {
+        _mm_storeu_ps(destination + i, _mm_mul_ps(_mm_loadu_ps(destination + i), g));
+    }
+#elif defined(AUDIO_KERNELS_NEON)
+    const float32x4_t g = vdupq_n_f32(gain);
+    for (; i + 4 <= numSamples; i += 4) {
+        vst1q_f32(destination + i, vmulq_f32(vld1q_f32(destination + i), g));
+    }
+#endif
+    for (; i < numSamples; ++i) {
+        destination[i] *= gain;
+    }
+}
+
+// Resampling one channel whose frames are `stride` floats apart into destination[0..numFrames),
+// times gain. Positions start at `position` and advance by repeated addition of `increment`,
+// as a per-sample loop would, so a block renders the same however it's split into runs.
+// Nothing is clamped: the caller keeps every tap inside the source (index for nearest,
+// index..index+1 for linear, index-1..index+2 for Catmull-Rom cubic). Returns the position
+// after the run.
+double resampleNearest(const float* source, size_t stride, double position, double increment,
+                       float gain, float* destination, int numFrames);
+double resampleLinear(const float* source, size_t stride, double position, double increment,
+                      float gain, float* destination, int numFrames);
+double resampleCubic(const float* source, size_t stride, double position, double increment,
+                     float gain, float* destination, int numFrames);
+
+// Band-limited resampling with windowed-sinc (Kaiser) polyphase tables, 16 zero crossings a
+// side, interpolating between 128 phases. Above an increment of 1 the source is decimated,
+// so the table used has its cutoff lowered to match, in quarter-octave steps down to 1/8
+// (faster than 8x aliases again). Each frame reads the taps index-halfWidth+1 ..
+// index+halfWidth, where halfWidth is getSincHalfWidth(increment), at most sincMaxTaps / 2.
+// The tables are built on first use: call prepareSinc() before using this on the audio thread.
+constexpr int sincMaxTaps = 256;
+void prepareSinc();
+int getSincHalfWidth(double increment);
+double resampleSinc(const float* source, size_t stride, double position, double increment,
+                    float gain, float* destination, int numFrames);
+
+// Interleaved <-> separate channel conversion for the device callback. Channel counts are
+// split into groups of 8/4/2/1 with a transposing kernel each, so e.g. 16 channels run as
+// two 8-channel passes. The separate-channel side must not alias the interleaved side.
+void interleave(const float* const* source, float* destination, int numChannels, int numFrames);
+void deinterleave(const float* source, float* const* destination, int numChannels, int numFrames);
+
+// Plain nested loops, for platforms without SIMD and as a reference for tests and benchmarks
+void interleaveScalar(const float* const* source, float* destination, int numChannels, int numFrames);
+void deinterleaveScalar(const float* source, float* const* destination, int numChannels, int numFrames);
+
+} // namespace AudioKernels
@@ -4,6 +4,7 @@
 #include <memory>
 #include <string>
 #include "../../lib/choc/audio/choc_SampleBuffers.h"
+#include "../../lib/choc/audio/choc_MIDI.h"
 
 class AudioNode : public std::enable_shared_from_this<AudioNode> {
 public:
@@ -33,6 +34,44 @@ public:
     bool isBypassed() const { return bypassed; }
     void setBypassed(bool bypass) { bypassed = bypass; }
 
+    // True if processCallback copes with inputBuffers and outputBuffers sharing memory,
+    // letting the graph run this node in place on its single input buffer
+    virtual bool supportsInPlaceProcessing() const { return false; }
+
+    // Number of input ports. Connections to the same port are summed by the graph;
+    // ports are presented to processCallback one after another as channel groups.
+    virtual int getNumInputPorts() const { return 1; }
+
+    // Samples by which this node's output lags its input (lookahead, block-based FFT, ...).
+    // The graph delays shorter parallel paths to match; call AudioGraph::markDirty() if it changes.
+    virtual int getLatencySamples() const { return 0; }
+
+    // Silence: a node that knows its output is all zeros this block (no voices playing,
+    // gain at zero, ...) calls setOutputSilent(true) from processCallback. The graph clears
+    // the flag before each call, and skips nodes whose inputs have all been silent for longer
+    // than their tail.
+    static constexpr int neverSleeps = -1;
+    bool isOutputSilent() const { return outputSilent; }
+    void setOutputSilent(bool silent) { outputSilent = silent; }
+    
+    // Samples this node keeps producing output after its inputs fall silent (reverb tail,
+    // delay feedback, ...). Sleeping is opt-in: the default neverSleeps keeps unannotated
+    // nodes running, so any state they carry rings out. Memoryless nodes return 0.
+    virtual int getTailSamples() const { return neverSleeps; }
+
+    // Output channel count used by the graph (0 = follow the graph's channel count)
+    int getNumOutputChannels() const { return numOutputChannels; }
+    void setNumOutputChannels(int channels) { numOutputChannels = channels > 0 ? channels : 0; }
+
+    // MIDI delivered by AudioEngine::scheduleMidiMessage, on the audio thread between
+    // processCallback calls, so the message takes effect from the first sample of the next call
+    virtual void handleMidiMessage(const choc::midi::ShortMessage& message) {}
+
+    // Independent copy with the same settings, so it can be processed on another thread
+    // (offline and parallel stem renders). Copies only what the control thread owns and starts
+    // from a reset playback state. Nodes that can't be copied return nullptr.
+    virtual std::shared_ptr<AudioNode> clone() const { return nullptr; }
+
 protected:
     // Helper methods for derived classes
     void copyBuffer(choc::buffer::ChannelArrayView<const float> source, choc::buffer::ChannelArrayView<float> destination);
@@ -45,11 +84,19 @@ protected:
     void addToBuffer(const float* source, float* destination, int numSamples);
     void clearBuffer(float* buffer, int numSamples);
     void scaleBuffer(float* buffer, float gain, int numSamples);
+    
+    // For clone(): carry over the settings every node has
+    void copyNodeSettingsTo(AudioNode& copy) const {
+        copy.bypassed = bypassed;
+        copy.numOutputChannels = numOutputChannels;
+    }
 
     // Internal state
     PrepareInfo currentPrepareInfo;
     bool prepared = false;
     bool bypassed = false;
+    int numOutputChannels = 0;
+    bool outputSilent = false;
 
 private:
     std::string name;
@@ -87,6 +87,11 @@ float AudioParameter::getNextValue() {
 }
 
 void AudioParameter::setSampleRate(double newSampleRate) {
+    // Nodes call this every block from the audio thread; only the first call does any work
+    if (newSampleRate == sampleRate) {
+        return;
+    }
+    
     sampleRate = newSampleRate;
     updateRampParameters();
     Logger::debug("AudioParameter '{}' sample rate set to: {}", name, sampleRate);
@@ -128,7 +128,27 @@ double AudioRecorder::getRecordingDuration() const {
     return static_cast<double>(totalSamplesRecorded.load()) / currentSampleRate;
 }
 
+void AudioRecorder::setWriterThreadScheduling(const ThreadScheduling::Settings& settings) {
+    std::lock_guard<std::mutex> lock(schedulingMutex);
+    writerScheduling = settings;
+}
+
+ThreadScheduling::Result AudioRecorder::getWriterThreadSchedulingResult() const {
+    std::lock_guard<std::mutex> lock(schedulingMutex);
+    return writerSchedulingResult;
+}
+
 void AudioRecorder::writerThreadFunction() {
+    {
+        std::lock_guard<std::mutex> lock(schedulingMutex);
+        writerSchedulingResult = ThreadScheduling::applyToCurrentThread(writerScheduling);
+        if (!writerSchedulingResult.succeeded()) {
+            Logger::warn("AudioRecorder writer thread: scheduling {}, affinity {}",
+                         ThreadScheduling::toString(writerSchedulingResult.scheduling),
+                         ThreadScheduling::toString(writerSchedulingResult.affinity));
+        }
+    }
+    
     std::string filename;
     {
         std::lock_guard<std::mutex> lock(filenameMutex);
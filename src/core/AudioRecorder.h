@@ -1,6 +1,7 @@
 #pragma once
 
 #include "AudioNode.h"
+#include "ThreadScheduling.h"
 #include <vector>
 #include <atomic>
 #include <memory>
@@ -37,6 +38,11 @@ public:
     std::vector<float> getRecordedData() const;
     void clearRecordedData();
     
+    // Scheduling for the disk writer thread, applied when the next recording starts. A
+    // real-time priority below the audio thread's keeps the FIFO draining under load.
+    void setWriterThreadScheduling(const ThreadScheduling::Settings& settings);
+    ThreadScheduling::Result getWriterThreadSchedulingResult() const;
+    
     // Statistics
     size_t getTotalSamplesRecorded() const { return totalSamplesRecorded.load(); }
     double getRecordingDuration() const;
@@ -57,6 +63,10 @@ private:
     std::thread writerThread;
     std::mutex filenameMutex;
     
+    ThreadScheduling::Settings writerScheduling;  // Guarded by schedulingMutex
+    ThreadScheduling::Result writerSchedulingResult;
+    mutable std::mutex schedulingMutex;
+    
     // CHOC WAV format handler
     choc::audio::WAVAudioFileFormat<true> wavFormat;
     
@@ -0,0 +1,100 @@
+#include "CallbackProfiler.h"
+#include <algorithm>
+#include <bit>
+
+namespace {
+    constexpr double nanosPerMicro = 1000.0;
+
+    // Durations below this get one bucket per nanosecond. The log buckets start at 8 ns
+    // (index 12), so buckets 8-11 (octave 2, already covered here) stay empty.
+    constexpr uint64_t linearBuckets = 8;
+
+    uint64_t bucketUpperNanos(int bucket) {
+        if (bucket < static_cast<int>(linearBuckets)) {
+            return static_cast<uint64_t>(bucket + 1);
+        }
+        return bucket + 1 < TimingHistogram::numBuckets ? TimingHistogram::bucketLowerNanos(bucket + 1) : UINT64_MAX;
+    }
+}
+
+int TimingHistogram::bucketIndex(uint64_t nanos) {
+    if (nanos < linearBuckets) {
+        return static_cast<int>(nanos);
+    }
+
+    // Octave from the top bit, quarter octave from the two bits below it
+    int octave = static_cast<int>(std::bit_width(nanos)) - 1;
+    int quarter = static_cast<int>((nanos >> (octave - 2)) & 3);
+    return std::min(octave * 4 + quarter, numBuckets - 1);
+}
+
+uint64_t TimingHistogram::bucketLowerNanos(int bucket) {
+    if (bucket < static_cast<int>(linearBuckets)) {
+        return static_cast<uint64_t>(bucket);
+    }
+
+    int octave = bucket / 4;
+    int quarter = bucket % 4;
+    return static_cast<uint64_t>(4 + quarter) << (octave - 2);
+}
+
+void TimingHistogram::Totals::add(const TimingHistogram& histogram) {
+    constexpr auto relaxed = std::memory_order_relaxed;
+
+    uint64_t histogramCount = histogram.count.load(relaxed);
+    if (histogramCount == 0) {
+        return;
+    }
+
+    count += histogramCount;
+    totalNanos += histogram.totalNanos.load(relaxed);
+    minNanos = std::min(minNanos, histogram.minNanos.load(relaxed));
+    maxNanos = std::max(maxNanos, histogram.maxNanos.load(relaxed));
+    for (int bucket = 0; bucket < numBuckets; ++bucket) {
+        buckets[bucket] += histogram.buckets[bucket].load(relaxed);
+    }
+}
+
+TimingSummary TimingHistogram::Totals::summarize() const {
+    TimingSummary summary;
+    if (count == 0) {
+        return summary;
+    }
+
+    summary.count = count;
+    summary.minMicros = static_cast<double>(minNanos) / nanosPerMicro;
+    summary.meanMicros = static_cast<double>(totalNanos) / static_cast<double>(count) / nanosPerMicro;
+    summary.maxMicros = static_cast<double>(maxNanos) / nanosPerMicro;
+
+    // Counters are read one by one while the writer runs, so use the buckets' own total
+    uint64_t bucketTotal = 0;
+    for (uint64_t bucketCount : buckets) bucketTotal += bucketCount;
+
+    uint64_t target = bucketTotal - bucketTotal / 100;
+    uint64_t cumulative = 0;
+    for (int bucket = 0; bucket < numBuckets; ++bucket) {
+        cumulative += buckets[bucket];
+        if (cumulative >= target && cumulative > 0) {
+            summary.p99Micros = static_cast<double>(std::min(bucketUpperNanos(bucket), maxNanos)) / nanosPerMicro;
+            break;
+        }
+    }
+
+    return summary;
+}
+
+void CallbackProfile::record(uint64_t nanos, uint64_t budgetNanos) {
+    constexpr auto relaxed = std::memory_order_relaxed;
+
+    timings.record(nanos);
+    bufferNanos.store(bufferNanos.load(relaxed) + budgetNanos, relaxed);
+
+    if (nanos > budgetNanos) {
+        deadlineMisses.store(deadlineMisses.load(relaxed) + 1, relaxed);
+    }
+
+    double load = budgetNanos > 0 ? static_cast<double>(nanos) / static_cast<double>(budgetNanos) : 0.0;
+    if (load > peakLoad.load(relaxed)) {
+        peakLoad.store(load, relaxed);
+    }
+}
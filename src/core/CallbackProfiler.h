@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Build with AUDIO_PROFILING=1 (CMake option AUDIO_ENGINE_PROFILING) to time every graph
+// callback and every node. Without it the audio thread never touches any of this.
+#ifndef AUDIO_PROFILING
+#define AUDIO_PROFILING 0
+#endif
+
+// Summary of a set of durations, in microseconds
+struct TimingSummary {
+    uint64_t count = 0;
+    double minMicros = 0.0;
+    double meanMicros = 0.0;
+    double maxMicros = 0.0;
+    double p99Micros = 0.0;  // Upper edge of the histogram bucket holding the 99th percentile
+};
+
+// Duration accumulator with a single writer (the thread running the timed code) and any
+// number of readers. Durations are binned on a log scale, four buckets per octave, so
+// percentiles are accurate to within a quarter octave.
+class TimingHistogram {
+public:
+    static constexpr int numBuckets = 128;
+
+    static uint64_t nowNanos() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // Writer only: plain load + store, no read-modify-write
+    void record(uint64_t nanos) {
+        constexpr auto relaxed = std::memory_order_relaxed;
+        count.store(count.load(relaxed) + 1, relaxed);
+        totalNanos.store(totalNanos.load(relaxed) + nanos, relaxed);
+        if (nanos < minNanos.load(relaxed)) minNanos.store(nanos, relaxed);
+        if (nanos > maxNanos.load(relaxed)) maxNanos.store(nanos, relaxed);
+        auto& bucket = buckets[bucketIndex(nanos)];
+        bucket.store(bucket.load(relaxed) + 1, relaxed);
+    }
+
+    static int bucketIndex(uint64_t nanos);
+    static uint64_t bucketLowerNanos(int bucket);
+
+    // Readers merge any number of histograms (e.g. one per thread) into Totals
+    struct Totals {
+        uint64_t count = 0;
+        uint64_t totalNanos = 0;
+        uint64_t minNanos = UINT64_MAX;
+        uint64_t maxNanos = 0;
+        std::array<uint64_t, numBuckets> buckets {};
+
+        void add(const TimingHistogram& histogram);
+        TimingSummary summarize() const;
+    };
+
+private:
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> totalNanos{0};
+    std::atomic<uint64_t> minNanos{UINT64_MAX};
+    std::atomic<uint64_t> maxNanos{0};
+    std::array<std::atomic<uint32_t>, numBuckets> buckets {};
+};
+
+// Times a scope into a histogram
+class ScopedTiming {
+public:
+    explicit ScopedTiming(TimingHistogram& histogram) : histogram(histogram), start(TimingHistogram::nowNanos()) {}
+    ~ScopedTiming() { histogram.record(TimingHistogram::nowNanos() - start); }
+
+private:
+    TimingHistogram& histogram;
+    uint64_t start;
+};
+
+// Whole graph callbacks measured against the duration of the buffer they produce
+struct CallbackProfile {
+    TimingHistogram timings;
+    std::atomic<uint64_t> bufferNanos{0};     // Sum of the buffer durations
+    std::atomic<uint64_t> deadlineMisses{0};  // Callbacks that took longer than their buffer
+    std::atomic<double> peakLoad{0.0};
+
+    // Writer only (the audio thread)
+    void record(uint64_t nanos, uint64_t budgetNanos);
+};
+
+// Point-in-time copy of the profiler counters, safe to read on any thread
+struct GraphProfileSnapshot {
+    bool available = false;  // False when built without AUDIO_PROFILING
+
+    TimingSummary callback;
+    double cpuLoadPercent = 0.0;      // Total callback time over total buffer time
+    double peakCpuLoadPercent = 0.0;  // Worst single callback
+    uint64_t deadlineMisses = 0;
+
+    // Nodes of the active graph in processing order. Restarts whenever a new graph is published.
+    struct NodeTiming {
+        std::string name;
+        TimingSummary timing;
+    };
+    std::vector<NodeTiming> nodes;
+};
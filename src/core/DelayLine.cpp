@@ -0,0 +1,45 @@
+#include "DelayLine.h"
+#include "AudioKernels.h"
+#include <algorithm>
+
+DelayLine::DelayLine(int numChannels, int delaySamples_)
+    : history(static_cast<size_t>(std::max(numChannels, 1)), std::vector<float>(static_cast<size_t>(std::max(delaySamples_, 1)), 0.0f)),
+      delaySamples(std::max(delaySamples_, 1)) {
+}
+
+void DelayLine::read(int channel, const float* input, float* destination, int numSamples, bool addToDestination) const {
+    const auto& ring = history[channel];
+    
+    // The first delaySamples outputs come from history, the rest from this block's input
+    int fromHistory = std::min(numSamples, delaySamples);
+    int index = oldestIndex;
+    for (int i = 0; i < fromHistory; ++i) {
+        destination[i] = addToDestination ? destination[i] + ring[index] : ring[index];
+        if (++index == delaySamples) index = 0;
+    }
+    
+    int fromInput = numSamples - fromHistory;
+    if (fromInput > 0) {
+        if (addToDestination) {
+            AudioKernels::addSamples(destination + fromHistory, input, fromInput);
+        } else {
+            AudioKernels::copySamples(destination + fromHistory, input, fromInput);
+        }
+    }
+}
+
+void DelayLine::write(const float* const* input, int numSamples) {
+    // Only the newest delaySamples inputs survive the block
+    int first = std::max(0, numSamples - delaySamples);
+    
+    for (size_t ch = 0; ch < history.size(); ++ch) {
+        auto& ring = history[ch];
+        int index = (oldestIndex + first) % delaySamples;
+        for (int i = first; i < numSamples; ++i) {
+            ring[index] = input[ch][i];
+            if (++index == delaySamples) index = 0;
+        }
+    }
+    
+    oldestIndex = (oldestIndex + numSamples) % delaySamples;
+}
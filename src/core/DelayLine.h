@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+
+// Fixed delay used by the graph to line up paths with different latencies.
+// Sized once when a compiled graph is handed to a processor; read and write never allocate.
+class DelayLine {
+public:
+    DelayLine(int numChannels, int delaySamples);
+
+    int getDelaySamples() const { return delaySamples; }
+    int getNumChannels() const { return static_cast<int>(history.size()); }
+
+    // Produce the delayed version of this block's input for one channel, overwriting
+    // or adding to destination. Doesn't change state, so a channel may be read several times.
+    void read(int channel, const float* input, float* destination, int numSamples, bool addToDestination) const;
+
+    // Push this block's input (one pointer per channel) and advance by numSamples
+    void write(const float* const* input, int numSamples);
+
+private:
+    std::vector<std::vector<float>> history; // Last delaySamples inputs per channel, ring-ordered
+    int delaySamples;
+    int oldestIndex = 0;
+};
@@ -0,0 +1,383 @@
+#include "DiskStreamer.h"
+#include "Logger.h"
+#include "../../lib/choc/audio/choc_AudioFileFormat_WAV.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+struct DiskStream::IoThread {
+    std::counting_semaphore<> wakeup { 0 };
+    std::atomic<bool> wakePending { false };
+    std::vector<std::weak_ptr<DiskStream>> streams; // Guarded by DiskStreamer::streamsMutex
+};
+
+struct DiskStream::Counters {
+    std::atomic<uint64_t> underrunFrames { 0 };
+    std::atomic<uint64_t> underrunBlocks { 0 };
+    std::atomic<uint64_t> framesRead { 0 };
+    std::atomic<uint64_t> readErrors { 0 };
+};
+
+namespace {
+    uint64_t generationOf(uint32_t sequence) {
+        return (sequence >> 1) & 0xffff;
+    }
+}
+
+StreamedSample::StreamedSample(std::string filePath_, int numChannels_, int64_t numFrames_, double sampleRate_,
+                               std::shared_ptr<const SampleData> head_)
+    : filePath(std::move(filePath_)), numChannels(numChannels_), numFrames(numFrames_),
+      sampleRate(sampleRate_), head(std::move(head_))
+{
+}
+
+int64_t DiskStream::PlayOrder::getSourceFrame(int64_t playFrame) const {
+    auto frame = start + playFrame;
+    if (!loop || frame < end) {
+        return frame;
+    }
+    return wrap + (frame - end) % (end - wrap);
+}
+
+int64_t DiskStream::PlayOrder::getFramesBeforeWrap(int64_t playFrame) const {
+    return end - getSourceFrame(playFrame);
+}
+
+DiskStream::DiskStream(std::shared_ptr<const StreamedSample> sample_, std::unique_ptr<choc::audio::AudioFileReader> reader_,
+                       int ringFrames, std::shared_ptr<IoThread> ioThread_, std::shared_ptr<Counters> counters_)
+    : sample(std::move(sample_)), reader(std::move(reader_)),
+      ring(static_cast<choc::buffer::ChannelCount>(sample->getNumChannels()), static_cast<choc::buffer::FrameCount>(ringFrames)),
+      ioThread(std::move(ioThread_)), counters(std::move(counters_))
+{
+}
+
+void DiskStream::restart(int64_t startFrame, int64_t endFrame, bool loop, int64_t wrapFrame) {
+    order.end = std::min(endFrame, sample->getNumFrames());
+    order.start = std::clamp<int64_t>(startFrame, 0, order.end);
+    order.loop = loop && wrapFrame >= 0 && wrapFrame < order.end;
+    order.wrap = order.loop ? wrapFrame : order.end;
+    headFrames = getHeadFrames(order);
+    availableEnd = headFrames;
+
+    auto sequence = requestSequence.load(std::memory_order_relaxed) + 1;
+    requestSequence.store(sequence, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    requestStart.store(order.start, std::memory_order_relaxed);
+    requestEnd.store(order.end, std::memory_order_relaxed);
+    requestWrap.store(order.wrap, std::memory_order_relaxed);
+    requestLoop.store(order.loop, std::memory_order_relaxed);
+    consumedFrames.store(0, std::memory_order_relaxed);
+    requestSequence.store(sequence + 1, std::memory_order_release);
+    generation = static_cast<uint32_t>(generationOf(sequence + 1));
+
+    // Only the first wake-up needs the semaphore; the thread clears the flag before each pass
+    if (!ioThread->wakePending.exchange(true, std::memory_order_acq_rel)) {
+        ioThread->wakeup.release();
+    }
+}
+
+void DiskStream::beginBlock() {
+    auto current = filled.load(std::memory_order_acquire);
+    if ((current >> generationShift) == generation) {
+        availableEnd = std::max(headFrames, static_cast<int64_t>(current & filledFramesMask));
+    }
+}
+
+bool DiskStream::isAvailable(int64_t playFrame) const {
+    return std::clamp<int64_t>(playFrame, 0, std::max<int64_t>(0, order.getLength() - 1)) < availableEnd;
+}
+
+float DiskStream::getFrame(int channel, int64_t playFrame) const {
+    auto frame = std::clamp<int64_t>(playFrame, 0, std::max<int64_t>(0, order.getLength() - 1));
+    if (frame < headFrames) {
+        return sample->getHead().getSample(channel, static_cast<int>(order.start + frame));
+    }
+    return ring.getSample(static_cast<choc::buffer::ChannelCount>(channel),
+                          static_cast<choc::buffer::FrameCount>(frame % ring.getNumFrames()));
+}
+
+void DiskStream::endBlock(double playPosition, double rate, int missingFrames) {
+    // Interpolation reads one frame behind the position, so keep that one
+    consumedFrames.store(std::max<int64_t>(0, static_cast<int64_t>(playPosition) - 1), std::memory_order_release);
+    playbackRate.store(rate, std::memory_order_relaxed);
+
+    if (missingFrames > 0) {
+        underrunFrames.fetch_add(static_cast<uint64_t>(missingFrames), std::memory_order_relaxed);
+        counters->underrunFrames.fetch_add(static_cast<uint64_t>(missingFrames), std::memory_order_relaxed);
+        counters->underrunBlocks.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool DiskStream::isFilledAhead(int64_t frames) const {
+    PlayOrder request;
+    uint32_t sequence = 0;
+    if (!readRequest(request, sequence)) {
+        return false;
+    }
+
+    auto consumed = consumedFrames.load(std::memory_order_acquire);
+    auto needed = std::min(consumed + frames, request.getLength());
+    return std::max(getFilledEnd(sequence, request), getHeadFrames(request)) >= needed;
+}
+
+bool DiskStream::readRequest(PlayOrder& request, uint32_t& sequence) const {
+    sequence = requestSequence.load(std::memory_order_acquire);
+    if (sequence & 1) {
+        return false;
+    }
+
+    request.start = requestStart.load(std::memory_order_relaxed);
+    request.end = requestEnd.load(std::memory_order_relaxed);
+    request.wrap = requestWrap.load(std::memory_order_relaxed);
+    request.loop = requestLoop.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return requestSequence.load(std::memory_order_relaxed) == sequence;
+}
+
+int64_t DiskStream::getFilledEnd(uint32_t sequence, const PlayOrder& request) const {
+    auto current = filled.load(std::memory_order_relaxed);
+    if ((current >> generationShift) != generationOf(sequence)) {
+        return getHeadFrames(request);
+    }
+    return static_cast<int64_t>(current & filledFramesMask);
+}
+
+int64_t DiskStream::getHeadFrames(const PlayOrder& request) const {
+    return std::max<int64_t>(0, std::min(sample->getNumHeadFrames(), request.end) - request.start);
+}
+
+double DiskStream::getFramesUntilEmpty(int minimumRead) const {
+    PlayOrder request;
+    uint32_t sequence = 0;
+    if (!readRequest(request, sequence)) {
+        return 0.0; // Restarting right now: look again straight away
+    }
+
+    auto consumed = consumedFrames.load(std::memory_order_acquire);
+    auto filledEnd = std::max(getFilledEnd(sequence, request), consumed);
+    auto limit = std::min(consumed + static_cast<int64_t>(ring.getNumFrames()), request.getLength());
+    if (filledEnd >= limit || (limit - filledEnd < minimumRead && limit != request.getLength())) {
+        return -1.0;
+    }
+
+    return static_cast<double>(filledEnd - consumed) / std::max(playbackRate.load(std::memory_order_relaxed), 1.0e-3);
+}
+
+void DiskStream::fill(int maxFrames) {
+    PlayOrder request;
+    uint32_t sequence = 0;
+    if (!readRequest(request, sequence)) {
+        return;
+    }
+
+    auto ringSize = static_cast<int64_t>(ring.getNumFrames());
+    auto rate = playbackRate.load(std::memory_order_relaxed);
+    auto chunk = static_cast<int64_t>(maxFrames) * static_cast<int64_t>(std::max(1.0, std::ceil(rate)));
+
+    // Frames before consumedFrames are never read again, so after an under-run skip straight
+    // to where the audio thread is instead of catching up on what it has already passed
+    auto consumed = consumedFrames.load(std::memory_order_acquire);
+    auto from = std::max(getFilledEnd(sequence, request), consumed);
+    auto to = std::min({ consumed + ringSize, request.getLength(), from + chunk });
+
+    for (auto frame = from; frame < to;) {
+        auto slot = frame % ringSize;
+        auto run = std::min({ to - frame, ringSize - slot, request.getFramesBeforeWrap(frame) });
+        readSourceFrames(request.getSourceFrame(frame),
+                         ring.getView().getFrameRange({ static_cast<choc::buffer::FrameCount>(slot),
+                                                        static_cast<choc::buffer::FrameCount>(slot + run) }));
+        frame += run;
+    }
+
+    // If the audio thread restarted meanwhile, this is tagged with the old generation and ignored
+    if (to > from) {
+        filled.store((generationOf(sequence) << generationShift) | static_cast<uint64_t>(to), std::memory_order_release);
+    }
+}
+
+void DiskStream::readSourceFrames(int64_t sourceFrame, choc::buffer::ChannelArrayView<float> destination) {
+    auto numFrames = static_cast<int64_t>(destination.getNumFrames());
+
+    // Loops that wrap back into the head don't need the disk
+    if (sourceFrame + numFrames <= sample->getNumHeadFrames()) {
+        const auto& head = sample->getHead();
+        for (choc::buffer::ChannelCount ch = 0; ch < destination.getNumChannels(); ++ch) {
+            for (choc::buffer::FrameCount frame = 0; frame < destination.getNumFrames(); ++frame) {
+                destination.getSample(ch, frame) = head.getSample(static_cast<int>(ch), static_cast<int>(sourceFrame + frame));
+            }
+        }
+        return;
+    }
+
+    if (!reader->readFrames(static_cast<uint64_t>(sourceFrame), destination)) {
+        destination.clear();
+        counters->readErrors.fetch_add(1, std::memory_order_relaxed);
+        Logger::error("DiskStreamer: Failed to read {} frames at {} from {}", numFrames, sourceFrame, sample->getFilePath());
+    }
+    counters->framesRead.fetch_add(static_cast<uint64_t>(numFrames), std::memory_order_relaxed);
+}
+
+DiskStreamer::DiskStreamer() : DiskStreamer(Settings {}) {}
+
+DiskStreamer::DiskStreamer(const Settings& newSettings)
+    : settings(newSettings), counters(std::make_shared<DiskStream::Counters>())
+{
+    settings.numThreads = std::max(1, settings.numThreads);
+    settings.headFrames = std::max(0, settings.headFrames);
+    settings.ringFrames = std::max(1024, settings.ringFrames);
+    settings.readChunkFrames = std::clamp(settings.readChunkFrames, 1, settings.ringFrames);
+    settings.pollIntervalMs = std::max(1, settings.pollIntervalMs);
+
+    for (int i = 0; i < settings.numThreads; ++i) {
+        auto state = std::make_shared<DiskStream::IoThread>();
+        ioThreadStates.push_back(state);
+        ioThreads.emplace_back([this, state] { ioThreadFunction(*state); });
+    }
+
+    Logger::info("DiskStreamer: {} I/O threads, {} head frames per file, {} ring frames per stream",
+                 settings.numThreads, settings.headFrames, settings.ringFrames);
+}
+
+DiskStreamer::~DiskStreamer() {
+    shouldStop.store(true);
+    for (auto& state : ioThreadStates) {
+        state->wakeup.release();
+    }
+    for (auto& thread : ioThreads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+std::shared_ptr<const StreamedSample> DiskStreamer::openSample(const std::string& filePath) const {
+    try {
+        choc::audio::WAVAudioFileFormat<false> wavFormat;
+        auto reader = wavFormat.createReader(filePath);
+        if (!reader) {
+            Logger::error("DiskStreamer: Failed to create reader for file: {}", filePath);
+            return nullptr;
+        }
+
+        const auto& properties = reader->getProperties();
+        if (properties.numFrames == 0 || properties.numChannels == 0) {
+            Logger::error("DiskStreamer: No audio data in file: {}", filePath);
+            return nullptr;
+        }
+
+        auto headLength = static_cast<choc::buffer::FrameCount>(
+            std::min<uint64_t>(properties.numFrames, static_cast<uint64_t>(settings.headFrames)));
+        choc::buffer::ChannelArrayBuffer<float> head(properties.numChannels, headLength);
+        if (headLength > 0 && !reader->readFrames(0, head.getView())) {
+            Logger::error("DiskStreamer: Failed to read the start of file: {}", filePath);
+            return nullptr;
+        }
+
+        return std::make_shared<const StreamedSample>(filePath, static_cast<int>(properties.numChannels),
+                                                      static_cast<int64_t>(properties.numFrames), properties.sampleRate,
+                                                      std::make_shared<const SampleData>(std::move(head), properties.sampleRate, filePath));
+    } catch (const std::exception& e) {
+        Logger::error("DiskStreamer: Exception opening file '{}': {}", filePath, e.what());
+        return nullptr;
+    }
+}
+
+std::shared_ptr<DiskStream> DiskStreamer::createStream(std::shared_ptr<const StreamedSample> sample) {
+    if (!sample) {
+        return nullptr;
+    }
+
+    std::unique_ptr<choc::audio::AudioFileReader> reader;
+    try {
+        choc::audio::WAVAudioFileFormat<false> wavFormat;
+        reader = wavFormat.createReader(sample->getFilePath());
+    } catch (const std::exception& e) {
+        Logger::error("DiskStreamer: Exception reopening file '{}': {}", sample->getFilePath(), e.what());
+    }
+    if (!reader) {
+        Logger::error("DiskStreamer: Failed to reopen file for streaming: {}", sample->getFilePath());
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(streamsMutex);
+    auto& ioThread = ioThreadStates[nextIoThread++ % ioThreadStates.size()];
+    std::shared_ptr<DiskStream> stream(new DiskStream(std::move(sample), std::move(reader), settings.ringFrames, ioThread, counters));
+    ioThread->streams.push_back(stream);
+    return stream;
+}
+
+DiskStreamStats DiskStreamer::getStats() const {
+    DiskStreamStats stats;
+    stats.underrunFrames = counters->underrunFrames.load(std::memory_order_relaxed);
+    stats.underrunBlocks = counters->underrunBlocks.load(std::memory_order_relaxed);
+    stats.framesRead = counters->framesRead.load(std::memory_order_relaxed);
+    stats.readErrors = counters->readErrors.load(std::memory_order_relaxed);
+    return stats;
+}
+
+size_t DiskStreamer::getNumStreams() const {
+    std::lock_guard<std::mutex> lock(streamsMutex);
+    size_t count = 0;
+    for (const auto& state : ioThreadStates) {
+        count += static_cast<size_t>(std::count_if(state->streams.begin(), state->streams.end(),
+                                                   [](const auto& stream) { return !stream.expired(); }));
+    }
+    return count;
+}
+
+void DiskStreamer::ioThreadFunction(DiskStream::IoThread& state) {
+    if (ThreadScheduling::isRequested(settings.ioThreadScheduling)) {
+        auto result = ThreadScheduling::applyToCurrentThread(settings.ioThreadScheduling);
+        if (!result.succeeded()) {
+            Logger::warn("DiskStreamer I/O thread: scheduling {}, affinity {}",
+                         ThreadScheduling::toString(result.scheduling), ThreadScheduling::toString(result.affinity));
+        }
+    }
+
+    // Anything smaller isn't worth a read yet; the stream still has most of its ring to play
+    const int minimumRead = std::max(1, settings.readChunkFrames / 4);
+
+    std::vector<std::shared_ptr<DiskStream>> streams;
+    std::vector<std::pair<double, DiskStream*>> due;
+
+    while (!shouldStop.load()) {
+        state.wakePending.store(false, std::memory_order_release);
+
+        {
+            std::lock_guard<std::mutex> lock(streamsMutex);
+            auto& registered = state.streams;
+            registered.erase(std::remove_if(registered.begin(), registered.end(),
+                                            [](const auto& stream) { return stream.expired(); }),
+                             registered.end());
+            for (const auto& weakStream : registered) {
+                if (auto stream = weakStream.lock()) {
+                    streams.push_back(std::move(stream));
+                }
+            }
+        }
+
+        // One chunk per stream per round, closest to running dry first, until every ring is topped up
+        while (!shouldStop.load()) {
+            due.clear();
+            for (const auto& stream : streams) {
+                auto framesUntilEmpty = stream->getFramesUntilEmpty(minimumRead);
+                if (framesUntilEmpty >= 0.0) {
+                    due.emplace_back(framesUntilEmpty, stream.get());
+                }
+            }
+            if (due.empty()) {
+                break;
+            }
+
+            std::sort(due.begin(), due.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+            for (const auto& [framesUntilEmpty, stream] : due) {
+                stream->fill(settings.readChunkFrames);
+            }
+        }
+
+        // Streams their voices have let go of are destroyed here, never on the audio thread
+        streams.clear();
+
+        (void) state.wakeup.try_acquire_for(std::chrono::milliseconds(settings.pollIntervalMs));
+    }
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "SampleData.h"
+#include "ThreadScheduling.h"
+#include "../../lib/choc/audio/choc_AudioFileFormat.h"
+#include "../../lib/choc/audio/choc_SampleBuffers.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <semaphore>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Disk streaming for sample libraries too large to hold in memory. Only the head of each
+// file is decoded up front (StreamedSample); every voice playing it owns a DiskStream, a
+// ring buffer that a pool of I/O threads keeps ahead of the playhead. The audio thread
+// only reads the ring and publishes how far it has got, so it never waits on the disk:
+// frames that haven't arrived in time play as silence and are counted as under-runs.
+
+// The part of a streamed file that stays in memory: its properties and the first frames,
+// which cover the disk's latency after a voice starts
+class StreamedSample {
+public:
+    StreamedSample(std::string filePath, int numChannels, int64_t numFrames, double sampleRate,
+                   std::shared_ptr<const SampleData> head);
+
+    const std::string& getFilePath() const { return filePath; }
+    int getNumChannels() const { return numChannels; }
+    int64_t getNumFrames() const { return numFrames; }
+    double getSampleRate() const { return sampleRate; }
+
+    const SampleData& getHead() const { return *head; }
+    int64_t getNumHeadFrames() const { return head->getNumFrames(); }
+
+private:
+    std::string filePath;
+    int numChannels;
+    int64_t numFrames;
+    double sampleRate;
+    std::shared_ptr<const SampleData> head;
+};
+
+// Totals across a streamer's streams
+struct DiskStreamStats {
+    uint64_t underrunFrames = 0;   // Frames played as silence because the disk fell behind
+    uint64_t underrunBlocks = 0;   // Audio blocks with at least one such frame
+    uint64_t framesRead = 0;       // Frames read from disk (not counting the heads)
+    uint64_t readErrors = 0;
+};
+
+// One voice's view of a streamed file. Playback is addressed in play order: frame 0 is the
+// region start passed to restart(), and a looping region continues past its end at the
+// wrap point, so the ring always holds the frames in the order they'll be played.
+class DiskStream {
+public:
+    // Audio thread. Starts playing from startFrame; looping regions wrap from endFrame back
+    // to wrapFrame. Discards whatever the ring holds, so only the head is ready straight away.
+    void restart(int64_t startFrame, int64_t endFrame, bool loop, int64_t wrapFrame);
+
+    // Audio thread, once per block: picks up what the I/O thread has delivered since the last block
+    void beginBlock();
+
+    // Audio thread, between beginBlock and endBlock. Frames past the end of a non-looping
+    // region read as the last frame; isAvailable is false if the disk hasn't caught up.
+    bool isAvailable(int64_t playFrame) const;
+    float getFrame(int channel, int64_t playFrame) const;
+
+    // Audio thread: reports the play position reached and the rate it's moving at (which
+    // drives the prefetch), plus any frames that weren't available this block
+    void endBlock(double playPosition, double rate, int missingFrames);
+
+    // Any thread: whether the frames up to `frames` past the position reported at the last
+    // endBlock (or to the end of the region) have been read, for the current restart
+    bool isFilledAhead(int64_t frames) const;
+
+    const std::shared_ptr<const StreamedSample>& getSample() const { return sample; }
+    uint64_t getUnderrunFrames() const { return underrunFrames.load(std::memory_order_relaxed); }
+
+private:
+    friend class DiskStreamer;
+
+    struct IoThread;
+    struct Counters;
+
+    struct PlayOrder {
+        int64_t start = 0;
+        int64_t end = 0;
+        int64_t wrap = 0;
+        bool loop = false;
+
+        int64_t getLength() const { return loop ? INT64_MAX : end - start; }
+        int64_t getSourceFrame(int64_t playFrame) const;
+        int64_t getFramesBeforeWrap(int64_t playFrame) const;
+    };
+
+    DiskStream(std::shared_ptr<const StreamedSample> sample, std::unique_ptr<choc::audio::AudioFileReader> reader,
+               int ringFrames, std::shared_ptr<IoThread> ioThread, std::shared_ptr<Counters> counters);
+
+    // I/O thread. Output frames (at the current rate) until the audio thread reaches the end
+    // of what's been read, or a negative value if there's less than minimumRead frames of
+    // space to fill (and the region doesn't end sooner).
+    double getFramesUntilEmpty(int minimumRead) const;
+
+    // I/O thread: reads up to maxFrames (scaled by the playback rate) into the ring
+    void fill(int maxFrames);
+
+    bool readRequest(PlayOrder& request, uint32_t& sequence) const;
+    int64_t getFilledEnd(uint32_t sequence, const PlayOrder& request) const;
+    int64_t getHeadFrames(const PlayOrder& request) const;
+    void readSourceFrames(int64_t sourceFrame, choc::buffer::ChannelArrayView<float> destination);
+
+    std::shared_ptr<const StreamedSample> sample;
+    std::unique_ptr<choc::audio::AudioFileReader> reader;
+    choc::buffer::ChannelArrayBuffer<float> ring;
+    std::shared_ptr<IoThread> ioThread;
+    std::shared_ptr<Counters> counters;
+
+    // Written by the audio thread. The region is published seqlock-style: the sequence is
+    // odd while it's being written, and the generation (sequence / 2) tags the ring contents.
+    std::atomic<uint32_t> requestSequence { 0 };
+    std::atomic<int64_t> requestStart { 0 };
+    std::atomic<int64_t> requestEnd { 0 };
+    std::atomic<int64_t> requestWrap { 0 };
+    std::atomic<bool> requestLoop { false };
+    std::atomic<int64_t> consumedFrames { 0 };  // Play frames before this won't be read again
+    std::atomic<double> playbackRate { 1.0 };
+
+    // Written by the I/O thread: generation in the top 16 bits, play frames filled below
+    std::atomic<uint64_t> filled { 0 };
+    static constexpr int generationShift = 48;
+    static constexpr uint64_t filledFramesMask = (uint64_t(1) << generationShift) - 1;
+
+    // Audio thread only
+    PlayOrder order;
+    uint32_t generation = 0;
+    int64_t headFrames = 0;
+    int64_t availableEnd = 0;
+
+    std::atomic<uint64_t> underrunFrames { 0 };
+};
+
+// Owns the I/O threads and opens files for streaming. Streams are spread over the threads
+// and each pass a thread services its streams closest to running dry first, so prefetch
+// follows both where each voice is and how fast it's playing.
+class DiskStreamer {
+public:
+    struct Settings {
+        int numThreads = 2;
+        int headFrames = 65536;        // Preloaded per file
+        int ringFrames = 65536;        // Per stream; must exceed the largest block times the highest playback rate
+        int readChunkFrames = 8192;    // Largest read per service at rate 1.0 (scaled up for faster voices)
+        int pollIntervalMs = 2;        // How often idle I/O threads check their streams
+        ThreadScheduling::Settings ioThreadScheduling;
+    };
+
+    DiskStreamer();
+    explicit DiskStreamer(const Settings& settings);
+    ~DiskStreamer();
+
+    DiskStreamer(const DiskStreamer&) = delete;
+    DiskStreamer& operator=(const DiskStreamer&) = delete;
+
+    // Reads a WAV file's properties and head. nullptr if it can't be opened or is empty.
+    std::shared_ptr<const StreamedSample> openSample(const std::string& filePath) const;
+
+    // A voice's stream of an opened sample, with its own file handle and ring buffer.
+    // Not for the audio thread. nullptr if the file can't be reopened.
+    std::shared_ptr<DiskStream> createStream(std::shared_ptr<const StreamedSample> sample);
+
+    const Settings& getSettings() const { return settings; }
+    DiskStreamStats getStats() const;
+    size_t getNumStreams() const;
+
+private:
+    void ioThreadFunction(DiskStream::IoThread& state);
+
+    Settings settings;
+    std::shared_ptr<DiskStream::Counters> counters;
+    std::vector<std::shared_ptr<DiskStream::IoThread>> ioThreadStates;
+    std::vector<std::thread> ioThreads;
+    size_t nextIoThread = 0;
+
+    mutable std::mutex streamsMutex;
+    std::atomic<bool> shouldStop { false };
+};
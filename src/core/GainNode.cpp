@@ -9,6 +9,12 @@ GainNode::GainNode(float initialGain, const std::string& name)
     Logger::debug("GainNode '{}' created with initial gain: {}", name, initialGain);
 }
 
+void GainNode::prepare(const PrepareInfo& info) {
+    AudioNode::prepare(info);
+    // Set before audio starts so the per-block update in processCallback has nothing to do
+    gainParameter->setSampleRate(info.sampleRate);
+}
+
 void GainNode::processCallback(
     choc::buffer::ChannelArrayView<const float> inputBuffers,
     choc::buffer::ChannelArrayView<float> outputBuffers,
@@ -22,23 +28,23 @@ void GainNode::processCallback(
     auto numInputChannels = inputBuffers.getNumChannels();
     auto numSamples = outputBuffers.getNumFrames();
     
-    // Process each output channel
-    for (choc::buffer::ChannelCount outCh = 0; outCh < numOutputChannels; ++outCh) {
-        if (outCh < numInputChannels) {
-            // Apply gain with per-sample smoothing
-            for (choc::buffer::FrameCount sample = 0; sample < numSamples; ++sample) {
-                float currentGain = gainParameter->getNextValue();
-                outputBuffers.getSample(outCh, sample) = inputBuffers.getSample(outCh, sample) * currentGain;
-            }
-        } else {
-            // No input for this channel, but still advance the parameter
-            for (choc::buffer::FrameCount sample = 0; sample < numSamples; ++sample) {
-                gainParameter->getNextValue();
-            }
-            // Clear output for this channel
-            for (choc::buffer::FrameCount sample = 0; sample < numSamples; ++sample) {
-                outputBuffers.getSample(outCh, sample) = 0.0f;
-            }
+    // Smooth the gain once per frame and apply it to every channel; outputs with no
+    // matching input are silent
+    for (choc::buffer::FrameCount sample = 0; sample < numSamples; ++sample) {
+        float currentGain = gainParameter->getNextValue();
+        for (choc::buffer::ChannelCount outCh = 0; outCh < numOutputChannels; ++outCh) {
+            outputBuffers.getSample(outCh, sample) = outCh < numInputChannels
+                ? inputBuffers.getSample(outCh, sample) * currentGain
+                : 0.0f;
         }
     }
+    
+    // Fully muted (and not ramping) means nothing downstream needs to run
+    setOutputSilent(gainParameter->getCurrentValue() == 0.0f && gainParameter->getTargetValue() == 0.0f);
+}
+
+std::shared_ptr<AudioNode> GainNode::clone() const {
+    auto copy = std::make_shared<GainNode>(getTargetGain(), getName());
+    copyNodeSettingsTo(*copy);
+    return copy;
 }
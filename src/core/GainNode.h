@@ -8,6 +8,8 @@ class GainNode : public AudioNode {
 public:
     GainNode(float initialGain = 1.0f, const std::string& name = "GainNode");
     
+    void prepare(const PrepareInfo& info) override;
+    
     void processCallback(
         choc::buffer::ChannelArrayView<const float> inputBuffers,
         choc::buffer::ChannelArrayView<float> outputBuffers,
@@ -15,6 +17,15 @@ public:
         int blockSize
     ) override;
     
+    // Each output sample only depends on the input sample at the same position
+    bool supportsInPlaceProcessing() const override { return true; }
+    
+    // Stateless apart from the gain ramp, so it can sleep as soon as its input is silent
+    // unless a ramp has to keep time
+    int getTailSamples() const override { return gainParameter->isRamping() ? neverSleeps : 0; }
+    
+    std::shared_ptr<AudioNode> clone() const override;
+    
     // Parameter access methods
     void setGain(float newGain) { gainParameter->setValue(newGain); }
     void setGainSmooth(float newGain, float rampTimeMs) { gainParameter->setValue(newGain, rampTimeMs); }
@@ -60,7 +60,10 @@ void MidiEngine::scanDevices() {
     // Clear existing devices
     inputDevices.clear();
     outputDevices.clear();
-    callbackData.clear();
+    {
+        std::lock_guard<std::mutex> lock(callbackDataMutex);
+        callbackData.clear();
+    }
     
     try {
         // Scan input devices
@@ -142,6 +145,10 @@ bool MidiEngine::enableInputDevice(unsigned int deviceIndex) {
         
         // Create callback data
         auto callbackDataPtr = std::make_unique<MidiInputCallbackData>(this, device->name, device->index);
+        {
+            SpinLockGuard lock(schedulingLock);
+            callbackDataPtr->schedulingPending.store(ThreadScheduling::isRequested(*inputThreadScheduling));
+        }
         
         // Set up callback
         device->rtMidiIn->setCallback(&MidiEngine::rtMidiInputCallback, callbackDataPtr.get());
@@ -153,7 +160,10 @@ bool MidiEngine::enableInputDevice(unsigned int deviceIndex) {
         device->rtMidiIn->ignoreTypes(false, false, false);
         
         device->enabled = true;
-        callbackData.push_back(std::move(callbackDataPtr));
+        {
+            std::lock_guard<std::mutex> lock(callbackDataMutex);
+            callbackData.push_back(std::move(callbackDataPtr));
+        }
         
         Logger::info("Enabled MIDI input device '", device->name, "'");
         return true;
@@ -202,12 +212,15 @@ bool MidiEngine::disableInputDevice(unsigned int deviceIndex) {
         device->enabled = false;
         
         // Remove callback data
-        callbackData.erase(
-            std::remove_if(callbackData.begin(), callbackData.end(),
-                [deviceIndex](const std::unique_ptr<MidiInputCallbackData>& data) {
-                    return data->deviceIndex == deviceIndex;
-                }),
-            callbackData.end());
+        {
+            std::lock_guard<std::mutex> lock(callbackDataMutex);
+            callbackData.erase(
+                std::remove_if(callbackData.begin(), callbackData.end(),
+                    [deviceIndex](const std::unique_ptr<MidiInputCallbackData>& data) {
+                        return data->deviceIndex == deviceIndex;
+                    }),
+                callbackData.end());
+        }
         
         Logger::info("Disabled MIDI input device '", device->name, "'");
         return true;
@@ -499,6 +512,57 @@ MidiEngine::OutputDevice* MidiEngine::findOutputDevice(const std::string& device
     return (it != outputDevices.end()) ? it->get() : nullptr;
 }
 
+void MidiEngine::setInputThreadScheduling(const ThreadScheduling::Settings& settings) {
+    // Allocated, and the previous settings freed, outside the lock the input threads take
+    std::shared_ptr<const ThreadScheduling::Settings> updated = std::make_shared<const ThreadScheduling::Settings>(settings);
+    {
+        SpinLockGuard lock(schedulingLock);
+        std::swap(inputThreadScheduling, updated);
+    }
+    
+    std::lock_guard<std::mutex> lock(callbackDataMutex);
+    for (auto& data : callbackData) {
+        data->schedulingPending.store(true);
+    }
+}
+
+std::vector<std::pair<std::string, ThreadScheduling::Result>> MidiEngine::getInputThreadSchedulingResults() const {
+    // The list is only changed under callbackDataMutex; the spin lock is held just long
+    // enough to read each result, so an input thread never waits on this allocation
+    std::lock_guard<std::mutex> listLock(callbackDataMutex);
+    std::vector<std::pair<std::string, ThreadScheduling::Result>> results;
+    results.reserve(callbackData.size());
+    for (const auto& data : callbackData) {
+        ThreadScheduling::Result result;
+        {
+            SpinLockGuard lock(schedulingLock);
+            result = data->schedulingResult;
+        }
+        results.emplace_back(data->deviceName, result);
+    }
+    return results;
+}
+
+void MidiEngine::applyInputThreadScheduling(MidiInputCallbackData& data) {
+    std::shared_ptr<const ThreadScheduling::Settings> settings;
+    {
+        SpinLockGuard lock(schedulingLock);
+        settings = inputThreadScheduling;
+    }
+    
+    // The system calls run outside the lock
+    auto result = ThreadScheduling::applyToCurrentThread(*settings);
+    {
+        SpinLockGuard lock(schedulingLock);
+        data.schedulingResult = result;
+    }
+    
+    if (!result.succeeded()) {
+        Logger::warn("MIDI input thread for '{}': scheduling {}, affinity {}", data.deviceName,
+                     ThreadScheduling::toString(result.scheduling), ThreadScheduling::toString(result.affinity));
+    }
+}
+
 void MidiEngine::rtMidiInputCallback(double timeStamp, std::vector<unsigned char>* message, void* userData) {
     if (!message || !userData) {
         return;
@@ -509,6 +573,10 @@ void MidiEngine::rtMidiInputCallback(double timeStamp, std::vector<unsigned char
         return;
     }
     
+    if (callbackData->schedulingPending.exchange(false)) {
+        callbackData->engine->applyInputThreadScheduling(*callbackData);
+    }
+    
     callbackData->engine->handleMidiInput(timeStamp, *message, 
                                         callbackData->deviceName, 
                                         callbackData->deviceIndex);
@@ -4,6 +4,7 @@
 #include "audio/choc_MIDI.h"
 #include "threading/choc_SpinLock.h"
 #include "Logger.h"
+#include "ThreadScheduling.h"
 #include <memory>
 #include <vector>
 #include <string>
@@ -60,6 +61,8 @@ public:
         MidiEngine* engine;
         std::string deviceName;
         unsigned int deviceIndex;
+        std::atomic<bool> schedulingPending{false};  // Apply the input thread scheduling on the next message
+        ThreadScheduling::Result schedulingResult;   // Guarded by schedulingLock
         
         MidiInputCallbackData(MidiEngine* eng, const std::string& name, unsigned int index)
             : engine(eng), deviceName(name), deviceIndex(index) {}
@@ -215,6 +218,20 @@ public:
      */
     bool broadcastMidiMessage(const choc::midi::ShortMessage& message);
 
+    // ===== THREAD SCHEDULING =====
+    
+    /**
+     * Set scheduling for the MIDI input threads. RtMidi owns those threads, so each device's
+     * thread applies the settings itself when its next message arrives.
+     */
+    void setInputThreadScheduling(const ThreadScheduling::Settings& settings);
+    
+    /**
+     * Scheduling result for each enabled input device, by device name
+     * (NotRequested until a message has arrived since the settings were set)
+     */
+    std::vector<std::pair<std::string, ThreadScheduling::Result>> getInputThreadSchedulingResults() const;
+
     // ===== CONTROL SURFACE MANAGEMENT =====
     
     /**
@@ -285,6 +302,11 @@ private:
     void handleMidiInput(double timeStamp, const std::vector<unsigned char>& rawMessage, 
                         const std::string& deviceName, unsigned int deviceIndex);
     
+    /**
+     * Apply inputThreadScheduling to the calling (RtMidi input) thread
+     */
+    void applyInputThreadScheduling(MidiInputCallbackData& data);
+    
     /**
      * Process a MIDI message through the control surface chain
      * @return true if the message was handled by a control surface
@@ -298,7 +320,8 @@ private:
     std::vector<std::unique_ptr<OutputDevice>> outputDevices;
     
     // ===== CALLBACK DATA =====
-    std::vector<std::unique_ptr<MidiInputCallbackData>> callbackData;
+    std::vector<std::unique_ptr<MidiInputCallbackData>> callbackData;  // Guarded by callbackDataMutex
+    mutable std::mutex callbackDataMutex;
     MidiInputCallback userMidiCallback;
     
     // ===== CONTROL SURFACES =====
@@ -308,6 +331,12 @@ private:
     mutable choc::threading::SpinLock deviceListLock;
     mutable choc::threading::SpinLock callbackLock;
     mutable choc::threading::SpinLock controlSurfaceLock;
+    mutable choc::threading::SpinLock schedulingLock;
+    
+    // ===== THREAD SCHEDULING =====
+    // Guarded by schedulingLock. Replaced rather than modified, so the input threads take a
+    // reference under the lock and apply it outside it, without copying the core list.
+    std::shared_ptr<const ThreadScheduling::Settings> inputThreadScheduling = std::make_shared<const ThreadScheduling::Settings>();
     
     // ===== INITIALIZATION STATE =====
     std::atomic<bool> initialized{false};
@@ -0,0 +1,129 @@
+#include "NullAudioBackend.h"
+#include "Logger.h"
+#include "ThreadScheduling.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+NullAudioBackend::~NullAudioBackend() {
+    closeStream();
+}
+
+std::vector<AudioDeviceInfo> NullAudioBackend::getDevices() {
+    return { { 0, "Null Audio Device", maxChannels, maxChannels, 48000.0 } };
+}
+
+bool NullAudioBackend::openStream(const StreamConfig& newConfig, PaStreamCallback* callback, void* userData) {
+    closeStream();
+
+    if (!callback || newConfig.sampleRate <= 0.0 || newConfig.bufferSize <= 0) {
+        Logger::error("Null audio backend: invalid stream configuration");
+        return false;
+    }
+
+    config = newConfig;
+    config.inputChannels = config.inputDevice >= 0 ? std::clamp(config.inputChannels, 0, maxChannels) : 0;
+    config.outputChannels = config.outputDevice >= 0 ? std::clamp(config.outputChannels, 0, maxChannels) : 0;
+
+    inputSamples.assign(static_cast<size_t>(config.inputChannels) * config.bufferSize, 0.0f);
+    outputSamples.assign(static_cast<size_t>(config.outputChannels) * config.bufferSize, 0.0f);
+
+    inputChannelPtrs.clear();
+    for (int ch = 0; ch < config.inputChannels; ++ch) {
+        inputChannelPtrs.push_back(inputSamples.data() + static_cast<size_t>(ch) * config.bufferSize);
+    }
+    outputChannelPtrs.clear();
+    for (int ch = 0; ch < config.outputChannels; ++ch) {
+        outputChannelPtrs.push_back(outputSamples.data() + static_cast<size_t>(ch) * config.bufferSize);
+    }
+
+    streamCallback = callback;
+    streamUserData = userData;
+    return true;
+}
+
+bool NullAudioBackend::startStream() {
+    if (!streamCallback || active.load()) {
+        return false;
+    }
+
+    shouldStop.store(false);
+    active.store(true);
+    timerThread = std::thread(&NullAudioBackend::timerThreadFunction, this);
+    return true;
+}
+
+void NullAudioBackend::closeStream() {
+    shouldStop.store(true);
+    if (timerThread.joinable()) {
+        timerThread.join();
+    }
+    active.store(false);
+    streamCallback = nullptr;
+}
+
+void NullAudioBackend::timerThreadFunction() {
+    // Best-effort, like a driver's callback thread: real-time scheduling usually needs
+    // privileges the test machine may not grant
+    ThreadScheduling::Settings timerScheduling;
+    timerScheduling.policy = ThreadScheduling::Policy::Fifo;
+    timerScheduling.priority = timerThreadPriority;
+    if (ThreadScheduling::applyToCurrentThread(timerScheduling).scheduling != ThreadScheduling::Outcome::Applied) {
+        Logger::debug("Null audio backend: no real-time priority for the timer thread");
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const double periodSeconds = config.bufferSize / config.sampleRate;
+    const auto start = Clock::now();
+
+    // Deadlines come from the period count, not by adding periods up, so they don't drift
+    auto deadlineFor = [&](uint64_t period) {
+        return start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(periodSeconds * period));
+    };
+    auto secondsSinceStart = [&](Clock::time_point time) {
+        return std::chrono::duration<double>(time - start).count();
+    };
+
+    const void* input = nullptr;
+    void* output = nullptr;
+    if (config.nonInterleaved) {
+        input = config.inputChannels > 0 ? static_cast<const void*>(inputChannelPtrs.data()) : nullptr;
+        output = config.outputChannels > 0 ? static_cast<void*>(outputChannelPtrs.data()) : nullptr;
+    } else {
+        input = config.inputChannels > 0 ? static_cast<const void*>(inputSamples.data()) : nullptr;
+        output = config.outputChannels > 0 ? static_cast<void*>(outputSamples.data()) : nullptr;
+    }
+
+    uint64_t period = 0;
+    PaStreamCallbackFlags flags = 0;
+
+    while (!shouldStop.load()) {
+        // This buffer reaches the (imaginary) DAC one period after its deadline
+        PaStreamCallbackTimeInfo timeInfo {};
+        timeInfo.currentTime = secondsSinceStart(Clock::now());
+        timeInfo.inputBufferAdcTime = secondsSinceStart(deadlineFor(period));
+        timeInfo.outputBufferDacTime = secondsSinceStart(deadlineFor(period + 1));
+
+        int result = streamCallback(input, output, static_cast<unsigned long>(config.bufferSize),
+                                    &timeInfo, flags, streamUserData);
+        callbackCount.fetch_add(1);
+        flags = 0;
+
+        if (result != paContinue) {
+            break;
+        }
+
+        ++period;
+        auto now = Clock::now();
+        if (now > deadlineFor(period)) {
+            // Finished after the device would have needed the buffer: report an underflow
+            // (and the input that would have been lost), then skip ahead instead of bursting
+            flags = paOutputUnderflow | (config.inputChannels > 0 ? paInputOverflow : 0);
+            period = static_cast<uint64_t>(std::ceil(secondsSinceStart(now) / periodSeconds));
+        }
+
+        std::this_thread::sleep_until(deadlineFor(period));
+    }
+
+    active.store(false);
+}
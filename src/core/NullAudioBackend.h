@@ -0,0 +1,51 @@
+#pragma once
+
+#include "AudioDeviceBackend.h"
+#include <atomic>
+#include <thread>
+
+// Headless backend for machines without a sound card: a timer thread runs the callback
+// once per buffer period at the requested size and rate, feeding silent input and
+// discarding the output. A callback that overruns its period is reported the way a real
+// device would report it, as an output underflow on the next callback.
+class NullAudioBackend : public AudioDeviceBackend {
+public:
+    static constexpr int maxChannels = 32;
+
+    ~NullAudioBackend() override;
+
+    std::string getName() const override { return "Null"; }
+    bool initialize() override { return true; }
+
+    std::vector<AudioDeviceInfo> getDevices() override;
+    int getDefaultInputDevice() const override { return 0; }
+    int getDefaultOutputDevice() const override { return 0; }
+
+    bool openStream(const StreamConfig& config, PaStreamCallback* callback, void* userData) override;
+    bool startStream() override;
+    void closeStream() override;
+    bool isStreamOpen() const override { return streamCallback != nullptr; }
+    bool isStreamActive() const override { return active.load(); }
+    bool isStreamNonInterleaved() const override { return config.nonInterleaved; }
+
+    uint64_t getCallbackCount() const { return callbackCount.load(); }
+
+private:
+    static constexpr int timerThreadPriority = 98;  // Clamped to the OS maximum
+
+    StreamConfig config;
+    PaStreamCallback* streamCallback = nullptr;
+    void* streamUserData = nullptr;
+
+    std::vector<float> inputSamples;
+    std::vector<float> outputSamples;
+    std::vector<const float*> inputChannelPtrs;  // Non-interleaved streams
+    std::vector<float*> outputChannelPtrs;
+
+    std::thread timerThread;
+    std::atomic<bool> shouldStop{false};
+    std::atomic<bool> active{false};
+    std::atomic<uint64_t> callbackCount{0};
+
+    void timerThreadFunction();
+};
@@ -0,0 +1,120 @@
+#include "OfflineWavWriter.h"
+#include "Logger.h"
+#include <algorithm>
+
+OfflineWavWriter::OfflineWavWriter(int numChannels, int maxChunkFrames, int queueDepth) {
+    int numChunks = std::max(queueDepth, 2);
+    chunks.resize(static_cast<size_t>(numChunks));
+    for (int i = 0; i < numChunks; ++i) {
+        chunks[i].buffer.resize({ static_cast<choc::buffer::ChannelCount>(numChannels),
+                                  static_cast<choc::buffer::FrameCount>(std::max(maxChunkFrames, 1)) });
+        freeChunks.push_back(i);
+    }
+}
+
+OfflineWavWriter::~OfflineWavWriter() {
+    finish();
+}
+
+bool OfflineWavWriter::open(const std::string& filePath, double sampleRate) {
+    choc::audio::WAVAudioFileFormat<true> wavFormat; // Set to true to enable writing
+
+    choc::audio::AudioFileProperties fileProps;
+    fileProps.sampleRate = sampleRate;
+    fileProps.numChannels = chunks.front().buffer.getNumChannels();
+    fileProps.bitDepth = choc::audio::BitDepth::float32; // Use 32-bit float
+
+    writer = wavFormat.createWriter(filePath, fileProps);
+    if (!writer) {
+        Logger::error("Failed to create WAV writer for: {}", filePath);
+        return false;
+    }
+
+    writerThread = std::thread(&OfflineWavWriter::writerThreadFunction, this);
+    return true;
+}
+
+choc::buffer::ChannelArrayView<float> OfflineWavWriter::acquireChunk() {
+    // Only the writer thread hands chunks back, so without one the pool would run dry
+    if (!writerThread.joinable()) return {};
+
+    std::unique_lock<std::mutex> lock(mutex);
+    chunkFreed.wait(lock, [this] { return !freeChunks.empty(); });
+
+    currentChunk = freeChunks.front();
+    freeChunks.pop_front();
+    return chunks[currentChunk].buffer.getView();
+}
+
+void OfflineWavWriter::submitChunk(int numFrames) {
+    if (!writerThread.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (currentChunk < 0) return;
+
+        chunks[currentChunk].numFrames = numFrames;
+        filledChunks.push_back(currentChunk);
+        currentChunk = -1;
+    }
+    chunkFilled.notify_one();
+}
+
+bool OfflineWavWriter::hasFailed() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return failed;
+}
+
+bool OfflineWavWriter::finish() {
+    if (writerThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            finishing = true;
+        }
+        chunkFilled.notify_one();
+        writerThread.join();
+    }
+
+    // Closing the writer finalises the WAV header
+    if (writer) {
+        if (!writer->flush()) {
+            failed = true;
+        }
+        writer.reset();
+    }
+
+    return !failed;
+}
+
+void OfflineWavWriter::writerThreadFunction() {
+    while (true) {
+        int chunkIndex;
+        bool skipWrite;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            chunkFilled.wait(lock, [this] { return !filledChunks.empty() || finishing; });
+            if (filledChunks.empty()) {
+                break; // Finishing and fully drained
+            }
+
+            chunkIndex = filledChunks.front();
+            filledChunks.pop_front();
+            skipWrite = failed;
+        }
+
+        // Write without holding the lock so the renderer can keep filling other chunks
+        auto& chunk = chunks[chunkIndex];
+        auto frames = chunk.buffer.getView().getFrameRange({ 0, static_cast<choc::buffer::FrameCount>(chunk.numFrames) });
+        bool written = skipWrite || chunk.numFrames == 0 || writer->appendFrames(frames);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!written && !failed) {
+                Logger::error("Failed to write audio data to file");
+                failed = true;
+            }
+            freeChunks.push_back(chunkIndex);
+        }
+        chunkFreed.notify_one();
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "../../lib/choc/audio/choc_SampleBuffers.h"
+#include "../../lib/choc/audio/choc_AudioFileFormat_WAV.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Writes a 32-bit float WAV file on a background thread. The renderer fills chunks taken
+// from a fixed pool and queues them; when the disk falls behind, acquireChunk blocks, so
+// memory stays at queueDepth chunks however long the render is.
+class OfflineWavWriter {
+public:
+    OfflineWavWriter(int numChannels, int maxChunkFrames, int queueDepth);
+    ~OfflineWavWriter();
+
+    bool open(const std::string& filePath, double sampleRate);
+
+    // Renderer side: fill the returned chunk (maxChunkFrames long), then submit how much of it
+    // to write. Without an open file the chunk is empty and submitting does nothing.
+    choc::buffer::ChannelArrayView<float> acquireChunk();
+    void submitChunk(int numFrames);
+
+    // True once a write has failed; later chunks are dropped without being written
+    bool hasFailed();
+
+    // Write everything queued and close the file. Returns false if any write failed.
+    bool finish();
+
+private:
+    struct Chunk {
+        choc::buffer::ChannelArrayBuffer<float> buffer;
+        int numFrames = 0;
+    };
+
+    std::vector<Chunk> chunks;
+    std::deque<int> freeChunks;
+    std::deque<int> filledChunks;
+    int currentChunk = -1;  // Acquired by the renderer, not yet submitted
+
+    std::mutex mutex;
+    std::condition_variable chunkFreed;
+    std::condition_variable chunkFilled;
+    bool finishing = false;
+    bool failed = false;
+
+    std::unique_ptr<choc::audio::AudioFileWriter> writer;
+    std::thread writerThread;
+
+    void writerThreadFunction();
+};
@@ -10,6 +10,12 @@ OscillatorNode::OscillatorNode(float frequency, WaveType waveType, const std::st
     Logger::debug("OscillatorNode '{}' created with frequency: {}Hz", name, frequency);
 }
 
+void OscillatorNode::prepare(const PrepareInfo& info) {
+    AudioNode::prepare(info);
+    // Set before audio starts so the per-block update in processCallback has nothing to do
+    frequencyParameter->setSampleRate(info.sampleRate);
+}
+
 void OscillatorNode::processCallback(
     choc::buffer::ChannelArrayView<const float> inputBuffers,
     choc::buffer::ChannelArrayView<float> outputBuffers,
@@ -22,11 +28,12 @@ void OscillatorNode::processCallback(
     auto numOutputChannels = outputBuffers.getNumChannels();
     auto numSamples = outputBuffers.getNumFrames();
     
-    // Generate oscillator output for each channel
-    for (choc::buffer::ChannelCount outCh = 0; outCh < numOutputChannels; ++outCh) {
-        for (choc::buffer::FrameCount sample = 0; sample < numSamples; ++sample) {
-            float currentFrequency = frequencyParameter->getNextValue();
-            outputBuffers.getSample(outCh, sample) = generateSample(currentFrequency, static_cast<float>(sampleRate));
+    // One value per frame (smoothing and phase advance once), copied to every channel
+    for (choc::buffer::FrameCount sample = 0; sample < numSamples; ++sample) {
+        float currentFrequency = frequencyParameter->getNextValue();
+        float value = generateSample(currentFrequency, static_cast<float>(sampleRate));
+        for (choc::buffer::ChannelCount outCh = 0; outCh < numOutputChannels; ++outCh) {
+            outputBuffers.getSample(outCh, sample) = value;
         }
     }
 }
@@ -56,3 +63,9 @@ float OscillatorNode::generateSample(float frequency, float sampleRate) {
     
     return output * 0.8f; // Louder output for better audibility
 }
+
+std::shared_ptr<AudioNode> OscillatorNode::clone() const {
+    auto copy = std::make_shared<OscillatorNode>(getTargetFrequency(), waveType, getName());
+    copyNodeSettingsTo(*copy);
+    return copy;
+}
@@ -15,6 +15,8 @@ public:
 
     OscillatorNode(float frequency = 440.0f, WaveType waveType = WaveType::Sine, const std::string& name = "OscillatorNode");
     
+    void prepare(const PrepareInfo& info) override;
+    
     void processCallback(
         choc::buffer::ChannelArrayView<const float> inputBuffers,
         choc::buffer::ChannelArrayView<float> outputBuffers,
@@ -22,6 +24,8 @@ public:
         int blockSize
     ) override;
     
+    std::shared_ptr<AudioNode> clone() const override;
+    
     // Parameter access methods
     void setFrequency(float newFrequency) { frequencyParameter->setValue(newFrequency); }
     void setFrequencySmooth(float newFrequency, float rampTimeMs) { frequencyParameter->setValue(newFrequency, rampTimeMs); }
@@ -43,6 +43,7 @@ void PolyphonicSampler::processCallback(choc::buffer::ChannelArrayView<const flo
     output.clear();
     
     if (!hasSample()) {
+        setOutputSilent(true);
         return;
     }
     
@@ -116,58 +117,27 @@ void PolyphonicSampler::processCallback(choc::buffer::ChannelArrayView<const flo
     
     // Update audio analysis
     updateAnalysis(output);
+    setOutputSilent(activeVoices == 0);
 }
 
 bool PolyphonicSampler::loadSample(const std::string& filePath) {
-    try {
-        choc::audio::WAVAudioFileFormat<false> wavFormat;
-        auto reader = wavFormat.createReader(filePath);
-        
-        if (!reader) {
-            Logger::error("PolyphonicSampler '{}': Failed to create reader for file: {}", 
-                         getName(), filePath);
-            return false;
-        }
-        
-        // Load the entire file
-        auto data = reader->loadFileContent();
-        
-        if (data.frames.getNumFrames() == 0) {
-            Logger::error("PolyphonicSampler '{}': No audio data in file: {}", 
-                         getName(), filePath);
-            return false;
-        }
-        
-        // Store sample data
-        sampleBuffer_ = std::move(data.frames);
-        sampleSampleRate_ = data.sampleRate;
-        loadedFilePath_ = filePath;
-        
-        // Load sample into all voices
-        bool allLoaded = true;
-        for (int i = 0; i < getMaxVoices(); ++i) {
-            if (!voices_[i]->loadSample(sampleBuffer_, sampleSampleRate_)) {
-                Logger::error("PolyphonicSampler '{}': Failed to load sample into voice {}", 
-                             getName(), i);
-                allLoaded = false;
-            } else {
-                applyGlobalParametersToVoice(i);
-            }
-        }
-        
-        if (allLoaded) {
-            Logger::info("PolyphonicSampler '{}': Loaded sample '{}' into {} voices - {} channels, {} samples, {:.1f} Hz", 
-                        getName(), filePath, getMaxVoices(), sampleBuffer_.getNumChannels(), 
-                        sampleBuffer_.getNumFrames(), sampleSampleRate_);
-        }
-        
-        return allLoaded;
-        
-    } catch (const std::exception& e) {
-        Logger::error("PolyphonicSampler '{}': Exception loading file '{}': {}", 
-                     getName(), filePath, e.what());
+    auto data = SampleData::loadFile(filePath);
+    if (!data) {
+        Logger::error("PolyphonicSampler '{}': Failed to load file: {}", getName(), filePath);
         return false;
     }
+    
+    return loadSample(std::move(data));
+}
+
+bool PolyphonicSampler::loadSampleMapped(const std::string& filePath, const SampleData::MapOptions& options) {
+    auto data = SampleData::mapFile(filePath, options);
+    if (!data) {
+        Logger::error("PolyphonicSampler '{}': Failed to map file: {}", getName(), filePath);
+        return false;
+    }
+    
+    return loadSample(std::move(data));
 }
 
 bool PolyphonicSampler::loadSample(const choc::buffer::ChannelArrayBuffer<float>& buffer, double sampleRate) {
@@ -176,15 +146,24 @@ bool PolyphonicSampler::loadSample(const choc::buffer::ChannelArrayBuffer<float>
         return false;
     }
     
+    return loadSample(std::make_shared<const SampleData>(buffer, sampleRate));
+}
+
+bool PolyphonicSampler::loadSample(std::shared_ptr<const SampleData> sampleData) {
+    if (!sampleData || sampleData->getNumFrames() == 0) {
+        Logger::error("PolyphonicSampler '{}': Cannot load empty sample", getName());
+        return false;
+    }
+    
     // Store sample data
-    sampleBuffer_ = buffer;
-    sampleSampleRate_ = sampleRate;
-    loadedFilePath_ = "<buffer>";
+    sample_ = std::move(sampleData);
+    sampleSampleRate_ = sample_->getSampleRate();
+    loadedFilePath_ = sample_->getSourcePath();
     
-    // Load sample into all voices
+    // Every voice references the same frames
     bool allLoaded = true;
     for (int i = 0; i < getMaxVoices(); ++i) {
-        if (!voices_[i]->loadSample(sampleBuffer_, sampleSampleRate_)) {
+        if (!voices_[i]->loadSample(sample_)) {
             Logger::error("PolyphonicSampler '{}': Failed to load sample into voice {}", 
                          getName(), i);
             allLoaded = false;
@@ -194,14 +173,59 @@ bool PolyphonicSampler::loadSample(const choc::buffer::ChannelArrayBuffer<float>
     }
     
     if (allLoaded) {
-        Logger::info("PolyphonicSampler '{}': Loaded buffer into {} voices - {} channels, {} samples, {:.1f} Hz", 
-                    getName(), getMaxVoices(), sampleBuffer_.getNumChannels(), 
-                    sampleBuffer_.getNumFrames(), sampleSampleRate_);
+        Logger::info("PolyphonicSampler '{}': Loaded sample '{}' into {} voices - {} channels, {} samples, {:.1f} Hz", 
+                    getName(), loadedFilePath_, getMaxVoices(), sample_->getNumChannels(), 
+                    sample_->getNumFrames(), sampleSampleRate_);
     }
     
     return allLoaded;
 }
 
+bool PolyphonicSampler::loadSampleStreamed(const std::string& filePath, std::shared_ptr<DiskStreamer> streamer) {
+    if (!streamer) {
+        Logger::error("PolyphonicSampler '{}': No streamer to stream {}", getName(), filePath);
+        return false;
+    }
+    
+    auto streamedSample = streamer->openSample(filePath);
+    if (!streamedSample) {
+        Logger::error("PolyphonicSampler '{}': Failed to open file for streaming: {}", getName(), filePath);
+        return false;
+    }
+    
+    sample_.reset();
+    sampleSampleRate_ = streamedSample->getSampleRate();
+    loadedFilePath_ = filePath;
+    
+    // The voices share the preloaded head; each streams the rest through its own ring buffer
+    bool allLoaded = true;
+    for (int i = 0; i < getMaxVoices(); ++i) {
+        if (!voices_[i]->loadSampleStreamed(streamedSample, streamer)) {
+            Logger::error("PolyphonicSampler '{}': Failed to stream sample into voice {}", 
+                         getName(), i);
+            allLoaded = false;
+        } else {
+            applyGlobalParametersToVoice(i);
+        }
+    }
+    
+    if (allLoaded) {
+        Logger::info("PolyphonicSampler '{}': Streaming sample '{}' with {} voices - {} channels, {} samples, {:.1f} Hz", 
+                    getName(), loadedFilePath_, getMaxVoices(), streamedSample->getNumChannels(), 
+                    streamedSample->getNumFrames(), sampleSampleRate_);
+    }
+    
+    return allLoaded;
+}
+
+uint64_t PolyphonicSampler::getStreamUnderrunFrames() const {
+    uint64_t total = 0;
+    for (const auto& voice : voices_) {
+        total += voice->getStreamUnderrunFrames();
+    }
+    return total;
+}
+
 void PolyphonicSampler::unloadSample() {
     // Stop all voices and unload samples
     allSoundOff();
@@ -210,7 +234,7 @@ void PolyphonicSampler::unloadSample() {
         voice->unloadSample();
     }
     
-    sampleBuffer_ = choc::buffer::ChannelArrayBuffer<float>();
+    sample_.reset();
     sampleSampleRate_ = 44100.0;
     loadedFilePath_.clear();
     
@@ -472,7 +496,7 @@ void PolyphonicSampler::printSamplerInfo() const {
     
     if (hasSample()) {
         Logger::info("Channels: {}, Samples: {}, Sample Rate: {:.1f} Hz", 
-                    sampleBuffer_.getNumChannels(), sampleBuffer_.getNumFrames(), sampleSampleRate_);
+                    voices_[0]->getNumChannels(), voices_[0]->getTotalSamples(), sampleSampleRate_);
     }
     
     Logger::info("Voices: {} / {} active", getActiveVoiceCount(), getMaxVoices());
@@ -483,7 +507,8 @@ void PolyphonicSampler::printSamplerInfo() const {
     Logger::info("  Loop: {}, Interpolation: {}", 
                 globalLoop_ ? "ON" : "OFF",
                 (globalInterpolationMode_ == SamplePlayerNode::InterpolationMode::NONE ? "NONE" :
-                 globalInterpolationMode_ == SamplePlayerNode::InterpolationMode::LINEAR ? "LINEAR" : "CUBIC"));
+                 globalInterpolationMode_ == SamplePlayerNode::InterpolationMode::LINEAR ? "LINEAR" :
+                 globalInterpolationMode_ == SamplePlayerNode::InterpolationMode::CUBIC ? "CUBIC" : "SINC"));
     Logger::info("Audio Levels: Peak: {:.3f}, RMS: {:.3f}", currentPeakLevel_, currentRMSLevel_);
     Logger::info("=====================================");
 }
@@ -52,20 +52,56 @@ public:
     // =========================
     
     /**
-     * Load a sample file for all voices
+     * Load a sample file for all voices. The voices share one copy of the frames, as do
+     * other samplers that have loaded the same file (see SampleData::loadFile).
      * @param filePath Path to the audio file
      * @return True if sample was loaded successfully
      */
     bool loadSample(const std::string& filePath);
     
     /**
-     * Load a sample from buffer for all voices
+     * Load a sample from buffer for all voices (copied once, then shared by the voices)
      * @param buffer Audio buffer to load
      * @param sampleRate Sample rate of the buffer
      * @return True if sample was loaded successfully
      */
     bool loadSample(const choc::buffer::ChannelArrayBuffer<float>& buffer, double sampleRate);
     
+    /**
+     * Share already loaded sample data with all voices
+     * @param sampleData Sample data to play
+     * @return True if sample was loaded successfully
+     */
+    bool loadSample(std::shared_ptr<const SampleData> sampleData);
+    
+    /**
+     * Map a 32-bit float WAV or cache file for all voices instead of decoding it. Pages are
+     * read in as they're played and shared with other processes mapping the same file.
+     * @param filePath Path to the audio file
+     * @param options Access hint and how much of the attack to lock in memory
+     * @return True if sample was mapped successfully
+     */
+    bool loadSampleMapped(const std::string& filePath, const SampleData::MapOptions& options = {});
+    
+    /**
+     * Stream a sample file from disk for all voices. Only the head of the file is loaded;
+     * each voice gets its own stream, read ahead by the streamer's I/O threads.
+     * @param filePath Path to the audio file
+     * @param streamer Streamer that owns the I/O threads
+     * @return True if every voice got a stream
+     */
+    bool loadSampleStreamed(const std::string& filePath, std::shared_ptr<DiskStreamer> streamer);
+    
+    /**
+     * Frames played as silence across all voices because the disk fell behind
+     */
+    uint64_t getStreamUnderrunFrames() const;
+    
+    /**
+     * Get the shared sample data (nullptr if none is loaded, or while streaming)
+     */
+    const std::shared_ptr<const SampleData>& getSampleData() const { return sample_; }
+    
     /**
      * Unload the current sample from all voices
      */
@@ -94,6 +130,11 @@ public:
      */
     int processMidiMessage(const choc::midi::ShortMessage& message);
     
+    /**
+     * Sample-accurate MIDI from AudioEngine::scheduleMidiMessage (audio thread)
+     */
+    void handleMidiMessage(const choc::midi::ShortMessage& message) override { processMidiMessage(message); }
+    
     /**
      * Trigger a note
      * @param note MIDI note number (0-127)
@@ -340,7 +381,7 @@ private:
     
     // Current sample info
     std::string loadedFilePath_;
-    choc::buffer::ChannelArrayBuffer<float> sampleBuffer_;
+    std::shared_ptr<const SampleData> sample_;
     double sampleSampleRate_ = 44100.0;
     
     // Audio analysis
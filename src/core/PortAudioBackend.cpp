@@ -0,0 +1,143 @@
+#include "PortAudioBackend.h"
+#include "Logger.h"
+
+PortAudioBackend::~PortAudioBackend() {
+    closeStream();
+    if (initialized) {
+        Pa_Terminate();
+    }
+}
+
+bool PortAudioBackend::initialize() {
+    PaError err = Pa_Initialize();
+    if (err != paNoError) {
+        Logger::error("Failed to initialize PortAudio: {}", Pa_GetErrorText(err));
+        return false;
+    }
+    initialized = true;
+    return true;
+}
+
+std::vector<AudioDeviceInfo> PortAudioBackend::getDevices() {
+    int numDevices = Pa_GetDeviceCount();
+    if (numDevices < 0) {
+        Logger::error("Pa_GetDeviceCount failed");
+        return {};
+    }
+
+    std::vector<AudioDeviceInfo> devices;
+    for (int i = 0; i < numDevices; ++i) {
+        const PaDeviceInfo* info = Pa_GetDeviceInfo(i);
+        AudioDeviceInfo dev;
+        dev.index = i;
+        dev.name = info->name ? info->name : "";
+        dev.maxInputChannels = info->maxInputChannels;
+        dev.maxOutputChannels = info->maxOutputChannels;
+        dev.defaultSampleRate = info->defaultSampleRate;
+        devices.push_back(dev);
+    }
+    return devices;
+}
+
+int PortAudioBackend::getDefaultInputDevice() const {
+    PaDeviceIndex device = Pa_GetDefaultInputDevice();
+    return device == paNoDevice ? -1 : device;
+}
+
+int PortAudioBackend::getDefaultOutputDevice() const {
+    PaDeviceIndex device = Pa_GetDefaultOutputDevice();
+    return device == paNoDevice ? -1 : device;
+}
+
+bool PortAudioBackend::openStream(const StreamConfig& config, PaStreamCallback* callback, void* userData) {
+    closeStream();
+
+    PaStreamParameters inputParams = {};
+    PaStreamParameters outputParams = {};
+
+    if (config.inputDevice >= 0 && config.inputChannels > 0) {
+        inputParams.device = config.inputDevice;
+        inputParams.channelCount = config.inputChannels;
+        inputParams.sampleFormat = paFloat32;
+        inputParams.suggestedLatency = Pa_GetDeviceInfo(config.inputDevice)->defaultLowInputLatency;
+        inputParams.hostApiSpecificStreamInfo = nullptr;
+    } else {
+        inputParams.device = paNoDevice;
+    }
+
+    if (config.outputDevice >= 0 && config.outputChannels > 0) {
+        outputParams.device = config.outputDevice;
+        outputParams.channelCount = config.outputChannels;
+        outputParams.sampleFormat = paFloat32;
+        outputParams.suggestedLatency = Pa_GetDeviceInfo(config.outputDevice)->defaultLowOutputLatency;
+        outputParams.hostApiSpecificStreamInfo = nullptr;
+    } else {
+        outputParams.device = paNoDevice;
+    }
+
+    const PaStreamParameters* inputParamsPtr = inputParams.device != paNoDevice ? &inputParams : nullptr;
+    const PaStreamParameters* outputParamsPtr = outputParams.device != paNoDevice ? &outputParams : nullptr;
+
+    // Prefer non-interleaved buffers when asked for and the host API supports them
+    nonInterleaved = false;
+    if (config.nonInterleaved) {
+        inputParams.sampleFormat = paFloat32 | paNonInterleaved;
+        outputParams.sampleFormat = paFloat32 | paNonInterleaved;
+
+        if (Pa_IsFormatSupported(inputParamsPtr, outputParamsPtr, config.sampleRate) == paFormatIsSupported) {
+            nonInterleaved = true;
+        } else {
+            Logger::info("Non-interleaved buffers not supported by this device, using interleaved");
+            inputParams.sampleFormat = paFloat32;
+            outputParams.sampleFormat = paFloat32;
+        }
+    }
+
+    PaError err = Pa_OpenStream(
+        &stream,
+        inputParamsPtr,
+        outputParamsPtr,
+        config.sampleRate,
+        config.bufferSize,
+        paNoFlag,
+        callback,
+        userData
+    );
+    if (err != paNoError && nonInterleaved) {
+        Logger::info("Opening non-interleaved stream failed ({}), retrying interleaved", Pa_GetErrorText(err));
+        inputParams.sampleFormat = paFloat32;
+        outputParams.sampleFormat = paFloat32;
+        nonInterleaved = false;
+        err = Pa_OpenStream(&stream, inputParamsPtr, outputParamsPtr, config.sampleRate, config.bufferSize,
+                            paNoFlag, callback, userData);
+    }
+    if (err != paNoError) {
+        Logger::error("Failed to open PortAudio stream: {}", Pa_GetErrorText(err));
+        stream = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool PortAudioBackend::startStream() {
+    if (!stream) return false;
+
+    PaError err = Pa_StartStream(stream);
+    if (err != paNoError) {
+        Logger::error("Failed to start PortAudio stream: {}", Pa_GetErrorText(err));
+        return false;
+    }
+    return true;
+}
+
+void PortAudioBackend::closeStream() {
+    if (stream) {
+        Pa_StopStream(stream);
+        Pa_CloseStream(stream);
+        stream = nullptr;
+    }
+}
+
+bool PortAudioBackend::isStreamActive() const {
+    return stream && Pa_IsStreamActive(stream) == 1;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "AudioDeviceBackend.h"
+
+// Real audio hardware through PortAudio
+class PortAudioBackend : public AudioDeviceBackend {
+public:
+    ~PortAudioBackend() override;
+
+    std::string getName() const override { return "PortAudio"; }
+    bool initialize() override;
+
+    std::vector<AudioDeviceInfo> getDevices() override;
+    int getDefaultInputDevice() const override;
+    int getDefaultOutputDevice() const override;
+
+    bool openStream(const StreamConfig& config, PaStreamCallback* callback, void* userData) override;
+    bool startStream() override;
+    void closeStream() override;
+    bool isStreamOpen() const override { return stream != nullptr; }
+    bool isStreamActive() const override;
+    bool isStreamNonInterleaved() const override { return nonInterleaved; }
+
+private:
+    bool initialized = false;
+    PaStream* stream = nullptr;
+    bool nonInterleaved = false;
+};
@@ -0,0 +1,389 @@
+#include "SampleData.h"
+#include "Logger.h"
+#include "../../lib/choc/audio/choc_AudioFileFormat_WAV.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct SampleData::MappedFile {
+    void* address = nullptr;
+    size_t length = 0;
+    const char* lockedStart = nullptr;
+    size_t lockedLength = 0;
+
+    ~MappedFile() {
+#if defined(__linux__) || defined(__APPLE__)
+        if (lockedLength > 0) {
+            munlock(lockedStart, lockedLength);
+        }
+        if (address) {
+            munmap(address, length);
+        }
+#endif
+    }
+};
+
+namespace {
+    // Weak references, so a file's frames are freed when the last player lets go of them
+    struct LoadedFile {
+        std::weak_ptr<const SampleData> data;
+        std::filesystem::file_time_type lastWriteTime;
+        std::uintmax_t fileSize = 0;
+    };
+
+    std::mutex loadedFilesMutex;
+    std::unordered_map<std::string, LoadedFile> loadedFiles;
+
+    std::string cacheKeyFor(const std::string& filePath) {
+        std::error_code error;
+        auto canonical = std::filesystem::weakly_canonical(filePath, error);
+        return error ? filePath : canonical.string();
+    }
+
+    // The shared copy of a file if it's still in use and unchanged, otherwise whatever
+    // load(path) produces. Decoded and mapped copies of a file are cached separately.
+    template <typename Load>
+    std::shared_ptr<const SampleData> findOrLoad(const std::string& filePath, const char* kind, Load&& load) {
+        auto path = cacheKeyFor(filePath);
+        auto key = kind + path;
+
+        std::error_code error;
+        auto lastWriteTime = std::filesystem::last_write_time(path, error);
+        auto fileSize = error ? 0 : std::filesystem::file_size(path, error);
+        if (error) {
+            Logger::error("SampleData: Cannot read file: {}", filePath);
+            return nullptr;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(loadedFilesMutex);
+            auto existing = loadedFiles.find(key);
+            if (existing != loadedFiles.end()) {
+                auto data = existing->second.data.lock();
+                if (data && existing->second.lastWriteTime == lastWriteTime && existing->second.fileSize == fileSize) {
+                    return data;
+                }
+            }
+        }
+
+        // Load outside the lock so loads of different files don't wait on each other
+        auto data = load(path);
+        if (!data) {
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock(loadedFilesMutex);
+        auto& entry = loadedFiles[key];
+        if (auto loadedMeanwhile = entry.data.lock();
+            loadedMeanwhile && entry.lastWriteTime == lastWriteTime && entry.fileSize == fileSize) {
+            return loadedMeanwhile;
+        }
+        entry = { data, lastWriteTime, fileSize };
+
+        // Drop entries whose samples have all been released
+        for (auto it = loadedFiles.begin(); it != loadedFiles.end();) {
+            it = it->second.data.expired() ? loadedFiles.erase(it) : std::next(it);
+        }
+
+        return data;
+    }
+
+    // Cache file layout: this header (64 bytes, native byte order), then interleaved floats
+    constexpr char cacheMagic[8] = { 'S', 'M', 'P', 'L', 'F', '3', '2', '\0' };
+    constexpr size_t cacheHeaderSize = 64;
+
+    struct CacheHeader {
+        char magic[8];
+        uint32_t numChannels;
+        uint32_t reserved;
+        uint64_t numFrames;
+        double sampleRate;
+    };
+    static_assert(sizeof(CacheHeader) <= cacheHeaderSize);
+
+    template <typename Type>
+    Type readLittleEndian(const unsigned char* bytes) {
+        Type value = 0;
+        for (size_t i = 0; i < sizeof(Type); ++i) {
+            value |= static_cast<Type>(bytes[i]) << (8 * i);
+        }
+        return value;
+    }
+
+    struct FloatLayout {
+        size_t dataOffset = 0;
+        int numChannels = 0;
+        int64_t numFrames = 0;
+        double sampleRate = 0.0;
+    };
+
+    // Finds the interleaved float frames in a mapped file. False (with the reason) if it
+    // isn't a cache file or a WAV holding 32-bit IEEE floats.
+    bool findFloatFrames(const unsigned char* file, size_t length, FloatLayout& layout, std::string& reason) {
+        if (length >= cacheHeaderSize && std::memcmp(file, cacheMagic, sizeof(cacheMagic)) == 0) {
+            CacheHeader header;
+            std::memcpy(&header, file, sizeof(header));
+            layout.dataOffset = cacheHeaderSize;
+            layout.numChannels = static_cast<int>(header.numChannels);
+            layout.numFrames = static_cast<int64_t>(header.numFrames);
+            layout.sampleRate = header.sampleRate;
+            return true;
+        }
+
+        if (length < 12 || std::memcmp(file, "RIFF", 4) != 0 || std::memcmp(file + 8, "WAVE", 4) != 0) {
+            reason = "not a WAV or sample cache file";
+            return false;
+        }
+
+        bool foundFormat = false;
+        size_t position = 12;
+        while (position + 8 <= length) {
+            auto chunkSize = static_cast<size_t>(readLittleEndian<uint32_t>(file + position + 4));
+            auto chunkData = position + 8;
+
+            if (std::memcmp(file + position, "fmt ", 4) == 0 && chunkData + 16 <= length) {
+                auto format = readLittleEndian<uint16_t>(file + chunkData);
+                auto bitsPerSample = readLittleEndian<uint16_t>(file + chunkData + 14);
+
+                // WAVE_FORMAT_EXTENSIBLE keeps the real format at the start of its sub-format GUID
+                if (format == 0xfffe && chunkSize >= 26 && chunkData + 26 <= length) {
+                    format = readLittleEndian<uint16_t>(file + chunkData + 24);
+                }
+                if (format != 3 || bitsPerSample != 32) {
+                    reason = "samples aren't 32-bit float";
+                    return false;
+                }
+
+                layout.numChannels = readLittleEndian<uint16_t>(file + chunkData + 2);
+                layout.sampleRate = readLittleEndian<uint32_t>(file + chunkData + 4);
+                foundFormat = true;
+            } else if (std::memcmp(file + position, "data", 4) == 0) {
+                if (!foundFormat) {
+                    reason = "data chunk before format chunk";
+                    return false;
+                }
+                if (chunkData % alignof(float) != 0) {
+                    reason = "frames aren't aligned for direct reads";
+                    return false;
+                }
+
+                auto dataBytes = std::min(chunkSize, length - chunkData);
+                layout.dataOffset = chunkData;
+                layout.numFrames = static_cast<int64_t>(dataBytes / (sizeof(float) * std::max(1, layout.numChannels)));
+                return true;
+            }
+
+            position = chunkData + chunkSize + (chunkSize & 1); // Chunks are padded to even sizes
+        }
+
+        reason = "no data chunk";
+        return false;
+    }
+}
+
+SampleData::SampleData(choc::buffer::ChannelArrayBuffer<float> frames_, double sampleRate_, std::string sourcePath_)
+    : frames(std::move(frames_)),
+      numChannels(static_cast<int>(frames.getNumChannels())), numFrames(static_cast<int>(frames.getNumFrames())),
+      sampleRate(sampleRate_), sourcePath(std::move(sourcePath_))
+{
+    if (numFrames > 0) {
+        for (int ch = 0; ch < numChannels; ++ch) {
+            channels.push_back(&frames.getSample(static_cast<choc::buffer::ChannelCount>(ch), 0));
+        }
+    }
+}
+
+SampleData::SampleData(std::unique_ptr<MappedFile> mapping_, const float* interleaved, int numChannels_, int numFrames_,
+                       double sampleRate_, std::string sourcePath_)
+    : mapping(std::move(mapping_)), stride(static_cast<size_t>(numChannels_)),
+      numChannels(numChannels_), numFrames(numFrames_),
+      sampleRate(sampleRate_), sourcePath(std::move(sourcePath_))
+{
+    for (int ch = 0; ch < numChannels; ++ch) {
+        channels.push_back(interleaved + ch);
+    }
+}
+
+SampleData::~SampleData() = default;
+
+std::shared_ptr<const SampleData> SampleData::loadFile(const std::string& filePath) {
+    return findOrLoad(filePath, "decoded:", [&](const std::string& path) -> std::shared_ptr<const SampleData> {
+        try {
+            choc::audio::WAVAudioFileFormat<false> wavFormat;
+            auto reader = wavFormat.createReader(path);
+            if (!reader) {
+                Logger::error("SampleData: Failed to create reader for file: {}", filePath);
+                return nullptr;
+            }
+
+            auto content = reader->loadFileContent();
+            if (content.frames.getNumFrames() == 0) {
+                Logger::error("SampleData: No audio data in file: {}", filePath);
+                return nullptr;
+            }
+
+            return std::make_shared<const SampleData>(std::move(content.frames), content.sampleRate, filePath);
+        } catch (const std::exception& e) {
+            Logger::error("SampleData: Exception loading file '{}': {}", filePath, e.what());
+            return nullptr;
+        }
+    });
+}
+
+std::shared_ptr<const SampleData> SampleData::mapFile(const std::string& filePath) {
+    return mapFile(filePath, MapOptions {});
+}
+
+std::shared_ptr<const SampleData> SampleData::mapFile(const std::string& filePath, const MapOptions& options) {
+#if defined(__linux__) || defined(__APPLE__)
+    return findOrLoad(filePath, "mapped:", [&](const std::string& path) -> std::shared_ptr<const SampleData> {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            Logger::error("SampleData: Cannot open file for mapping: {}", filePath);
+            return nullptr;
+        }
+
+        struct stat status {};
+        auto mapping = std::make_unique<MappedFile>();
+        if (fstat(fd, &status) == 0 && status.st_size > 0) {
+            mapping->length = static_cast<size_t>(status.st_size);
+            // MAP_SHARED of a read-only file: the pages are the page cache's, shared with other processes
+            void* address = mmap(nullptr, mapping->length, PROT_READ, MAP_SHARED, fd, 0);
+            mapping->address = address == MAP_FAILED ? nullptr : address;
+        }
+        close(fd);
+
+        if (!mapping->address) {
+            Logger::error("SampleData: Failed to map file: {}", filePath);
+            return nullptr;
+        }
+
+        FloatLayout layout;
+        std::string reason;
+        auto* file = static_cast<const unsigned char*>(mapping->address);
+        if (!findFloatFrames(file, mapping->length, layout, reason)) {
+            Logger::error("SampleData: Cannot map '{}': {}", filePath, reason);
+            return nullptr;
+        }
+
+        auto frameBytes = sizeof(float) * static_cast<size_t>(std::max(1, layout.numChannels));
+        auto availableFrames = static_cast<int64_t>((mapping->length - layout.dataOffset) / frameBytes);
+        layout.numFrames = std::min({ layout.numFrames, availableFrames, static_cast<int64_t>(INT32_MAX) });
+        if (layout.numChannels <= 0 || layout.numFrames <= 0) {
+            Logger::error("SampleData: No audio data in file: {}", filePath);
+            return nullptr;
+        }
+
+        auto* data = file + layout.dataOffset;
+        auto dataBytes = static_cast<size_t>(layout.numFrames) * frameBytes;
+
+        if (options.sequentialAccess) {
+            madvise(mapping->address, mapping->length, MADV_SEQUENTIAL);
+        }
+
+        if (options.lockedFrames > 0) {
+            auto lockedBytes = std::min(dataBytes, static_cast<size_t>(options.lockedFrames) * frameBytes);
+            if (mlock(data, lockedBytes) == 0) {
+                mapping->lockedStart = reinterpret_cast<const char*>(data);
+                mapping->lockedLength = lockedBytes;
+            } else {
+                // Usually RLIMIT_MEMLOCK; at least have the attack read in now rather than on the first note
+                Logger::warn("SampleData: Couldn't lock the first {} frames of '{}' in memory", options.lockedFrames, filePath);
+                auto pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+                auto pageStart = reinterpret_cast<uintptr_t>(data) & ~(pageSize - 1);
+                madvise(reinterpret_cast<void*>(pageStart), lockedBytes + (reinterpret_cast<uintptr_t>(data) - pageStart), MADV_WILLNEED);
+            }
+        }
+
+        return std::shared_ptr<const SampleData>(new SampleData(std::move(mapping), reinterpret_cast<const float*>(data),
+                                                                layout.numChannels, static_cast<int>(layout.numFrames),
+                                                                layout.sampleRate, filePath));
+    });
+#else
+    (void) options;
+    Logger::error("SampleData: Memory-mapped loading isn't supported on this platform: {}", filePath);
+    return nullptr;
+#endif
+}
+
+bool SampleData::writeCacheFile(const std::string& filePath) const {
+    // Written beside the target and renamed over it, so a process that has the old file
+    // mapped keeps reading intact data and nobody ever maps a half-written cache
+    static std::atomic<uint32_t> tempFileCounter{0};
+    const std::string tempPath = filePath + ".tmp" +
+                                 std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) +
+                                 "-" + std::to_string(tempFileCounter++);
+
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        Logger::error("SampleData: Cannot create cache file: {}", tempPath);
+        return false;
+    }
+
+    CacheHeader header {};
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.numChannels = static_cast<uint32_t>(numChannels);
+    header.numFrames = static_cast<uint64_t>(numFrames);
+    header.sampleRate = sampleRate;
+
+    char headerBytes[cacheHeaderSize] = {};
+    std::memcpy(headerBytes, &header, sizeof(header));
+    file.write(headerBytes, sizeof(headerBytes));
+
+    // Interleave a block of frames at a time
+    constexpr int framesPerWrite = 4096;
+    std::vector<float> interleaved(static_cast<size_t>(framesPerWrite) * static_cast<size_t>(numChannels));
+    for (int start = 0; start < numFrames; start += framesPerWrite) {
+        int count = std::min(framesPerWrite, numFrames - start);
+        for (int frame = 0; frame < count; ++frame) {
+            for (int ch = 0; ch < numChannels; ++ch) {
+                interleaved[static_cast<size_t>(frame * numChannels + ch)] = getSample(ch, start + frame);
+            }
+        }
+        file.write(reinterpret_cast<const char*>(interleaved.data()),
+                   static_cast<std::streamsize>(static_cast<size_t>(count * numChannels) * sizeof(float)));
+    }
+
+    file.close();
+    std::error_code error;
+    if (!file) {
+        Logger::error("SampleData: Failed writing cache file: {}", tempPath);
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+
+    std::filesystem::rename(tempPath, filePath, error);
+    if (error) {
+        Logger::error("SampleData: Cannot replace cache file {}: {}", filePath, error.message());
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
+
+size_t SampleData::getNumLoadedFiles() {
+    std::lock_guard<std::mutex> lock(loadedFilesMutex);
+    size_t count = 0;
+    for (const auto& [path, entry] : loadedFiles) {
+        count += entry.data.expired() ? 0 : 1;
+    }
+    return count;
+}
+
+size_t SampleData::getLockedBytes() const {
+    return mapping ? mapping->lockedLength : 0;
+}
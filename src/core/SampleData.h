@@ -0,0 +1,81 @@
+#pragma once
+
+#include "../../lib/choc/audio/choc_SampleBuffers.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Decoded sample content, immutable once constructed. Players hold a
+// std::shared_ptr<const SampleData> instead of their own copy, so every voice of a
+// sampler (and every sampler playing the same file) reads the same frames.
+//
+// The frames either live in memory or, for 32-bit float WAVs and cache files, are read
+// straight from a read-only mapping of the file: nothing is decoded, pages come in from
+// disk as they're first played, and the OS page cache shares them between processes.
+class SampleData {
+public:
+    SampleData(choc::buffer::ChannelArrayBuffer<float> frames, double sampleRate, std::string sourcePath = "<buffer>");
+    ~SampleData();
+
+    SampleData(const SampleData&) = delete;
+    SampleData& operator=(const SampleData&) = delete;
+
+    // Decodes a WAV file, or returns the copy already in memory if anything still holds one
+    // for that file (unchanged on disk since). nullptr if the file can't be read or is empty.
+    static std::shared_ptr<const SampleData> loadFile(const std::string& filePath);
+
+    struct MapOptions {
+        bool sequentialAccess = true;   // madvise(MADV_SEQUENTIAL): aggressive read-ahead for playback
+        int lockedFrames = 0;           // mlock this many frames from the start (the attack) so note-ons never fault
+    };
+
+    // Maps a 32-bit float WAV or a cache file (see writeCacheFile) instead of decoding it.
+    // Shared like loadFile; the options of the first mapping of a file apply. nullptr if
+    // the file is in another format (decode it with loadFile) or can't be mapped.
+    static std::shared_ptr<const SampleData> mapFile(const std::string& filePath);
+    static std::shared_ptr<const SampleData> mapFile(const std::string& filePath, const MapOptions& options);
+
+    // Writes the frames as a cache file: a 64-byte header then interleaved native floats, so
+    // samples decoded from other formats can be mapped next time
+    bool writeCacheFile(const std::string& filePath) const;
+
+    // Files currently shared through loadFile/mapFile
+    static size_t getNumLoadedFiles();
+
+    float getSample(int channel, int frame) const {
+        return channels[static_cast<size_t>(channel)][static_cast<size_t>(frame) * stride];
+    }
+
+    // Raw access for block kernels: frame n of a channel is at getChannelData(channel)[n * getStride()]
+    const float* getChannelData(int channel) const { return channels[static_cast<size_t>(channel)]; }
+    size_t getStride() const { return stride; }
+
+    int getNumChannels() const { return numChannels; }
+    int getNumFrames() const { return numFrames; }
+    double getSampleRate() const { return sampleRate; }
+    const std::string& getSourcePath() const { return sourcePath; }
+    size_t getSizeInBytes() const { return static_cast<size_t>(numChannels) * static_cast<size_t>(numFrames) * sizeof(float); }
+
+    bool isMapped() const { return mapping != nullptr; }
+    size_t getLockedBytes() const;
+
+private:
+    struct MappedFile;
+
+    SampleData(std::unique_ptr<MappedFile> mapping, const float* interleaved, int numChannels, int numFrames,
+               double sampleRate, std::string sourcePath);
+
+    // In-memory frames, or the mapping (frames stay empty)
+    choc::buffer::ChannelArrayBuffer<float> frames;
+    std::unique_ptr<MappedFile> mapping;
+
+    // Where each channel starts and the distance between its frames: 1 in memory,
+    // the channel count for interleaved mapped data
+    std::vector<const float*> channels;
+    size_t stride = 1;
+
+    int numChannels = 0;
+    int numFrames = 0;
+    double sampleRate;
+    std::string sourcePath;
+};
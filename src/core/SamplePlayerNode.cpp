@@ -1,8 +1,21 @@
 #include "SamplePlayerNode.h"
 #include "ADSR.h"
+#include "AudioKernels.h"
 #include <algorithm>
 #include <cstring>
 
+namespace {
+    // Catmull-Rom through y1..y2, a = fraction of the way from y1 to y2
+    float cubicInterpolate(float y0, float y1, float y2, float y3, float a) {
+        float a2 = a * a;
+        float a3 = a2 * a;
+        
+        return y1 + 0.5f * a * (y2 - y0) + 
+               0.5f * a2 * (2.0f * y0 - 5.0f * y1 + 4.0f * y2 - y3) + 
+               0.5f * a3 * (-y0 + 3.0f * y1 - 3.0f * y2 + y3);
+    }
+}
+
 SamplePlayerNode::SamplePlayerNode(const std::string& name)
     : AudioNode(name)
 {
@@ -33,15 +46,15 @@ void SamplePlayerNode::processCallback(choc::buffer::ChannelArrayView<const floa
             Logger::debug("SamplePlayerNode '{}': Stopping - no sample loaded", getName());
             stop();
         }
+        setOutputSilent(true);
         return;
     }
     
     if (playbackState_ != PlaybackState::PLAYING) {
+        setOutputSilent(true);
         return;
     }
     
-    const int outputChannels = static_cast<int>(output.getNumChannels());
-    const int sampleChannels = static_cast<int>(sampleBuffer_.getNumChannels());
     const int totalSamples = getTotalSamples();
     
     // Calculate effective sample region
@@ -58,53 +71,10 @@ void SamplePlayerNode::processCallback(choc::buffer::ChannelArrayView<const floa
         return;
     }
     
-    // Process samples
-    for (int i = 0; i < numSamples; ++i) {
-        // Check if we've reached the end
-        if (playPosition_ >= effectiveEnd) {
-            if (loop_) {
-                handleLooping();
-            } else {
-                stop();
-                break;
-            }
-        }
-        
-        // Check if we're still in valid range
-        if (playPosition_ < effectiveStart || playPosition_ >= effectiveEnd) {
-            stop();
-            break;
-        }
-        
-        // Get interpolated sample for each output channel
-        for (int ch = 0; ch < outputChannels; ++ch) {
-            float sample = 0.0f;
-            
-            if (sampleChannels == 1) {
-                // Mono sample - use for all output channels
-                sample = getSampleInterpolated(0, playPosition_);
-            } else if (ch < sampleChannels) {
-                // Multi-channel sample - use corresponding channel
-                sample = getSampleInterpolated(ch, playPosition_);
-            } else {
-                // More output channels than sample channels - repeat last sample channel
-                sample = getSampleInterpolated(sampleChannels - 1, playPosition_);
-            }
-            
-            // Apply gain and volume
-            sample *= gain_ * volume_;
-            
-            // Apply amplitude envelope if available
-            if (amplitudeEnvelope_) {
-                sample *= static_cast<float>(amplitudeEnvelope_->getCurrentValue());
-            }
-            
-            output.getSample(static_cast<choc::buffer::ChannelCount>(ch), 
-                           static_cast<choc::buffer::FrameCount>(i)) = sample;
-        }
-        
-        // Advance playback position
-        playPosition_ += playbackRate_;
+    if (stream_) {
+        renderStreamed(output, numSamples, effectiveStart, effectiveEnd);
+    } else {
+        renderBlock(output, numSamples, effectiveStart, effectiveEnd);
     }
     
     // Update audio analysis
@@ -112,54 +82,23 @@ void SamplePlayerNode::processCallback(choc::buffer::ChannelArrayView<const floa
 }
 
 bool SamplePlayerNode::loadSample(const std::string& filePath) {
-    try {
-        choc::audio::WAVAudioFileFormat<false> wavFormat;
-        auto reader = wavFormat.createReader(filePath);
-        
-        if (!reader) {
-            Logger::error("SamplePlayerNode '{}': Failed to create reader for file: {}", 
-                         getName(), filePath);
-            return false;
-        }
-        
-        // Load the entire file
-        auto data = reader->loadFileContent();
-        
-        if (data.frames.getNumFrames() == 0) {
-            Logger::error("SamplePlayerNode '{}': No audio data in file: {}", 
-                         getName(), filePath);
-            return false;
-        }
-        
-        // Store the sample data
-        sampleBuffer_ = std::move(data.frames);
-        sampleSampleRate_ = data.sampleRate;
-        loadedFilePath_ = filePath;
-        
-        // Initialize sample region to full sample
-        startSample_ = 0;
-        endSample_ = getTotalSamples();
-        
-        // Initialize loop region to full sample
-        loopStart_ = startSample_;
-        loopEnd_ = endSample_;
-        
-        // Reset playback position
-        playPosition_ = startSample_;
-        
-        // Update playback rate for current note
-        updatePlaybackRate();
-        
-        Logger::info("SamplePlayerNode '{}': Loaded sample '{}' - {} channels, {} samples, {:.1f} Hz", 
-                    getName(), filePath, getNumChannels(), getTotalSamples(), sampleSampleRate_);
-        
-        return true;
-        
-    } catch (const std::exception& e) {
-        Logger::error("SamplePlayerNode '{}': Exception loading file '{}': {}", 
-                     getName(), filePath, e.what());
+    auto data = SampleData::loadFile(filePath);
+    if (!data) {
+        Logger::error("SamplePlayerNode '{}': Failed to load file: {}", getName(), filePath);
         return false;
     }
+    
+    return loadSample(std::move(data));
+}
+
+bool SamplePlayerNode::loadSampleMapped(const std::string& filePath, const SampleData::MapOptions& options) {
+    auto data = SampleData::mapFile(filePath, options);
+    if (!data) {
+        Logger::error("SamplePlayerNode '{}': Failed to map file: {}", getName(), filePath);
+        return false;
+    }
+    
+    return loadSample(std::move(data));
 }
 
 bool SamplePlayerNode::loadSample(const choc::buffer::ChannelArrayBuffer<float>& buffer, double sampleRate) {
@@ -168,34 +107,78 @@ bool SamplePlayerNode::loadSample(const choc::buffer::ChannelArrayBuffer<float>&
         return false;
     }
     
-    // Copy the buffer
-    sampleBuffer_ = buffer;
-    sampleSampleRate_ = sampleRate;
-    loadedFilePath_ = "<buffer>";
+    return loadSample(std::make_shared<const SampleData>(buffer, sampleRate));
+}
+
+bool SamplePlayerNode::loadSample(std::shared_ptr<const SampleData> sampleData) {
+    if (!sampleData || sampleData->getNumFrames() == 0) {
+        Logger::error("SamplePlayerNode '{}': Cannot load empty sample", getName());
+        return false;
+    }
     
-    // Initialize sample region to full sample
-    startSample_ = 0;
-    endSample_ = getTotalSamples();
+    // Share the data
+    stream_.reset();
+    streamer_.reset();
+    sample_ = std::move(sampleData);
+    sampleSampleRate_ = sample_->getSampleRate();
+    loadedFilePath_ = sample_->getSourcePath();
     
-    // Initialize loop region to full sample
-    loopStart_ = startSample_;
-    loopEnd_ = endSample_;
+    resetRegions();
     
-    // Reset playback position
-    playPosition_ = startSample_;
+    Logger::info("SamplePlayerNode '{}': Loaded sample '{}' - {} channels, {} samples, {:.1f} Hz", 
+                getName(), loadedFilePath_, getNumChannels(), getTotalSamples(), sampleSampleRate_);
     
-    // Update playback rate for current note
-    updatePlaybackRate();
+    return true;
+}
+
+bool SamplePlayerNode::loadSampleStreamed(const std::string& filePath, std::shared_ptr<DiskStreamer> streamer) {
+    if (!streamer) {
+        Logger::error("SamplePlayerNode '{}': No streamer to stream {}", getName(), filePath);
+        return false;
+    }
+    
+    auto sample = streamer->openSample(filePath);
+    if (!sample) {
+        Logger::error("SamplePlayerNode '{}': Failed to open file for streaming: {}", getName(), filePath);
+        return false;
+    }
+    
+    return loadSampleStreamed(std::move(sample), std::move(streamer));
+}
+
+bool SamplePlayerNode::loadSampleStreamed(std::shared_ptr<const StreamedSample> sample, std::shared_ptr<DiskStreamer> streamer) {
+    if (!sample || !streamer) {
+        Logger::error("SamplePlayerNode '{}': Cannot stream without a sample and a streamer", getName());
+        return false;
+    }
+    
+    // Each voice reads through its own stream (file handle and ring buffer)
+    auto stream = streamer->createStream(sample);
+    if (!stream) {
+        Logger::error("SamplePlayerNode '{}': Failed to create stream for {}", getName(), sample->getFilePath());
+        return false;
+    }
     
-    Logger::info("SamplePlayerNode '{}': Loaded buffer - {} channels, {} samples, {:.1f} Hz", 
-                getName(), getNumChannels(), getTotalSamples(), sampleSampleRate_);
+    stop();
+    sample_.reset();
+    streamer_ = std::move(streamer);
+    stream_ = std::move(stream);
+    sampleSampleRate_ = sample->getSampleRate();
+    loadedFilePath_ = sample->getFilePath();
+    
+    resetRegions();
+    
+    Logger::info("SamplePlayerNode '{}': Streaming sample '{}' - {} channels, {} samples ({} preloaded), {:.1f} Hz", 
+                getName(), loadedFilePath_, getNumChannels(), getTotalSamples(), sample->getNumHeadFrames(), sampleSampleRate_);
     
     return true;
 }
 
 void SamplePlayerNode::unloadSample() {
     stop();
-    sampleBuffer_ = choc::buffer::ChannelArrayBuffer<float>();
+    sample_.reset();
+    stream_.reset();
+    streamer_.reset();
     sampleSampleRate_ = 44100.0;
     loadedFilePath_.clear();
     
@@ -215,6 +198,7 @@ void SamplePlayerNode::play() {
 void SamplePlayerNode::stop() {
     playbackState_ = PlaybackState::STOPPED;
     playPosition_ = startSample_;
+    streamRestartPending_ = true;
     Logger::debug("SamplePlayerNode '{}': Stopped", getName());
 }
 
@@ -239,6 +223,7 @@ void SamplePlayerNode::trigger() {
     }
     
     playPosition_ = startSample_;
+    streamRestartPending_ = true;
     playbackState_ = PlaybackState::PLAYING;
     Logger::debug("SamplePlayerNode '{}': Triggered - pos: {}, region: {}-{}, total: {}", 
                  getName(), static_cast<int>(playPosition_), startSample_, endSample_, getTotalSamples());
@@ -259,6 +244,8 @@ void SamplePlayerNode::setStartSample(int startSample) {
         endSample_ = getTotalSamples();
     }
     
+    streamRegionChanged_ = true;
+    
     Logger::debug("SamplePlayerNode '{}': Start sample set to {}", getName(), startSample_);
 }
 
@@ -269,6 +256,8 @@ void SamplePlayerNode::setEndSample(int endSample) {
         endSample_ = std::max(startSample_ + 1, std::min(endSample, getTotalSamples()));
     }
     
+    streamRegionChanged_ = true;
+    
     Logger::debug("SamplePlayerNode '{}': End sample set to {}", getName(), endSample_);
 }
 
@@ -285,6 +274,8 @@ void SamplePlayerNode::setLoopStart(int loopStart) {
         loopEnd_ = endSample_;
     }
     
+    streamRegionChanged_ = true;
+    
     Logger::debug("SamplePlayerNode '{}': Loop start set to {}", getName(), loopStart_);
 }
 
@@ -295,6 +286,8 @@ void SamplePlayerNode::setLoopEnd(int loopEnd) {
         loopEnd_ = std::max(loopStart_ + 1, std::min(loopEnd, endSample_));
     }
     
+    streamRegionChanged_ = true;
+    
     Logger::debug("SamplePlayerNode '{}': Loop end set to {}", getName(), loopEnd_);
 }
 
@@ -303,10 +296,19 @@ void SamplePlayerNode::setLoopRegion(int loopStart, int loopEnd) {
     setLoopEnd(loopEnd);
 }
 
+void SamplePlayerNode::setInterpolationMode(InterpolationMode mode) {
+    // Build the sinc tables here rather than on the audio thread's first use
+    if (mode == InterpolationMode::SINC) {
+        AudioKernels::prepareSinc();
+    }
+    interpolationMode_ = mode;
+}
+
 void SamplePlayerNode::setPlayPosition(double position) {
     position = std::max(0.0, std::min(position, 1.0));
     int effectiveEnd = (endSample_ > 0) ? endSample_ : getTotalSamples();
     playPosition_ = startSample_ + position * (effectiveEnd - startSample_);
+    streamRestartPending_ = true;
 }
 
 double SamplePlayerNode::getPlayPosition() const {
@@ -320,6 +322,21 @@ double SamplePlayerNode::getPlayPosition() const {
 
 void SamplePlayerNode::setPlayPositionSamples(int samples) {
     playPosition_ = clampSamplePosition(samples);
+    streamRestartPending_ = true;
+}
+
+int SamplePlayerNode::getTotalSamples() const {
+    if (stream_) {
+        return static_cast<int>(stream_->getSample()->getNumFrames());
+    }
+    return sample_ ? sample_->getNumFrames() : 0;
+}
+
+int SamplePlayerNode::getNumChannels() const {
+    if (stream_) {
+        return stream_->getSample()->getNumChannels();
+    }
+    return sample_ ? sample_->getNumChannels() : 0;
 }
 
 double SamplePlayerNode::getDurationSeconds() const {
@@ -355,7 +372,8 @@ void SamplePlayerNode::printSampleInfo() const {
                 gain_, volume_);
     Logger::info("Interpolation: {}", 
                 (interpolationMode_ == InterpolationMode::NONE ? "NONE" :
-                 interpolationMode_ == InterpolationMode::LINEAR ? "LINEAR" : "CUBIC"));
+                 interpolationMode_ == InterpolationMode::LINEAR ? "LINEAR" :
+                 interpolationMode_ == InterpolationMode::CUBIC ? "CUBIC" : "SINC"));
     Logger::info("=====================================");
 }
 
@@ -363,6 +381,213 @@ void SamplePlayerNode::printSampleInfo() const {
 // Private Methods
 // =========================
 
+void SamplePlayerNode::renderBlock(choc::buffer::ChannelArrayView<float> output, int numSamples,
+                                   int effectiveStart, int effectiveEnd) {
+    const int outputChannels = static_cast<int>(output.getNumChannels());
+    const int sampleChannels = getNumChannels();
+    const float gain = gain_ * volume_;
+    const float envelope = amplitudeEnvelope_ ? static_cast<float>(amplitudeEnvelope_->getCurrentValue()) : 1.0f;
+    
+    // Positions where every interpolation tap is inside the sample, so the kernels needn't clamp
+    int tapsBefore = 0, tapsAfter = 1;
+    switch (interpolationMode_) {
+        case InterpolationMode::NONE:
+            tapsAfter = 0;
+            break;
+        case InterpolationMode::CUBIC:
+            tapsBefore = 1;
+            tapsAfter = 2;
+            break;
+        case InterpolationMode::SINC:
+            tapsAfter = AudioKernels::getSincHalfWidth(playbackRate_);
+            tapsBefore = tapsAfter - 1;
+            break;
+        case InterpolationMode::LINEAR:
+        default:
+            break;
+    }
+    const double kernelStart = tapsBefore;
+    const double kernelEnd = std::min(effectiveEnd, getTotalSamples() - tapsAfter);
+    
+    int frame = 0;
+    while (frame < numSamples) {
+        // Region and loop checks, once per run
+        if (playPosition_ >= effectiveEnd) {
+            if (loop_) {
+                handleLooping();
+            } else {
+                stop();
+                break;
+            }
+        }
+        
+        if (playPosition_ < effectiveStart || playPosition_ >= effectiveEnd) {
+            stop();
+            break;
+        }
+        
+        // Run to the region end (or loop point), or a single frame where taps need clamping.
+        // Every position in the run stays below kernelEnd, a whole step short of it at the end.
+        const bool clamped = playPosition_ < kernelStart || playPosition_ >= kernelEnd;
+        int runLength = 1;
+        if (!clamped && playbackRate_ > 0.0) {
+            double framesToEnd = std::floor((kernelEnd - playPosition_) / playbackRate_);
+            runLength = static_cast<int>(std::clamp(framesToEnd, 1.0, static_cast<double>(numSamples - frame)));
+        }
+        
+        // Replaced by the kernel's own accumulated position whenever one runs
+        double endPosition = playPosition_ + playbackRate_ * runLength;
+        for (int ch = 0; ch < outputChannels; ++ch) {
+            float* destination = output.data.channels[ch] + output.data.offset + frame;
+            
+            // Mono samples feed every output; extra outputs repeat the last sample channel
+            const int sampleChannel = std::min(ch, sampleChannels - 1);
+            if (ch > 0 && sampleChannel == std::min(ch - 1, sampleChannels - 1)) {
+                AudioKernels::copySamples(destination, output.data.channels[ch - 1] + output.data.offset + frame, runLength);
+                continue;
+            }
+            
+            if (clamped) {
+                destination[0] = getSampleInterpolated(sampleChannel, playPosition_) * gain;
+            } else {
+                endPosition = renderRun(sampleChannel, destination, runLength, gain);
+            }
+            
+            if (amplitudeEnvelope_) {
+                AudioKernels::applyGain(destination, envelope, runLength);
+            }
+        }
+        
+        playPosition_ = endPosition;
+        frame += runLength;
+    }
+}
+
+double SamplePlayerNode::renderRun(int channel, float* destination, int numFrames, float gain) const {
+    const float* source = sample_->getChannelData(channel);
+    const size_t stride = sample_->getStride();
+    
+    switch (interpolationMode_) {
+        case InterpolationMode::NONE:
+            return AudioKernels::resampleNearest(source, stride, playPosition_, playbackRate_, gain, destination, numFrames);
+        case InterpolationMode::CUBIC:
+            return AudioKernels::resampleCubic(source, stride, playPosition_, playbackRate_, gain, destination, numFrames);
+        case InterpolationMode::SINC:
+            return AudioKernels::resampleSinc(source, stride, playPosition_, playbackRate_, gain, destination, numFrames);
+        case InterpolationMode::LINEAR:
+        default:
+            return AudioKernels::resampleLinear(source, stride, playPosition_, playbackRate_, gain, destination, numFrames);
+    }
+}
+
+void SamplePlayerNode::renderStreamed(choc::buffer::ChannelArrayView<float> output, int numSamples,
+                                      int effectiveStart, int effectiveEnd) {
+    const int outputChannels = static_cast<int>(output.getNumChannels());
+    const int sampleChannels = getNumChannels();
+    
+    if (streamRestartPending_.exchange(false)) {
+        streamRegionChanged_ = false;
+        restartStream();
+    } else if (streamRegionChanged_.exchange(false) && getStreamRegion() != streamRegion_) {
+        // The ring holds frames in the old play order, so it's refilled from the playhead
+        restartStream();
+    }
+    stream_->beginBlock();
+    int missingFrames = 0;
+    
+    // Stream frames come from the head or the ring, so this goes frame by frame
+    for (int i = 0; i < numSamples; ++i) {
+        // Check if we've reached the end
+        if (playPosition_ >= effectiveEnd) {
+            if (loop_) {
+                handleLooping();
+            } else {
+                stop();
+                break;
+            }
+        }
+        
+        // Check if we're still in valid range
+        if (playPosition_ < effectiveStart || playPosition_ >= effectiveEnd) {
+            stop();
+            break;
+        }
+        
+        // The disk hasn't caught up: leave this frame silent but keep time
+        if (!stream_->isAvailable(static_cast<int64_t>(streamPosition_) + 2)) {
+            ++missingFrames;
+            playPosition_ += playbackRate_;
+            streamPosition_ += playbackRate_;
+            continue;
+        }
+        
+        // Get interpolated sample for each output channel
+        for (int ch = 0; ch < outputChannels; ++ch) {
+            // Mono samples feed every output; extra outputs repeat the last sample channel
+            float sample = getStreamedSample(std::min(ch, sampleChannels - 1));
+            
+            // Apply gain and volume
+            sample *= gain_ * volume_;
+            
+            // Apply amplitude envelope if available
+            if (amplitudeEnvelope_) {
+                sample *= static_cast<float>(amplitudeEnvelope_->getCurrentValue());
+            }
+            
+            output.getSample(static_cast<choc::buffer::ChannelCount>(ch), 
+                           static_cast<choc::buffer::FrameCount>(i)) = sample;
+        }
+        
+        // Advance playback position
+        playPosition_ += playbackRate_;
+        streamPosition_ += playbackRate_;
+    }
+    
+    stream_->endBlock(streamPosition_, playbackRate_, missingFrames);
+}
+
+void SamplePlayerNode::resetRegions() {
+    // Initialize sample region to full sample
+    startSample_ = 0;
+    endSample_ = getTotalSamples();
+    
+    // Initialize loop region to full sample
+    loopStart_ = startSample_;
+    loopEnd_ = endSample_;
+    
+    // Reset playback position
+    playPosition_ = startSample_;
+    streamRestartPending_ = true;
+    
+    // Update playback rate for current note
+    updatePlaybackRate();
+}
+
+void SamplePlayerNode::restartStream() {
+    streamRegion_ = getStreamRegion();
+    auto startFrame = static_cast<int64_t>(std::max(0.0, playPosition_));
+    streamPosition_ = playPosition_ - static_cast<double>(startFrame);
+    stream_->restart(startFrame, streamRegion_.end, streamRegion_.loop, streamRegion_.wrap);
+}
+
+SamplePlayerNode::StreamRegion SamplePlayerNode::getStreamRegion() const {
+    int effectiveEnd = (endSample_ > 0) ? std::min(endSample_, getTotalSamples()) : getTotalSamples();
+    int effectiveLoopStart = std::max(loopStart_, startSample_);
+    int effectiveLoopEnd = (loopEnd_ > 0) ? std::min(loopEnd_, endSample_) : endSample_;
+    
+    StreamRegion region;
+    region.end = effectiveEnd;
+    region.loop = loop_ && effectiveLoopEnd > effectiveLoopStart;
+    
+    // Where handleLooping lands after the end: back whole loop lengths until inside the loop
+    region.wrap = effectiveEnd;
+    if (region.loop && region.wrap >= effectiveLoopEnd) {
+        int64_t loopLength = effectiveLoopEnd - effectiveLoopStart;
+        region.wrap -= ((region.wrap - effectiveLoopEnd) / loopLength + 1) * loopLength;
+    }
+    return region;
+}
+
 void SamplePlayerNode::updatePlaybackRate() {
     if (useManualRate_) {
         playbackRate_ = manualPlaybackRate_;
@@ -389,12 +614,13 @@ float SamplePlayerNode::getSampleInterpolated(int channel, double position) cons
     
     switch (interpolationMode_) {
         case InterpolationMode::NONE:
-            return sampleBuffer_.getSample(static_cast<choc::buffer::ChannelCount>(channel), 
-                                         static_cast<choc::buffer::FrameCount>(static_cast<int>(position)));
+            return sample_->getSample(channel, static_cast<int>(position));
         case InterpolationMode::LINEAR:
             return getSampleLinear(channel, position);
         case InterpolationMode::CUBIC:
             return getSampleCubic(channel, position);
+        case InterpolationMode::SINC:
+            return getSampleSinc(channel, position);
         default:
             return getSampleLinear(channel, position);
     }
@@ -408,10 +634,8 @@ float SamplePlayerNode::getSampleLinear(int channel, double position) const {
     int index1 = clampSamplePosition(index);
     int index2 = clampSamplePosition(index + 1);
     
-    float sample1 = sampleBuffer_.getSample(static_cast<choc::buffer::ChannelCount>(channel), 
-                                          static_cast<choc::buffer::FrameCount>(index1));
-    float sample2 = sampleBuffer_.getSample(static_cast<choc::buffer::ChannelCount>(channel), 
-                                          static_cast<choc::buffer::FrameCount>(index2));
+    float sample1 = sample_->getSample(channel, index1);
+    float sample2 = sample_->getSample(channel, index2);
     
     return sample1 + static_cast<float>(fraction) * (sample2 - sample1);
 }
@@ -426,23 +650,48 @@ float SamplePlayerNode::getSampleCubic(int channel, double position) const {
     int index2 = clampSamplePosition(index + 1);
     int index3 = clampSamplePosition(index + 2);
     
-    float y0 = sampleBuffer_.getSample(static_cast<choc::buffer::ChannelCount>(channel), 
-                                     static_cast<choc::buffer::FrameCount>(index0));
-    float y1 = sampleBuffer_.getSample(static_cast<choc::buffer::ChannelCount>(channel), 
-                                     static_cast<choc::buffer::FrameCount>(index1));
-    float y2 = sampleBuffer_.getSample(static_cast<choc::buffer::ChannelCount>(channel), 
-                                     static_cast<choc::buffer::FrameCount>(index2));
-    float y3 = sampleBuffer_.getSample(static_cast<choc::buffer::ChannelCount>(channel), 
-                                     static_cast<choc::buffer::FrameCount>(index3));
+    float y0 = sample_->getSample(channel, index0);
+    float y1 = sample_->getSample(channel, index1);
+    float y2 = sample_->getSample(channel, index2);
+    float y3 = sample_->getSample(channel, index3);
     
     // Cubic interpolation (Catmull-Rom)
-    float a = static_cast<float>(fraction);
-    float a2 = a * a;
-    float a3 = a2 * a;
+    return cubicInterpolate(y0, y1, y2, y3, static_cast<float>(fraction));
+}
+
+float SamplePlayerNode::getSampleSinc(int channel, double position) const {
+    int index = static_cast<int>(position);
+    const int halfWidth = AudioKernels::getSincHalfWidth(playbackRate_);
+    
+    // Gather the taps with clamped indices, then run the kernel over them
+    float taps[AudioKernels::sincMaxTaps];
+    for (int tap = 0; tap < 2 * halfWidth; ++tap) {
+        taps[tap] = sample_->getSample(channel, clampSamplePosition(index - halfWidth + 1 + tap));
+    }
     
-    return y1 + 0.5f * a * (y2 - y0) + 
-           0.5f * a2 * (2.0f * y0 - 5.0f * y1 + 4.0f * y2 - y3) + 
-           0.5f * a3 * (-y0 + 3.0f * y1 - 3.0f * y2 + y3);
+    float sample = 0.0f;
+    AudioKernels::resampleSinc(taps, 1, (halfWidth - 1) + (position - index), playbackRate_, 1.0f, &sample, 1);
+    return sample;
+}
+
+float SamplePlayerNode::getStreamedSample(int channel) const {
+    auto index = static_cast<int64_t>(streamPosition_);
+    auto fraction = static_cast<float>(streamPosition_ - static_cast<double>(index));
+    
+    switch (interpolationMode_) {
+        case InterpolationMode::NONE:
+            return stream_->getFrame(channel, index);
+        case InterpolationMode::CUBIC:
+        case InterpolationMode::SINC:
+            return cubicInterpolate(stream_->getFrame(channel, index - 1), stream_->getFrame(channel, index),
+                                    stream_->getFrame(channel, index + 1), stream_->getFrame(channel, index + 2), fraction);
+        case InterpolationMode::LINEAR:
+        default: {
+            float sample1 = stream_->getFrame(channel, index);
+            float sample2 = stream_->getFrame(channel, index + 1);
+            return sample1 + fraction * (sample2 - sample1);
+        }
+    }
 }
 
 void SamplePlayerNode::handleLooping() {
@@ -494,6 +743,48 @@ void SamplePlayerNode::updateAnalysis(const choc::buffer::ChannelArrayView<float
     rmsLevel_ = rms * alpha + rmsLevel_ * (1.0f - alpha);
 }
 
+std::shared_ptr<AudioNode> SamplePlayerNode::clone() const {
+    if (amplitudeEnvelope_ || filterEnvelope_ || pitchEnvelope_) {
+        return nullptr;
+    }
+    
+    auto copy = std::make_shared<SamplePlayerNode>(getName());
+    copyNodeSettingsTo(*copy);
+    
+    copy->sample_ = sample_;
+    if (stream_) {
+        copy->stream_ = streamer_->createStream(stream_->getSample());
+        if (!copy->stream_) {
+            return nullptr;
+        }
+        copy->streamer_ = streamer_;
+        copy->streamRestartPending_ = true;
+    }
+    copy->sampleSampleRate_ = sampleSampleRate_;
+    copy->loadedFilePath_ = loadedFilePath_;
+    copy->manualPlaybackRate_ = manualPlaybackRate_;
+    copy->useManualRate_ = useManualRate_;
+    copy->startSample_ = startSample_;
+    copy->endSample_ = endSample_;
+    copy->loop_ = loop_;
+    copy->loopStart_ = loopStart_;
+    copy->loopEnd_ = loopEnd_;
+    copy->baseNote_ = baseNote_;
+    copy->currentNote_ = currentNote_;
+    copy->transpose_ = transpose_;
+    copy->detune_ = detune_;
+    copy->interpolationMode_ = interpolationMode_;
+    copy->gain_ = gain_;
+    copy->volume_ = volume_;
+    
+    // The play position and rate belong to the audio thread: the copy starts from the region
+    // start and works out its rate when prepared. Only the transport state, which is atomic,
+    // carries over.
+    copy->playPosition_ = startSample_;
+    copy->playbackState_ = playbackState_.load();
+    return copy;
+}
+
 double SamplePlayerNode::noteToFrequencyRatio(int noteA, int noteB) const {
     // Calculate frequency ratio between two MIDI notes
     return std::pow(2.0, (noteB - noteA) / 12.0);
@@ -2,6 +2,8 @@
 
 #include "AudioNode.h"
 #include "Logger.h"
+#include "SampleData.h"
+#include "DiskStreamer.h"
 #include "../../lib/choc/audio/choc_AudioFileFormat_WAV.h"
 #include "../../lib/choc/audio/choc_SampleBuffers.h"
 #include <string>
@@ -15,7 +17,8 @@ public:
     enum class InterpolationMode {
         NONE,           // No interpolation (nearest neighbor)
         LINEAR,         // Linear interpolation
-        CUBIC           // Cubic interpolation (higher quality)
+        CUBIC,          // Cubic interpolation (higher quality)
+        SINC            // Windowed sinc, band-limited to the playback rate (highest quality, most expensive)
     };
 
     // Playback states
@@ -34,12 +37,33 @@ public:
                         choc::buffer::ChannelArrayView<float> output,
                         double sampleRate,
                         int numSamples) override;
+    
+    // Shares the sample data. Not clonable while an envelope is attached (envelopes are shared).
+    std::shared_ptr<AudioNode> clone() const override;
 
-    // Sample loading
+    // Sample loading. Files already loaded elsewhere are shared (see SampleData::loadFile);
+    // loading shared data is O(1), the buffer overload copies once into new SampleData.
     bool loadSample(const std::string& filePath);
     bool loadSample(const choc::buffer::ChannelArrayBuffer<float>& buffer, double sampleRate = 44100.0);
+    bool loadSample(std::shared_ptr<const SampleData> sampleData);
+    // Plays a 32-bit float WAV or cache file straight from a mapping of it (see SampleData::mapFile)
+    bool loadSampleMapped(const std::string& filePath, const SampleData::MapOptions& options = {});
     void unloadSample();
-    bool hasSample() const { return sampleBuffer_.getNumFrames() > 0; }
+    bool hasSample() const { return (sample_ && sample_->getNumFrames() > 0) || stream_ != nullptr; }
+    const std::shared_ptr<const SampleData>& getSampleData() const { return sample_; } // nullptr while streaming
+
+    // Disk streaming: only the head of the file stays in memory, the rest is read ahead of
+    // the playhead by the streamer's I/O threads. Frames the disk doesn't deliver in time play
+    // as silence (see getStreamUnderrunFrames). Loading any other sample ends streaming.
+    // Streams play SINC interpolation as CUBIC, since the ring doesn't keep enough history.
+    // Region and loop changes that alter where playback ends or wraps mid-note discard the
+    // read-ahead, so the following frames drop out until the disk catches up; changes that
+    // leave the play order as it was (such as setting the same region again) cost nothing.
+    bool loadSampleStreamed(const std::string& filePath, std::shared_ptr<DiskStreamer> streamer);
+    bool loadSampleStreamed(std::shared_ptr<const StreamedSample> sample, std::shared_ptr<DiskStreamer> streamer);
+    bool isStreaming() const { return stream_ != nullptr; }
+    uint64_t getStreamUnderrunFrames() const { return stream_ ? stream_->getUnderrunFrames() : 0; }
+    bool isStreamFilledAhead(int frames) const { return !stream_ || stream_->isFilledAhead(frames); } // See DiskStream::isFilledAhead
 
     // Playback control
     void play();
@@ -61,7 +85,7 @@ public:
     int getSampleLength() const { return endSample_ - startSample_; }
 
     // Looping
-    void setLoop(bool loop) { loop_ = loop; }
+    void setLoop(bool loop) { loop_ = loop; streamRegionChanged_ = true; }
     bool isLooping() const { return loop_; }
     void setLoopStart(int loopStart);
     void setLoopEnd(int loopEnd);
@@ -83,12 +107,12 @@ public:
     int getCurrentNote() const { return currentNote_; }
 
     // Playback rate control
-    void setPlaybackRate(double rate) { manualPlaybackRate_ = rate; useManualRate_ = true; }
+    void setPlaybackRate(double rate) { manualPlaybackRate_ = rate; useManualRate_ = true; updatePlaybackRate(); }
     void clearManualPlaybackRate() { useManualRate_ = false; updatePlaybackRate(); }
     double getPlaybackRate() const { return playbackRate_; }
 
     // Interpolation
-    void setInterpolationMode(InterpolationMode mode) { interpolationMode_ = mode; }
+    void setInterpolationMode(InterpolationMode mode);
     InterpolationMode getInterpolationMode() const { return interpolationMode_; }
 
     // Volume and gain
@@ -110,8 +134,8 @@ public:
     int getPlayPositionSamples() const { return static_cast<int>(playPosition_); }
 
     // Sample info
-    int getTotalSamples() const { return static_cast<int>(sampleBuffer_.getNumFrames()); }
-    int getNumChannels() const { return static_cast<int>(sampleBuffer_.getNumChannels()); }
+    int getTotalSamples() const;
+    int getNumChannels() const;
     double getSampleRate() const { return sampleSampleRate_; }
     double getDurationSeconds() const;
 
@@ -123,11 +147,30 @@ public:
     void printSampleInfo() const;
 
 private:
-    // Sample data
-    choc::buffer::ChannelArrayBuffer<float> sampleBuffer_;
+    // Sample data (shared, never written)
+    std::shared_ptr<const SampleData> sample_;
     double sampleSampleRate_ = 44100.0;
     std::string loadedFilePath_;
 
+    // Disk streaming (sample_ is empty while a stream is loaded)
+    std::shared_ptr<DiskStreamer> streamer_;
+    std::shared_ptr<DiskStream> stream_;
+    double streamPosition_ = 0.0; // Play-order position in stream_, advanced alongside playPosition_
+    std::atomic<bool> streamRestartPending_{false}; // The playhead moved: restart from it
+    std::atomic<bool> streamRegionChanged_{false};  // Restart only if the play order changed
+
+    // Where a stream plays to and where it wraps back to, from the region and loop settings
+    struct StreamRegion {
+        int64_t end = 0;
+        int64_t wrap = 0;
+        bool loop = false;
+
+        bool operator==(const StreamRegion& other) const {
+            return end == other.end && wrap == other.wrap && loop == other.loop;
+        }
+    };
+    StreamRegion streamRegion_; // The one stream_ was last restarted with
+
     // Playback state
     std::atomic<PlaybackState> playbackState_{PlaybackState::STOPPED};
     double playPosition_ = 0.0; // Current playback position in samples
@@ -169,10 +212,18 @@ private:
     class ADSR* pitchEnvelope_ = nullptr;
 
     // Private methods
+    void renderBlock(choc::buffer::ChannelArrayView<float> output, int numSamples, int effectiveStart, int effectiveEnd);
+    double renderRun(int channel, float* destination, int numFrames, float gain) const;
+    void renderStreamed(choc::buffer::ChannelArrayView<float> output, int numSamples, int effectiveStart, int effectiveEnd);
+    void resetRegions();
+    void restartStream();
+    StreamRegion getStreamRegion() const;
+    float getStreamedSample(int channel) const;
     void updatePlaybackRate();
     float getSampleInterpolated(int channel, double position) const;
     float getSampleLinear(int channel, double position) const;
     float getSampleCubic(int channel, double position) const;
+    float getSampleSinc(int channel, double position) const;
     void handleLooping();
     void updateAnalysis(const choc::buffer::ChannelArrayView<float>& output);
     double noteToFrequencyRatio(int noteA, int noteB) const;
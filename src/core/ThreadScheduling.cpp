@@ -0,0 +1,93 @@
+#include "ThreadScheduling.h"
+#include <algorithm>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#endif
+
+namespace ThreadScheduling {
+
+namespace {
+    Outcome applyPolicy(Policy policy, int priority) {
+        if (policy == Policy::Normal) {
+            return Outcome::NotRequested;
+        }
+#if defined(__linux__) || defined(__APPLE__)
+        int osPolicy = policy == Policy::Fifo ? SCHED_FIFO : SCHED_RR;
+        sched_param param {};
+        param.sched_priority = std::clamp(priority, sched_get_priority_min(osPolicy), sched_get_priority_max(osPolicy));
+        return pthread_setschedparam(pthread_self(), osPolicy, &param) == 0 ? Outcome::Applied : Outcome::Failed;
+#else
+        (void) priority;
+        return Outcome::Failed;
+#endif
+    }
+
+    Outcome applyAffinity(const std::vector<int>& cores) {
+        if (cores.empty()) {
+            return Outcome::NotRequested;
+        }
+#if defined(__linux__)
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        for (int core : cores) {
+            if (core < 0 || core >= CPU_SETSIZE) {
+                return Outcome::Failed;
+            }
+            CPU_SET(core, &cpuSet);
+        }
+        return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0 ? Outcome::Applied : Outcome::Failed;
+#else
+        return Outcome::Failed;
+#endif
+    }
+}
+
+Result applyToCurrentThread(const Settings& settings) {
+    Result result;
+    result.scheduling = applyPolicy(settings.policy, settings.priority);
+    result.affinity = applyAffinity(settings.cores);
+    return result;
+}
+
+bool pinCurrentThreadToCore(int core) {
+#if defined(__linux__)
+    if (core < 0 || core >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(core, &cpuSet);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+#else
+    (void) core;
+    return false;
+#endif
+}
+
+bool lockProcessMemory() {
+#if defined(__linux__) || defined(__APPLE__)
+    return mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+#else
+    return false;
+#endif
+}
+
+void unlockProcessMemory() {
+#if defined(__linux__) || defined(__APPLE__)
+    munlockall();
+#endif
+}
+
+const char* toString(Outcome outcome) {
+    switch (outcome) {
+        case Outcome::NotRequested: return "not requested";
+        case Outcome::Applied:      return "applied";
+        case Outcome::Failed:       return "failed";
+    }
+    return "unknown";
+}
+
+}
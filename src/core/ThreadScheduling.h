@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+
+// Real-time scheduling, CPU affinity and memory locking for the engine's threads.
+// SCHED_FIFO/SCHED_RR need CAP_SYS_NICE or an rtprio limit (/etc/security/limits.conf),
+// and mlockall a large enough memlock limit; without them the requests fail and the
+// thread carries on with normal scheduling. Affinity is Linux only.
+namespace ThreadScheduling {
+
+enum class Policy {
+    Normal,      // Leave the OS default scheduling alone
+    Fifo,        // SCHED_FIFO
+    RoundRobin   // SCHED_RR
+};
+
+struct Settings {
+    Policy policy = Policy::Normal;
+    int priority = 0;        // For Fifo/RoundRobin; clamped to the OS range (1-99 on Linux)
+    std::vector<int> cores;  // CPUs the thread may run on; empty = leave affinity alone
+};
+
+enum class Outcome {
+    NotRequested,
+    Applied,
+    Failed
+};
+
+struct Result {
+    Outcome scheduling = Outcome::NotRequested;
+    Outcome affinity = Outcome::NotRequested;
+
+    bool succeeded() const { return scheduling != Outcome::Failed && affinity != Outcome::Failed; }
+};
+
+// Settings with a real-time policy or a core list
+inline bool isRequested(const Settings& settings) {
+    return settings.policy != Policy::Normal || !settings.cores.empty();
+}
+
+// Applies settings to the calling thread. Doesn't allocate, so it can run on the audio thread.
+Result applyToCurrentThread(const Settings& settings);
+
+// Restricts the calling thread to a single core
+bool pinCurrentThreadToCore(int core);
+
+// mlockall(MCL_CURRENT | MCL_FUTURE): keeps the process's pages resident so the audio
+// thread never waits on a page fault
+bool lockProcessMemory();
+void unlockProcessMemory();
+
+const char* toString(Outcome outcome);
+
+}
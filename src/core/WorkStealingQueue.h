@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Fixed-capacity Chase-Lev work-stealing deque of instruction indices.
+// The owning thread pushes and pops at the bottom, other threads steal from the top.
+// Nothing is allocated after construction, so every operation is safe on the audio thread.
+class WorkStealingQueue {
+public:
+    static constexpr int empty = -1;
+
+    explicit WorkStealingQueue(size_t capacity)
+        : items(std::make_unique<std::atomic<int>[]>(capacity > 0 ? capacity : 1)),
+          capacity(static_cast<int64_t>(capacity > 0 ? capacity : 1)) {}
+
+    // Only call while no other thread is using the queue
+    void reset() {
+        top.store(0, std::memory_order_relaxed);
+        bottom.store(0, std::memory_order_relaxed);
+    }
+
+    // Owner thread only
+    void push(int item) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        items[b % capacity].store(item, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_release);
+    }
+
+    // Owner thread only. Returns empty if there is nothing left.
+    int pop() {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return empty;
+        }
+
+        int item = items[b % capacity].load(std::memory_order_relaxed);
+        if (t == b) {
+            // Last item: race any thieves for it
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                item = empty;
+            }
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // Any thread. Returns empty if the queue is empty or another thread won the race.
+    int steal() {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+
+        if (t >= b) {
+            return empty;
+        }
+
+        int item = items[t % capacity].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return empty;
+        }
+        return item;
+    }
+
+private:
+    std::unique_ptr<std::atomic<int>[]> items;
+    int64_t capacity;
+    std::atomic<int64_t> top{0};
+    std::atomic<int64_t> bottom{0};
+};
@@ -0,0 +1,102 @@
+#include "src/core/AudioGraph.h"
+#include "src/core/GainNode.h"
+#include "src/core/OscillatorNode.h"
+#include "src/core/Logger.h"
+#include <cmath>
+
+// Nodes render at the graph's width, so a per-frame value (oscillator phase, gain ramp)
+// must be computed once per frame and shared by every channel, not advanced per channel.
+
+constexpr double sampleRate = 48000.0;
+constexpr int blockSize = 256;
+constexpr int numBlocks = 8;
+
+// Renders an oscillator -> gain chain into a stereo buffer, `numBlocks` blocks long
+static choc::buffer::ChannelArrayBuffer<float> render(std::shared_ptr<OscillatorNode> oscillator,
+                                                      std::shared_ptr<GainNode> gain,
+                                                      const std::function<void()>& beforeFirstBlock) {
+    AudioGraph graph;
+    graph.connectNodes(oscillator, gain);
+    graph.addOutputNode(gain);
+    graph.prepare({ sampleRate, blockSize, 2 });
+    beforeFirstBlock();
+
+    AudioGraphProcessor processor;
+    processor.setCompiledGraph(graph.getCompiledGraph());
+
+    choc::buffer::ChannelArrayBuffer<float> input(2, blockSize), block(2, blockSize);
+    choc::buffer::ChannelArrayBuffer<float> result(2, blockSize * numBlocks);
+    for (int i = 0; i < numBlocks; ++i) {
+        block.clear();
+        processor.processGraph(input.getView(), block.getView(), sampleRate, blockSize);
+        copy(result.getView().getFrameRange({ static_cast<choc::buffer::FrameCount>(i * blockSize),
+                                    static_cast<choc::buffer::FrameCount>((i + 1) * blockSize) }),
+             block);
+    }
+    return result;
+}
+
+static bool channelsMatch(const choc::buffer::ChannelArrayBuffer<float>& buffer, const char* label) {
+    for (choc::buffer::FrameCount frame = 0; frame < buffer.getNumFrames(); ++frame) {
+        if (buffer.getSample(0, frame) != buffer.getSample(1, frame)) {
+            Logger::error("{}: L != R at frame {} ({} vs {})", label, frame,
+                          buffer.getSample(0, frame), buffer.getSample(1, frame));
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    Logger::initialize();
+    Logger::info("=== Channel Routing Test ===");
+
+    // A 1 kHz saw at 48 kHz wraps every 48 frames, on both channels, in every block
+    auto saw = std::make_shared<OscillatorNode>(1000.0f, OscillatorNode::WaveType::Sawtooth, "Saw");
+    auto sawGain = std::make_shared<GainNode>(0.5f, "SawGain");
+    auto sawOutput = render(saw, sawGain, [] {});
+    if (!channelsMatch(sawOutput, "Saw")) {
+        return 1;
+    }
+
+    int lastWrap = -1, wraps = 0;
+    for (choc::buffer::FrameCount frame = 1; frame < sawOutput.getNumFrames(); ++frame) {
+        if (sawOutput.getSample(0, frame) >= sawOutput.getSample(0, frame - 1)) continue;
+        if (lastWrap >= 0) {
+            int period = static_cast<int>(frame) - lastWrap;
+            if (std::abs(period - 48) > 1) {
+                Logger::error("Saw: period {} frames at frame {}, expected 48", period, frame);
+                return 1;
+            }
+        }
+        lastWrap = static_cast<int>(frame);
+        ++wraps;
+    }
+    if (std::abs(wraps - blockSize * numBlocks / 48) > 1) {
+        Logger::error("Saw: {} cycles in {} frames, expected about {}", wraps, blockSize * numBlocks, blockSize * numBlocks / 48);
+        return 1;
+    }
+    Logger::info("Saw: L == R, {} cycles of 48 frames", wraps);
+
+    // A 10 ms gain ramp takes 480 frames on every channel, not 480 / channels
+    auto square = std::make_shared<OscillatorNode>(1000.0f, OscillatorNode::WaveType::Square, "Square");
+    auto ramp = std::make_shared<GainNode>(0.0f, "Ramp");
+    auto rampOutput = render(square, ramp, [&] { ramp->setGainSmooth(1.0f, 10.0f); });
+    if (!channelsMatch(rampOutput, "Ramp")) {
+        return 1;
+    }
+
+    // The square is +-0.8, so the output magnitude is 0.8 times the gain
+    float halfway = std::abs(rampOutput.getSample(0, 239)) / 0.8f;
+    float beforeEnd = std::abs(rampOutput.getSample(0, 470)) / 0.8f;
+    float afterEnd = std::abs(rampOutput.getSample(0, 600)) / 0.8f;
+    if (std::abs(halfway - 0.5f) > 0.01f || beforeEnd >= 0.999f || std::abs(afterEnd - 1.0f) > 1e-5f) {
+        Logger::error("Ramp: gain {} at frame 239, {} at 470, {} at 600; expected 0.5, < 1, 1",
+                      halfway, beforeEnd, afterEnd);
+        return 1;
+    }
+    Logger::info("Ramp: L == R, gain 0.5 halfway through and 1.0 after 480 frames");
+
+    Logger::info("=== Channel Routing Test Complete ===");
+    return 0;
+}
@@ -0,0 +1,197 @@
+#include "src/core/SamplePlayerNode.h"
+#include "src/core/DiskStreamer.h"
+#include "src/core/Logger.h"
+#include "lib/choc/audio/choc_AudioFileFormat_WAV.h"
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <functional>
+#include <thread>
+
+// A streamed sample must play exactly like the same file loaded into memory. The streamer
+// here has a small head and ring, so restarts, loop wraps and rate changes all have to be
+// served from the ring rather than the preloaded head.
+
+constexpr double sampleRate = 48000.0;
+constexpr int blockSize = 256;
+constexpr int numFileFrames = 300000;
+
+// Stereo float WAV of two unrelated tones, so a frame read from the wrong place shows up
+static bool writeTestFile(const std::string& path) {
+    choc::audio::AudioFileProperties properties;
+    properties.sampleRate = sampleRate;
+    properties.numChannels = 2;
+    properties.bitDepth = choc::audio::BitDepth::float32;
+
+    choc::audio::WAVAudioFileFormat<true> wavFormat;
+    auto writer = wavFormat.createWriter(path, properties);
+    if (!writer) {
+        return false;
+    }
+
+    choc::buffer::ChannelArrayBuffer<float> frames(2, numFileFrames);
+    const double pi = 3.14159265358979323846;
+    for (choc::buffer::FrameCount frame = 0; frame < numFileFrames; ++frame) {
+        frames.getSample(0, frame) = static_cast<float>(0.5 * std::sin(2.0 * pi * 441.0 * frame / sampleRate));
+        frames.getSample(1, frame) = static_cast<float>(0.3 * std::sin(2.0 * pi * 1234.5 * frame / sampleRate));
+    }
+    return writer->appendFrames(frames.getView()) && writer->flush();
+}
+
+// Waits until the I/O threads have read what the streamed player's next block plays: the
+// block at its current rate plus the interpolation window. A block right after a restart is
+// played from the head instead. Gives up after a few seconds, so a stuck stream under-runs.
+static void waitForStream(const SamplePlayerNode& streamed) {
+    int frames = static_cast<int>(std::ceil(streamed.getPlaybackRate() * blockSize)) + 8;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!streamed.isStreamFilledAhead(frames) && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+// Renders both players block by block, waiting for the I/O threads to catch up before each
+// block, and counts output frames that differ
+static int compareBlocks(SamplePlayerNode& memory, SamplePlayerNode& streamed, int numBlocks,
+                         const std::function<void(int)>& beforeBlock = {}) {
+    choc::buffer::ChannelArrayBuffer<float> input(2, blockSize), memoryOutput(2, blockSize), streamedOutput(2, blockSize);
+    int mismatches = 0;
+    for (int block = 0; block < numBlocks; ++block) {
+        if (beforeBlock) {
+            beforeBlock(block);
+        }
+        waitForStream(streamed);
+        memoryOutput.clear();
+        streamedOutput.clear();
+        memory.processCallback(input.getView(), memoryOutput.getView(), sampleRate, blockSize);
+        streamed.processCallback(input.getView(), streamedOutput.getView(), sampleRate, blockSize);
+
+        for (choc::buffer::FrameCount frame = 0; frame < blockSize; ++frame) {
+            for (choc::buffer::ChannelCount channel = 0; channel < 2; ++channel) {
+                if (std::abs(memoryOutput.getSample(channel, frame) - streamedOutput.getSample(channel, frame)) > 1e-5f) {
+                    ++mismatches;
+                    break;
+                }
+            }
+        }
+    }
+    return mismatches;
+}
+
+// Runs `setup` on both players, then compares `numBlocks` of their output. With
+// `allowUnderruns`, frames the disk couldn't deliver may differ (they play as silence), but
+// nothing else may.
+static bool checkScenario(const char* name, SamplePlayerNode& memory, SamplePlayerNode& streamed, int numBlocks,
+                          const std::function<void(SamplePlayerNode&)>& setup,
+                          const std::function<void(SamplePlayerNode&, int)>& beforeBlock = {},
+                          bool allowUnderruns = false) {
+    setup(memory);
+    setup(streamed);
+
+    uint64_t underrunsBefore = streamed.getStreamUnderrunFrames();
+    int mismatches = compareBlocks(memory, streamed, numBlocks, [&](int block) {
+        if (beforeBlock) {
+            beforeBlock(memory, block);
+            beforeBlock(streamed, block);
+        }
+    });
+    uint64_t underruns = streamed.getStreamUnderrunFrames() - underrunsBefore;
+
+    if (allowUnderruns ? static_cast<uint64_t>(mismatches) > underruns : (mismatches > 0 || underruns > 0)) {
+        Logger::error("{}: {} frames differ from in-memory playback, {} under-run frames", name, mismatches, underruns);
+        return false;
+    }
+    Logger::info("{}: {} blocks identical to in-memory playback ({} under-run frames)", name, numBlocks, underruns);
+    return true;
+}
+
+int main() {
+    Logger::initialize();
+    Logger::info("=== Disk Streaming Test ===");
+
+    auto path = (std::filesystem::temp_directory_path() / "test_disk_streaming.wav").string();
+    if (!writeTestFile(path)) {
+        Logger::error("Could not write {}", path);
+        return 1;
+    }
+
+    DiskStreamer::Settings settings;
+    settings.headFrames = 4096;
+    settings.ringFrames = 16384;
+    settings.readChunkFrames = 2048;
+    auto streamer = std::make_shared<DiskStreamer>(settings);
+
+    SamplePlayerNode memory("Memory"), streamed("Streamed");
+    if (!memory.loadSample(path) || !streamed.loadSampleStreamed(path, streamer)) {
+        Logger::error("Could not load {}", path);
+        return 1;
+    }
+    for (auto* player : { &memory, &streamed }) {
+        player->prepare({ sampleRate, blockSize, 2 });
+        player->setInterpolationMode(SamplePlayerNode::InterpolationMode::CUBIC);
+    }
+
+    bool passed = true;
+
+    // Straight through, pitched up, well past the head
+    passed &= checkScenario("Pitched playback", memory, streamed, 600,
+        [](SamplePlayerNode& player) { player.trigger(67); });
+
+    // Retriggers restart the stream away from what the ring holds; the head covers them
+    passed &= checkScenario("Retriggers", memory, streamed, 600,
+        [](SamplePlayerNode& player) { player.trigger(60); },
+        [](SamplePlayerNode& player, int block) {
+            if (block % 100 == 99) player.trigger(60 + block / 100);
+        });
+
+    // A jump past the head can't be served until the disk catches up: those frames play as
+    // silence, and everything after them must match again
+    passed &= checkScenario("Jumps", memory, streamed, 600,
+        [](SamplePlayerNode& player) { player.trigger(62); },
+        [](SamplePlayerNode& player, int block) {
+            if (block % 150 == 74) player.setPlayPositionSamples(100000 + block * 300);
+        },
+        true);
+
+    // A loop inside a region, with the loop end before the region end, over many wraps. The
+    // rate lands on whole frames: at the seam a stream interpolates across it while memory
+    // playback reads the source frames either side of the wrap point.
+    passed &= checkScenario("Looping", memory, streamed, 1500,
+        [](SamplePlayerNode& player) {
+            player.setSampleRegion(1000, 250000);
+            player.setLoop(true);
+            player.setLoopRegion(200000, 240000);
+            player.trigger(72);
+        });
+
+    // Setting the region and loop again without changing them must not drop the read-ahead
+    passed &= checkScenario("Unchanged region", memory, streamed, 600,
+        [](SamplePlayerNode& player) { player.trigger(64); },
+        [](SamplePlayerNode& player, int block) {
+            if (block % 50 == 49) {
+                player.setLoop(true);
+                player.setSampleRegion(1000, 250000);
+                player.setLoopRegion(200000, 240000);
+            }
+        });
+
+    // Rate changes mid-note change how fast the ring drains, but not its contents
+    passed &= checkScenario("Rate changes", memory, streamed, 1000,
+        [](SamplePlayerNode& player) {
+            player.setLoop(false);
+            player.setSampleRegion(0, 0);
+            player.trigger(60);
+        },
+        [](SamplePlayerNode& player, int block) {
+            if (block % 100 == 0) player.setPlaybackRate(0.5 + (block / 100 % 4) * 0.5);
+        });
+
+    std::filesystem::remove(path);
+    if (!passed) {
+        return 1;
+    }
+
+    auto stats = streamer->getStats();
+    Logger::info("{} frames read from disk, {} under-runs", stats.framesRead, stats.underrunFrames);
+    Logger::info("=== Disk Streaming Test Complete ===");
+    return 0;
+}
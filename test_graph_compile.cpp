@@ -0,0 +1,276 @@
+#include "src/core/AudioGraph.h"
+#include "src/core/GainNode.h"
+#include "src/core/OscillatorNode.h"
+#include "src/core/Logger.h"
+#include <chrono>
+#include <random>
+
+// Pass-through node with configurable ports, width and latency, to exercise every compiler path
+class TestNode : public AudioNode {
+public:
+    TestNode(const std::string& name, int numPorts, int channels, int latency)
+        : AudioNode(name), numPorts(numPorts), latency(latency) {
+        setNumOutputChannels(channels);
+    }
+
+    void processCallback(choc::buffer::ChannelArrayView<const float>,
+                         choc::buffer::ChannelArrayView<float> outputBuffers,
+                         double, int) override {
+        outputBuffers.clear();
+    }
+
+    int getNumInputPorts() const override { return numPorts; }
+    int getLatencySamples() const override { return latency; }
+
+private:
+    int numPorts;
+    int latency;
+};
+
+// Passes its input straight through but reports latency, so the graph delays parallel paths
+class LookaheadNode : public AudioNode {
+public:
+    LookaheadNode(const std::string& name, int latency) : AudioNode(name), latency(latency) {}
+
+    void processCallback(choc::buffer::ChannelArrayView<const float> inputBuffers,
+                         choc::buffer::ChannelArrayView<float> outputBuffers,
+                         double, int) override {
+        copyBuffer(inputBuffers, outputBuffers);
+    }
+
+    int getLatencySamples() const override { return latency; }
+
+private:
+    int latency;
+};
+
+static bool sameInstruction(const AudioGraph::ProcessingInstruction& a, const AudioGraph::ProcessingInstruction& b) {
+    if (a.node != b.node || a.inputBufferIndices != b.inputBufferIndices || a.inputChannelCounts != b.inputChannelCounts
+        || a.outputBufferIndex != b.outputBufferIndex || a.numOutputChannels != b.numOutputChannels
+        || a.processInPlace != b.processInPlace || a.dependents != b.dependents
+        || a.numDependencies != b.numDependencies || a.inputSums.size() != b.inputSums.size()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < a.inputSums.size(); ++i) {
+        const auto& sumA = a.inputSums[i];
+        const auto& sumB = b.inputSums[i];
+        if (sumA.bufferIndex != sumB.bufferIndex || sumA.numChannels != sumB.numChannels
+            || sumA.sourceBufferIndices != sumB.sourceBufferIndices || sumA.sourceChannelCounts != sumB.sourceChannelCounts
+            || sumA.sourceNodes != sumB.sourceNodes || sumA.sourceDelaySamples != sumB.sourceDelaySamples) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool sameGraph(const AudioGraph::CompiledGraph& a, const AudioGraph::CompiledGraph& b) {
+    if (a.instructions.size() != b.instructions.size() || a.outputNodes != b.outputNodes
+        || a.numTempBuffers != b.numTempBuffers || a.tempBufferChannels != b.tempBufferChannels
+        || a.rootInstructions != b.rootInstructions || a.outputBufferIndices != b.outputBufferIndices
+        || a.outputChannelCounts != b.outputChannelCounts || a.latencySamples != b.latencySamples
+        || a.outputDelaySamples != b.outputDelaySamples) {
+        return false;
+    }
+
+    for (size_t i = 0; i < a.instructions.size(); ++i) {
+        if (!sameInstruction(a.instructions[i], b.instructions[i])) return false;
+    }
+    return true;
+}
+
+static bool compareCompiles(AudioGraph& graph, int step) {
+    auto incremental = graph.getCompiledGraph();
+
+    graph.setIncrementalCompilation(false);
+    auto full = graph.getCompiledGraph();
+    graph.setIncrementalCompilation(true);
+
+    if (!sameGraph(*incremental, *full)) {
+        Logger::error("Step {}: incremental compile differs from full compile", step);
+        return false;
+    }
+    return true;
+}
+
+// The compensation delays belong to the processor, so recompiling for an unrelated edit
+// mid-stream must not drop the audio in flight on a delayed path
+static bool delaysSurviveRecompile() {
+    const int blockSize = 256;
+    choc::buffer::ChannelArrayBuffer<float> renders[2] = { { 2, blockSize * 8 }, { 2, blockSize * 8 } };
+
+    for (int edited = 0; edited < 2; ++edited) {
+        // Tone -> lookahead (300 samples) and tone -> dry, both into a mix: the dry path is delayed
+        AudioGraph graph;
+        auto tone = std::make_shared<OscillatorNode>(440.0f, OscillatorNode::WaveType::Sawtooth, "Tone");
+        auto lookahead = std::make_shared<LookaheadNode>("Lookahead", 300);
+        auto dry = std::make_shared<GainNode>(0.5f, "Dry");
+        auto mix = std::make_shared<GainNode>(1.0f, "Mix");
+        graph.connectNodes(tone, lookahead);
+        graph.connectNodes(tone, dry);
+        graph.connectNodes(lookahead, mix);
+        graph.connectNodes(dry, mix);
+        graph.addOutputNode(mix);
+        graph.prepare({ 48000.0, blockSize, 2 });
+
+        AudioGraphProcessor processor;
+        processor.setCompiledGraph(graph.getCompiledGraph());
+
+        choc::buffer::ChannelArrayBuffer<float> input(2, blockSize), block(2, blockSize);
+        for (int i = 0; i < 8; ++i) {
+            if (edited && i == 4) {
+                graph.addNode(std::make_shared<GainNode>(1.0f, "Unrelated"));
+                processor.setCompiledGraph(graph.getCompiledGraph());
+            }
+            processor.processGraph(input.getView(), block.getView(), 48000.0, blockSize);
+            copy(renders[edited].getView().getFrameRange({ static_cast<choc::buffer::FrameCount>(i * blockSize),
+                                                           static_cast<choc::buffer::FrameCount>((i + 1) * blockSize) }),
+                 block);
+        }
+    }
+
+    for (choc::buffer::FrameCount frame = 0; frame < renders[0].getNumFrames(); ++frame) {
+        if (renders[0].getSample(0, frame) != renders[1].getSample(0, frame)) {
+            Logger::error("Recompile changed the output at frame {}: compensation delay lost its contents", frame);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    Logger::initialize();
+    Logger::info("=== Incremental Graph Compilation Test ===");
+
+    for (bool parallel : { false, true }) {
+        AudioGraph graph;
+        graph.setParallelProcessing(parallel);
+        graph.prepare({ 48000.0, 256, 2 });
+
+        std::mt19937 random(1234);
+        std::vector<std::shared_ptr<AudioNode>> pool;
+        for (int i = 0; i < 40; ++i) {
+            switch (i % 4) {
+                case 0: pool.push_back(std::make_shared<GainNode>(0.5f, "Gain" + std::to_string(i))); break;
+                case 1: pool.push_back(std::make_shared<TestNode>("Mono" + std::to_string(i), 1, 1, 0)); break;
+                case 2: pool.push_back(std::make_shared<TestNode>("Sidechain" + std::to_string(i), 2, 2, 0)); break;
+                default: pool.push_back(std::make_shared<TestNode>("Lookahead" + std::to_string(i), 1, 0, 64)); break;
+            }
+        }
+
+        auto pick = [&]() { return pool[random() % pool.size()]; };
+
+        for (int step = 0; step < 2000; ++step) {
+            auto a = pick();
+            auto b = pick();
+
+            switch (random() % 9) {
+                case 0: graph.addNode(a); break;
+                case 1: graph.removeNode(a); break;
+                case 2: graph.disconnectNodes(a, b); break;
+                case 3: graph.addOutputNode(a); break;
+                case 4: graph.removeOutputNode(a); break;
+                case 5: graph.performGraphModification([] {}); break;
+                default: graph.connectNodes(a, b, static_cast<int>(random() % b->getNumInputPorts())); break;
+            }
+
+            // Batch a few edits between compiles, as a routing script would
+            if (step % 3 == 0 && !compareCompiles(graph, step)) {
+                return 1;
+            }
+        }
+
+        // A feedback loop must be refused rather than silencing the graph
+        auto first = std::make_shared<GainNode>(1.0f, "LoopA");
+        auto second = std::make_shared<GainNode>(1.0f, "LoopB");
+        graph.connectNodes(first, second);
+        if (graph.connectNodes(second, first)) {
+            Logger::error("Feedback loop connection was accepted");
+            return 1;
+        }
+        graph.addOutputNode(second);
+
+        auto compiled = graph.getCompiledGraph();
+        if (compiled->instructions.empty() || !compareCompiles(graph, -1)) {
+            Logger::error("Feedback loop was not rejected");
+            return 1;
+        }
+
+        Logger::info("{} mode: {} nodes, {} instructions, {} buffers, identical to full compile",
+                     parallel ? "Parallel" : "Serial", graph.getNodeCount(),
+                     compiled->instructions.size(), compiled->numTempBuffers);
+    }
+
+    // A whole session staged as one transaction compiles once and matches a full compile
+    AudioGraph session;
+    session.prepare({ 48000.0, 256, 2 });
+    
+    auto transaction = session.beginTransaction();
+    auto master = std::make_shared<GainNode>(1.0f, "Master");
+    for (int track = 0; track < 200; ++track) {
+        auto source = std::make_shared<TestNode>("Track" + std::to_string(track), 1, 0, track % 5 == 0 ? 32 : 0);
+        auto fader = std::make_shared<GainNode>(0.8f, "Fader" + std::to_string(track));
+        transaction.connectNodes(source, fader);
+        transaction.connectNodes(fader, master);
+    }
+    transaction.addOutputNode(master);
+    
+    if (!session.commitTransaction(transaction) || !compareCompiles(session, -2)) {
+        Logger::error("Session transaction failed");
+        return 1;
+    }
+    
+    // A batch closing a feedback loop is rejected as a whole and leaves the compiled graph alone
+    auto beforeLoop = session.getCompiledGraph();
+    auto loopTransaction = session.beginTransaction();
+    auto extra = std::make_shared<GainNode>(1.0f, "Extra");
+    loopTransaction.connectNodes(master, extra);
+    loopTransaction.connectNodes(extra, master);
+    if (session.commitTransaction(loopTransaction) || session.getNodeCount() != 401) {
+        Logger::error("Feedback loop transaction was not rejected");
+        return 1;
+    }
+    if (session.needsRecompile() || session.getCompiledGraph() != beforeLoop) {
+        Logger::error("Rejected transaction marked the graph for recompiling");
+        return 1;
+    }
+    session.markDirty();
+    if (!sameGraph(*session.getCompiledGraph(), *beforeLoop) || !compareCompiles(session, -3)) {
+        Logger::error("Rejected transaction changed the compiled graph");
+        return 1;
+    }
+    Logger::info("Session transaction: {} nodes, latency {} samples",
+                 session.getNodeCount(), session.getCompiledGraph()->latencySamples);
+
+    // What a single routing edit costs on the session. An insert after the master leaves the
+    // schedule and buffers of everything before it as they were.
+    for (bool incremental : { true, false }) {
+        session.setIncrementalCompilation(incremental);
+        session.getCompiledGraph();
+
+        const int numEdits = 200;
+        auto insert = std::make_shared<GainNode>(1.0f, "Insert");
+        auto start = std::chrono::steady_clock::now();
+        for (int edit = 0; edit < numEdits; ++edit) {
+            if (edit % 2 == 0) {
+                session.connectNodes(master, insert);
+            } else {
+                session.disconnectNodes(master, insert);
+            }
+            session.getCompiledGraph();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        session.removeNode(insert);
+        Logger::info("{} compile: {:.1f} us per edit on {} nodes", incremental ? "Incremental" : "Full",
+                     std::chrono::duration<double, std::micro>(elapsed).count() / numEdits, session.getNodeCount());
+    }
+    session.setIncrementalCompilation(true);
+
+    if (!delaysSurviveRecompile()) {
+        return 1;
+    }
+    Logger::info("Recompiling mid-stream keeps the audio in flight in compensation delays");
+
+    Logger::info("=== Incremental Graph Compilation Test Complete ===");
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include "src/core/AudioGraph.h"
+#include "src/core/AudioRecorder.h"
+#include "src/core/GainNode.h"
+#include "src/core/OscillatorNode.h"
+#include "src/core/Logger.h"
+#include <cmath>
+#include <filesystem>
+
+// The graph skips nodes whose inputs have been silent for longer than their tail. Nodes with
+// side effects or time-keeping state must keep running through silence: a recorder has to
+// record the silent stretch, and a gain ramp started during it has to finish on time.
+
+constexpr double sampleRate = 48000.0;
+constexpr int blockSize = 256;
+
+// Passes its input through and counts the blocks it was given, with a fixed tail
+class CountingNode : public AudioNode {
+public:
+    CountingNode(const std::string& name, int tailSamples) : AudioNode(name), tailSamples(tailSamples) {}
+
+    void processCallback(choc::buffer::ChannelArrayView<const float> inputBuffers,
+                         choc::buffer::ChannelArrayView<float> outputBuffers,
+                         double, int) override {
+        copyBuffer(inputBuffers, outputBuffers);
+        ++blocksProcessed;
+    }
+
+    int getTailSamples() const override { return tailSamples; }
+
+    int blocksProcessed = 0;
+
+private:
+    int tailSamples;
+};
+
+int main() {
+    Logger::initialize();
+    Logger::info("=== Silence Skipping Test ===");
+
+    // Oscillator -> mute -> fade -> recorder. Muting makes everything downstream see silence.
+    // The mute also feeds two nodes that can sleep: one with no tail and one with a 600-frame tail.
+    auto oscillator = std::make_shared<OscillatorNode>(1000.0f, OscillatorNode::WaveType::Square, "Tone");
+    auto mute = std::make_shared<GainNode>(1.0f, "Mute");
+    auto fade = std::make_shared<GainNode>(1.0f, "Fade");
+    auto recorder = std::make_shared<AudioRecorder>("", "Recorder");
+    auto noTail = std::make_shared<CountingNode>("NoTail", 0);
+    auto ringing = std::make_shared<CountingNode>("Ringing", 600);
+
+    AudioGraph graph;
+    graph.connectNodes(oscillator, mute);
+    graph.connectNodes(mute, fade);
+    graph.connectNodes(fade, recorder);
+    graph.connectNodes(mute, noTail);
+    graph.connectNodes(mute, ringing);
+    graph.addOutputNode(recorder);
+    graph.prepare({ sampleRate, blockSize, 2 });
+
+    AudioGraphProcessor processor;
+    processor.setCompiledGraph(graph.getCompiledGraph());
+
+    auto recordingPath = (std::filesystem::temp_directory_path() / "test_silence_skipping.wav").string();
+    recorder->startRecording(recordingPath);
+
+    choc::buffer::ChannelArrayBuffer<float> input(2, blockSize), output(2, blockSize);
+    auto renderBlocks = [&](int numBlocks) {
+        for (int i = 0; i < numBlocks; ++i) {
+            processor.processGraph(input.getView(), output.getView(), sampleRate, blockSize);
+        }
+    };
+
+    // 4 blocks of tone, then 20 muted; halfway through the gap, fade out and back in over 10 ms
+    renderBlocks(4);
+    mute->setGainImmediate(0.0f);
+    renderBlocks(10);
+    fade->setGainImmediate(0.0f);
+    fade->setGainSmooth(1.0f, 10.0f);
+    renderBlocks(10);
+
+    // Silent from the first muted block: the tail-less node slept straight away, the other ran
+    // until its input had been silent for 600 frames (3 blocks)
+    if (noTail->blocksProcessed != 4 || ringing->blocksProcessed != 7) {
+        Logger::error("Through the gap: no-tail node ran {} blocks, expected 4; ringing node ran {} blocks, expected 7",
+                      noTail->blocksProcessed, ringing->blocksProcessed);
+        return 1;
+    }
+
+    mute->setGainImmediate(1.0f);
+    renderBlocks(4);
+    recorder->stopRecording();
+    std::filesystem::remove(recordingPath);
+
+    // Both wake up as soon as the tone is back
+    if (noTail->blocksProcessed != 8 || ringing->blocksProcessed != 11) {
+        Logger::error("After the gap: no-tail node ran {} blocks, expected 8; ringing node ran {} blocks, expected 11",
+                      noTail->blocksProcessed, ringing->blocksProcessed);
+        return 1;
+    }
+
+    // Every block is recorded, silent ones included
+    const size_t expectedFrames = 28 * blockSize;
+    auto recorded = recorder->getRecordedData();
+    if (recorded.size() != expectedFrames || recorder->getTotalSamplesRecorded() != expectedFrames) {
+        Logger::error("Recorded {} frames ({} pushed), expected {}", recorded.size(),
+                      recorder->getTotalSamplesRecorded(), expectedFrames);
+        return 1;
+    }
+
+    for (size_t frame = 0; frame < recorded.size(); ++frame) {
+        bool inGap = frame >= 4 * blockSize && frame < 24 * blockSize;
+        if (inGap != (recorded[frame] == 0.0f)) {
+            Logger::error("Frame {}: recorded {}, expected {}", frame, recorded[frame], inGap ? "silence" : "tone");
+            return 1;
+        }
+    }
+
+    // The 480-frame ramp ran during the 2560 silent frames after it started, so the tone comes
+    // back at full level (the square is +-0.8)
+    float levelAfterGap = std::abs(recorded[24 * blockSize]);
+    if (std::abs(levelAfterGap - 0.8f) > 1e-5f) {
+        Logger::error("Level after the gap is {}, expected 0.8: the fade stalled while its input was silent", levelAfterGap);
+        return 1;
+    }
+
+    Logger::info("Recorded {} frames across a {}-frame silent gap; fade finished during the gap",
+                 recorded.size(), 20 * blockSize);
+    Logger::info("Nodes downstream slept through the gap after their tails: {} and {} of 28 blocks processed",
+                 noTail->blocksProcessed, ringing->blocksProcessed);
+    Logger::info("=== Silence Skipping Test Complete ===");
+    return 0;
+}